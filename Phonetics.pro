@@ -2,6 +2,7 @@ QMAKE_MACOSX_DEPLOYMENT_TARGET = 14.0
 
 QT       += core gui multimedia
 QT       += charts
+QT       += concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -12,24 +13,74 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    analysiscache.cpp \
+    analysispipeline.cpp \
     audio.cpp \
+    dtwaligner.cpp \
+    formanttracker.cpp \
+    liverecorder.cpp \
+    liverecordingview.cpp \
+    ltas.cpp \
     main.cpp \
     mainwindow.cpp \
+    memorybudget.cpp \
+    mfccextractor.cpp \
+    multiresolutionstft.cpp \
+    offsetestimator.cpp \
+    pcmcache.cpp \
+    peakpyramid.cpp \
+    performancehud.cpp \
+    pitchtracker.cpp \
+    resampler.cpp \
     segmentgraph.cpp \
+    waveformreducer.cpp \
     waveformsegments.cpp \
     wavfile.cpp \
     wavform.cpp \
+    workerpool.cpp \
+    workspace.cpp \
+    spectralslice.cpp \
+    spectrogramrenderer.cpp \
     spectrograph.cpp \
+    stft.cpp \
+    syllablesegmenter.cpp \
+    tracer.cpp \
     zoom.cpp
 
 HEADERS += \
+    analysiscache.h \
+    analysispipeline.h \
     audio.h \
+    dtwaligner.h \
+    formanttracker.h \
+    liverecorder.h \
+    liverecordingview.h \
+    ltas.h \
     mainwindow.h \
+    memorybudget.h \
+    mfccextractor.h \
+    multiresolutionstft.h \
+    offsetestimator.h \
+    pcmcache.h \
+    peakpyramid.h \
+    performancehud.h \
+    pitchtracker.h \
+    resampler.h \
     segmentgraph.h \
+    waveformreducer.h \
     waveformsegments.h \
     wavfile.h \
     wavform.h \
+    spectralframes.h \
+    spectralslice.h \
+    spectrogramrenderer.h \
     spectrograph.h \
+    spscringbuffer.h \
+    stft.h \
+    syllablesegmenter.h \
+    tracer.h \
+    workerpool.h \
+    workspace.h \
     zoom.h
 
 RESOURCES += resources.qrc
@@ -0,0 +1,224 @@
+#include "analysiscache.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <QDebug>
+#include <atomic>
+#include <cstring>
+#include "pcmcache.h"
+#include "tracer.h"
+
+/*
+ * File: analysiscache.cpp
+ * Description:
+ *  This source file implements the 'AnalysisCache'. 'store()' lays the arrays out one after the other behind the
+ *  header and records their offsets in it, 'load()' maps the entry, checks every offset against the file size and
+ *  copies the arrays into the structs the app uses.
+ */
+
+#define CACHE_VERSION 1
+#define CACHE_MAGIC Q_UINT64_C(0x48434143594c4e41) // "ANLYCACH" read as a little-endian quint64
+#define HEADER_WORDS 32
+#define DEFAULT_CACHE_BYTES (512LL * 1024 * 1024)
+
+// words of the header
+enum HeaderWord {
+    Magic, Version,
+    SpectrumWindow, SpectrumHop, SpectrumRate, SpectrumSamples, SpectrumFrames, SpectrumBins, SpectrumOffset,
+    PitchHop, PitchFrameLength, PitchRate, PitchSamples, PitchCount, PitchOffset,
+    FormantHop, FormantFrameLength, FormantRate, FormantSamples, FormantCount, FormantOffset,
+    MfccCoefficients, MfccBands, MfccWindow, MfccHop, MfccRate, MfccSamples, MfccCount, MfccOffset, LogMelCount, LogMelOffset
+};
+
+static std::atomic<qint64> budget{DEFAULT_CACHE_BYTES};
+static QMutex directoryMutex; // one store and eviction at a time
+
+QString AnalysisCache::directory() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/analysis";
+}
+
+void AnalysisCache::setMaximumBytes(qint64 bytes) {
+    budget = bytes;
+}
+
+qint64 AnalysisCache::maximumBytes() {
+    return budget;
+}
+
+QString AnalysisCache::key(const QString &source, int windowSize, int hopSize, const QString &windowType, int sampleRate) {
+    QString hash = PcmCache::contentHash(source);
+    if (hash.isEmpty()) return QString();
+    return QString("%1-w%2-h%3-%4-r%5-v%6").arg(hash).arg(windowSize).arg(hopSize).arg(windowType).arg(sampleRate).arg(CACHE_VERSION);
+}
+
+// appends float32 arrays at 8 byte aligned offsets
+class EntryWriter
+{
+public:
+    QByteArray data{HEADER_WORDS * 8, '\0'};
+
+    void set(HeaderWord word, quint64 value) {
+        qToLittleEndian<quint64>(value, data.data() + word * 8);
+    }
+    template<typename T>
+    quint64 append(const T *values, qsizetype count) {
+        quint64 offset = data.size();
+        data.resize(offset + count * sizeof(float));
+        uchar *out = reinterpret_cast<uchar*>(data.data() + offset);
+        for (qsizetype i = 0; i < count; ++i, out += sizeof(float)) qToLittleEndian<float>((float) values[i], out);
+        return offset;
+    }
+    quint64 align() {
+        data.resize((data.size() + 7) / 8 * 8);
+        return data.size();
+    }
+};
+
+bool AnalysisCache::store(const QString &key, const AnalysisResults &results) {
+    TRACE_SCOPE("AnalysisCache::store");
+    if (key.isEmpty()) return false;
+
+    EntryWriter entry;
+    entry.set(Magic, CACHE_MAGIC);
+    entry.set(Version, CACHE_VERSION);
+
+    const SpectralFrames &frames = results.frames;
+    int bins = frames.magnitudes.isEmpty() ? 0 : frames.magnitudes.first().size();
+    entry.set(SpectrumWindow, frames.windowSize);
+    entry.set(SpectrumHop, frames.hopSize);
+    entry.set(SpectrumRate, frames.sampleRate);
+    entry.set(SpectrumSamples, frames.numSamples);
+    entry.set(SpectrumFrames, frames.magnitudes.size());
+    entry.set(SpectrumBins, bins);
+    entry.set(SpectrumOffset, entry.align());
+    for (const QVector<double> &frame : frames.magnitudes) {
+        if (frame.size() != bins) return false; // not a matrix
+        entry.append(frame.constData(), bins); // rows back to back
+    }
+
+    const PitchContour &pitch = results.pitch;
+    entry.set(PitchHop, pitch.hopSize);
+    entry.set(PitchFrameLength, pitch.frameLength);
+    entry.set(PitchRate, pitch.sampleRate);
+    entry.set(PitchSamples, pitch.numSamples);
+    entry.set(PitchCount, pitch.f0.size());
+    entry.align();
+    entry.set(PitchOffset, entry.append(pitch.f0.constData(), pitch.f0.size()));
+
+    const FormantTracks &formants = results.formants;
+    entry.set(FormantHop, formants.hopSize);
+    entry.set(FormantFrameLength, formants.frameLength);
+    entry.set(FormantRate, formants.sampleRate);
+    entry.set(FormantSamples, formants.numSamples);
+    entry.set(FormantCount, formants.frequencies.size());
+    entry.align();
+    entry.set(FormantOffset, entry.append(formants.frequencies.constData(), formants.frequencies.size()));
+
+    const MfccFeatures &features = results.features;
+    entry.set(MfccCoefficients, features.coefficientCount);
+    entry.set(MfccBands, features.melBandCount);
+    entry.set(MfccWindow, features.windowSize);
+    entry.set(MfccHop, features.hopSize);
+    entry.set(MfccRate, features.sampleRate);
+    entry.set(MfccSamples, features.numSamples);
+    entry.set(MfccCount, features.mfcc.size());
+    entry.align();
+    entry.set(MfccOffset, entry.append(features.mfcc.constData(), features.mfcc.size()));
+    entry.set(LogMelCount, features.logMel.size());
+    entry.align();
+    entry.set(LogMelOffset, entry.append(features.logMel.constData(), features.logMel.size()));
+
+    QMutexLocker locker(&directoryMutex);
+    QDir().mkpath(directory());
+    QSaveFile file(directory() + "/" + key + ".bin");
+    if (!file.open(QIODevice::WriteOnly) || file.write(entry.data) != entry.data.size() || !file.commit()) {
+        qWarning() << "Cache Error: could not write analysis cache entry" << key;
+        return false;
+    }
+    evict();
+    return true;
+}
+
+bool AnalysisCache::load(const QString &key, AnalysisResults &results) {
+    TRACE_SCOPE("AnalysisCache::load");
+    if (key.isEmpty()) return false;
+    QFile file(directory() + "/" + key + ".bin");
+    if (!file.open(QIODevice::ReadOnly) || file.size() < HEADER_WORDS * 8) return false;
+    const uchar *map = file.map(0, file.size());
+    if (!map) return false;
+
+    qint64 size = file.size();
+    auto word = [&](HeaderWord index) { return qFromLittleEndian<quint64>(map + index * 8); };
+    if (word(Magic) != CACHE_MAGIC || word(Version) != CACHE_VERSION) return false;
+
+    // every array has to lie inside the file, checked without a product or sum that a broken header could overflow
+    auto fits = [&](quint64 offset, quint64 count) {
+        return offset >= HEADER_WORDS * 8 && offset <= (quint64) size && count <= ((quint64) size - offset) / sizeof(float);
+    };
+    auto floats = [&](quint64 offset) { return map + offset; };
+    auto read = [&](quint64 offset, quint64 count, auto &target) {
+        target.resize(count);
+        const uchar *in = floats(offset);
+        for (quint64 i = 0; i < count; ++i, in += sizeof(float)) target[i] = qFromLittleEndian<float>(in);
+    };
+
+    quint64 frameCount = word(SpectrumFrames), bins = word(SpectrumBins);
+    if ((bins > 0 && frameCount > (quint64) size / bins) || !fits(word(SpectrumOffset), frameCount * bins)
+        || !fits(word(PitchOffset), word(PitchCount)) || !fits(word(FormantOffset), word(FormantCount)) || !fits(word(MfccOffset), word(MfccCount))
+        || !fits(word(LogMelOffset), word(LogMelCount))) {
+        return false;
+    }
+
+    SpectralFrames &frames = results.frames;
+    frames.windowSize = word(SpectrumWindow);
+    frames.hopSize = word(SpectrumHop);
+    frames.sampleRate = word(SpectrumRate);
+    frames.numSamples = word(SpectrumSamples);
+    frames.magnitudes.resize(frameCount);
+    for (quint64 frame = 0; frame < frameCount; ++frame) {
+        read(word(SpectrumOffset) + frame * bins * sizeof(float), bins, frames.magnitudes[frame]);
+    }
+
+    PitchContour &pitch = results.pitch;
+    pitch.hopSize = word(PitchHop);
+    pitch.frameLength = word(PitchFrameLength);
+    pitch.sampleRate = word(PitchRate);
+    pitch.numSamples = word(PitchSamples);
+    read(word(PitchOffset), word(PitchCount), pitch.f0);
+
+    FormantTracks &formants = results.formants;
+    formants.hopSize = word(FormantHop);
+    formants.frameLength = word(FormantFrameLength);
+    formants.sampleRate = word(FormantRate);
+    formants.numSamples = word(FormantSamples);
+    read(word(FormantOffset), word(FormantCount), formants.frequencies);
+
+    MfccFeatures &features = results.features;
+    features.coefficientCount = word(MfccCoefficients);
+    features.melBandCount = word(MfccBands);
+    features.windowSize = word(MfccWindow);
+    features.hopSize = word(MfccHop);
+    features.sampleRate = word(MfccRate);
+    features.numSamples = word(MfccSamples);
+    read(word(MfccOffset), word(MfccCount), features.mfcc);
+    read(word(LogMelOffset), word(LogMelCount), features.logMel);
+
+    // most recently used, the time is set on the open descriptor so reading needs no write access
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+void AnalysisCache::evict() {
+    QFileInfoList entries = QDir(directory()).entryInfoList({"*.bin"}, QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 total = 0;
+    for (const QFileInfo &entry : entries) total += entry.size();
+    for (const QFileInfo &entry : entries) {
+        if (total <= budget) break;
+        if (QFile::remove(entry.absoluteFilePath())) total -= entry.size();
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef ANALYSISCACHE_H
+#define ANALYSISCACHE_H
+
+#include <QString>
+#include "spectralframes.h"
+#include "pitchtracker.h"
+#include "formanttracker.h"
+#include "mfccextractor.h"
+
+/*
+ * File: analysiscache.h
+ * Description:
+ *  This header file defines the 'AnalysisCache' class, a disk cache of everything the 'Spectrograph' computes for a
+ *  track (spectrogram, pitch contour, formant tracks, MFCC and log-mel features), and the 'AnalysisResults' struct it
+ *  stores. Reference material that was opened before shows all its analyses as soon as it is opened again.
+ *
+ * Public Methods:
+ *  - 'static QString key(const QString &source, int windowSize, int hopSize, const QString &windowType, int sampleRate)':
+ *    Content hash of the file plus the analysis parameters, empty if the file cannot be read
+ *  - 'static bool load(const QString &key, AnalysisResults &results)': Reads an entry and marks it as recently used
+ *  - 'static bool store(const QString &key, const AnalysisResults &results)': Writes an entry, then evicts the least
+ *    recently used entries until the cache fits its budget again
+ *  - 'static void setMaximumBytes(qint64 bytes)', 'static qint64 maximumBytes()': The budget, DEFAULT_CACHE_BYTES
+ *
+ * Notes:
+ *  - One file per entry in CacheLocation/analysis. A header of 32 little-endian quint64 words holds the parameters of
+ *    every analysis and the offsets of its arrays, the arrays follow as float32 at 8 byte aligned offsets, so a mapped
+ *    entry can be read in place. Amplitudes and frequencies as float32 keep entries at half the size of the doubles the
+ *    app computes with, far below the precision the display and the analyses need.
+ *  - An entry is written with QSaveFile and only ever complete. A file with another version or a broken header is
+ *    treated as missing and replaced by the next store.
+ *  - Recency is the file's modification time, a load touches it, eviction removes the oldest files first.
+ *  - The key includes CACHE_VERSION, so a change to an analysis algorithm invalidates old entries by bumping it.
+ */
+
+struct AnalysisResults
+{
+    SpectralFrames frames;
+    PitchContour pitch;
+    FormantTracks formants;
+    MfccFeatures features;
+};
+
+class AnalysisCache
+{
+    static QString directory();
+    static void evict();
+
+public:
+    static QString key(const QString &source, int windowSize, int hopSize, const QString &windowType, int sampleRate);
+    static bool load(const QString &key, AnalysisResults &results);
+    static bool store(const QString &key, const AnalysisResults &results);
+    static void setMaximumBytes(qint64 bytes);
+    static qint64 maximumBytes();
+};
+
+#endif // ANALYSISCACHE_H
@@ -0,0 +1,223 @@
+#include "analysispipeline.h"
+#include "pcmcache.h"
+#include "multiresolutionstft.h"
+#include "resampler.h"
+#include "stft.h"
+#include "tracer.h"
+#include "wavfile.h"
+#include "workerpool.h"
+
+/*
+ * File: analysispipeline.cpp
+ * Description:
+ *  This source file implements the 'AnalysisPipeline'. 'whenReady()' attaches the GUI side of a stage to its future
+ *  with QFuture::then(this, ...), which runs on the pipeline's thread and checks that the run is still the current
+ *  one. The join of the lookup and the decode is 'startAnalyses()', called by both and going ahead once both are in.
+ *
+ * Key Methods:
+ *  - 'decode()': Compressed files are mixed down straight from the mapped 'PcmCache' copy, WAV files are read with
+ *    'WavFile'. A file neither can read (no decoded copy yet, a WAV layout 'WavFile' does not parse) is decoded into
+ *    the cache with 'PcmCache::prepare()' first, waiting for it on the worker thread. 'Audio' prepares compressed files
+ *    before it announces them, so that wait is rare
+ *  - 'startAnalyses()': Queues the STFT, pitch and formant stages with the decoded samples
+ *  - 'startFeatures()': Queues the MFCC stage once the STFT frames are in, at the priority of the other stages
+ *  - 'startDisplay()', 'restoreSamples()', 'restoreFrames()': Decode the file again inside the stage when they are
+ *    given no samples, so a rebuild after an eviction never blocks the GUI thread
+ *
+ * References:
+ *  - https://doc.qt.io/qt-6/qtconcurrent-index.html
+ */
+
+static QVector<double> mixDown(const float *interleaved, qint64 frames, int channels) {
+    channels = std::max(channels, 1);
+    QVector<double> mono(frames);
+    const float *frame = interleaved;
+    for (qint64 i = 0; i < frames; ++i, frame += channels) {
+        double sum = 0.0;
+        for (int channel = 0; channel < channels; ++channel) sum += frame[channel];
+        mono[i] = sum / channels;
+    }
+    return mono;
+}
+
+AnalysisPipeline::AnalysisPipeline(int _windowSize, int _hopSize, QObject *parent)
+    : QObject(parent), windowSize(_windowSize), hopSize(_hopSize), cancelled(std::make_shared<std::atomic_bool>(false))
+{
+    // every file is decoded to the analysis rate, so the plans are made once, here on the GUI thread
+    pitchTracker = std::make_shared<PitchTracker>(Resampler::analysisRate);
+    formantTracker = std::make_shared<FormantTracker>(Resampler::analysisRate);
+    QVector<double> window;
+    Stft::hammingWindow(formantTracker->getFrameLength(), window);
+    formantTracker->setWindow(window);
+    mfccExtractor = std::make_shared<MfccExtractor>(windowSize, Resampler::analysisRate);
+}
+
+template <typename T, typename Handler>
+void AnalysisPipeline::whenReady(QFuture<T> future, Handler handler) {
+    ++pendingStages;
+    int stageRun = run;
+    future.then(this, [this, stageRun, handler](T result) {
+        if (stageRun != run) return; // cancelled or replaced by a newer file
+        --pendingStages;
+        handler(result);
+    });
+}
+
+void AnalysisPipeline::start(const QString &fileName, int _priority) {
+    TRACE_SCOPE("AnalysisPipeline::start");
+    cancel();
+    priority = _priority;
+    std::shared_ptr<std::atomic_bool> token = cancelled;
+    int window = windowSize;
+    int hop = hopSize;
+
+    whenReady(WorkerPool::run(priority, [fileName, window, hop, token]() {
+        std::pair<QString, AnalysisResults> lookup;
+        if (*token) return lookup;
+        lookup.first = AnalysisCache::key(fileName, window, hop, "hamming", Resampler::analysisRate);
+        if (!lookup.first.isEmpty() && !AnalysisCache::load(lookup.first, lookup.second)) lookup.second = AnalysisResults();
+        return lookup;
+    }), [this](const std::pair<QString, AnalysisResults> &lookup) {
+        lookupDone = true;
+        cacheHit = !lookup.second.frames.isEmpty();
+        emit cacheChecked(lookup.first, cacheHit);
+        if (cacheHit) emit analysesRestored(lookup.second);
+        startAnalyses();
+    });
+
+    whenReady(WorkerPool::run(priority, [fileName, token]() {
+        return *token ? DecodedAudio() : decode(fileName);
+    }), [this, fileName](const DecodedAudio &audio) {
+        if (audio.isEmpty()) {
+            emit decodeFailed();
+            return;
+        }
+        decodeDone = true;
+        decoded = audio;
+        emit samplesDecoded(audio);
+
+        startDisplay(fileName, audio.samples);
+        startAnalyses();
+    });
+}
+
+void AnalysisPipeline::startAnalyses() {
+    if (!lookupDone || !decodeDone || cacheHit || analysesStarted) return;
+    analysesStarted = true;
+
+    std::shared_ptr<std::atomic_bool> token = cancelled;
+    QVector<double> samples = decoded.samples;
+    decoded = DecodedAudio(); // the stages hold the samples now
+    int rate = Resampler::analysisRate;
+    int window = windowSize;
+    int hop = hopSize;
+
+    // each run has its own Stft, its buffers belong to one thread and a cancelled run may still be computing
+    QFuture<SpectralFrames> frames = WorkerPool::run(priority, [samples, rate, window, hop, token]() {
+        if (*token) return SpectralFrames();
+        Stft stft(window, hop);
+        return stft.compute(samples, rate);
+    });
+    whenReady(frames, [this](const SpectralFrames &result) {
+        emit framesReady(result);
+        startFeatures(result);
+    });
+
+    std::shared_ptr<PitchTracker> pitch = pitchTracker;
+    whenReady(WorkerPool::run(priority, [pitch, samples, token]() {
+        return *token ? PitchContour() : pitch->track(samples);
+    }), [this](const PitchContour &result) { emit pitchReady(result); });
+
+    std::shared_ptr<FormantTracker> formants = formantTracker;
+    whenReady(WorkerPool::run(priority, [formants, samples, token]() {
+        return *token ? FormantTracks() : formants->track(samples);
+    }), [this](const FormantTracks &result) { emit formantsReady(result); });
+}
+
+void AnalysisPipeline::startFeatures(const SpectralFrames &frames) {
+    if (frames.isEmpty()) return;
+    std::shared_ptr<std::atomic_bool> token = cancelled;
+    std::shared_ptr<MfccExtractor> extractor = mfccExtractor;
+    whenReady(WorkerPool::run(priority, [extractor, frames, token]() {
+        return *token ? MfccFeatures() : extractor->extract(frames);
+    }), [this](const MfccFeatures &result) { emit featuresReady(result); });
+}
+
+void AnalysisPipeline::startDisplay(const QString &fileName, const QVector<double> &samples) {
+    // both display resolutions in one pass, the plans are per request like those of the STFT stage
+    std::shared_ptr<std::atomic_bool> token = cancelled;
+    int request = ++displayRequest;
+    double lowHz = displayLowHz;
+    double highHz = displayHighHz;
+    whenReady(WorkerPool::run(priority, [fileName, samples, lowHz, highHz, token]() {
+        if (*token) return QVector<SpectralFrames>();
+        QVector<double> input = samples.isEmpty() ? decode(fileName).samples : samples;
+        if (*token || input.isEmpty()) return QVector<SpectralFrames>();
+        MultiResolutionStft stft(Resampler::analysisRate, lowHz, highHz);
+        return stft.compute(input);
+    }), [this, request](const QVector<SpectralFrames> &frames) {
+        if (request == displayRequest) emit displayFramesReady(frames); // not replaced by another range
+    });
+}
+
+void AnalysisPipeline::restoreSamples(const QString &fileName) {
+    std::shared_ptr<std::atomic_bool> token = cancelled;
+    whenReady(WorkerPool::run(priority, [fileName, token]() {
+        return *token ? DecodedAudio() : decode(fileName);
+    }), [this](const DecodedAudio &audio) { emit samplesRestored(audio); });
+}
+
+void AnalysisPipeline::restoreFrames(const QString &fileName, const QString &cacheKey, const QVector<double> &samples) {
+    std::shared_ptr<std::atomic_bool> token = cancelled;
+    int window = windowSize;
+    int hop = hopSize;
+    whenReady(WorkerPool::run(priority, [fileName, cacheKey, samples, window, hop, token]() {
+        if (*token) return SpectralFrames();
+        AnalysisResults cached;
+        if (!cacheKey.isEmpty() && AnalysisCache::load(cacheKey, cached) && !cached.frames.isEmpty()) return cached.frames;
+        QVector<double> input = samples.isEmpty() ? decode(fileName).samples : samples;
+        if (*token || input.isEmpty()) return SpectralFrames();
+        Stft stft(window, hop);
+        return stft.compute(input, Resampler::analysisRate);
+    }), [this](const SpectralFrames &frames) { emit framesRestored(frames); });
+}
+
+void AnalysisPipeline::cancel() {
+    ++run;
+    *cancelled = true;
+    cancelled = std::make_shared<std::atomic_bool>(false);
+    pendingStages = 0;
+    lookupDone = false;
+    cacheHit = false;
+    decodeDone = false;
+    analysesStarted = false;
+    decoded = DecodedAudio();
+}
+
+DecodedAudio AnalysisPipeline::decode(const QString &fileName) {
+    TRACE_SCOPE("AnalysisPipeline::decode");
+    DecodedAudio audio;
+    QVector<double> mono;
+
+    if (!PcmCache::isCompressed(fileName)) {
+        WavFile file(fileName);
+        if (file.loadFile()) {
+            QList<float> samples = file.getAudioSamples();
+            int channels = std::max(file.getNumChannels(), 1);
+            mono = mixDown(samples.constData(), samples.size() / channels, channels);
+            audio.sourceSampleRate = file.getSampleRate();
+        }
+    }
+
+    if (audio.sourceSampleRate <= 0) {
+        QString cacheFile = PcmCache::cachedFileFor(fileName);
+        if (cacheFile.isEmpty()) cacheFile = PcmCache::prepare(fileName, WorkerPool::Visible).result();
+        PcmCacheFile cached;
+        if (cacheFile.isEmpty() || !cached.open(cacheFile)) return audio;
+        mono = mixDown(cached.samples(), cached.frames(), cached.channels());
+        audio.sourceSampleRate = cached.sampleRate();
+    }
+
+    audio.samples = Resampler::resample(mono, audio.sourceSampleRate, Resampler::analysisRate);
+    return audio;
+}
@@ -0,0 +1,142 @@
+#ifndef ANALYSISPIPELINE_H
+#define ANALYSISPIPELINE_H
+
+#include <QObject>
+#include <QFuture>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "analysiscache.h"
+#include "pitchtracker.h"
+#include "formanttracker.h"
+#include "mfccextractor.h"
+
+/*
+ * File: analysispipeline.h
+ * Description:
+ *  This header file defines the 'AnalysisPipeline' class, the task graph that turns a file into everything the
+ *  'Spectrograph' shows. Every stage runs on the 'WorkerPool' and starts as soon as the stages it needs are done:
+ *
+ *      cache lookup ----------------------------------------------> restored analyses (hit)
+ *      decode --+--> wideband + narrowband display spectrograms
+ *               +--> STFT --> MFCC features
+ *               +--> pitch
+ *               +--> formants
+ *
+ *  The lookup and the decode run side by side. The display spectrograms only need the decode, they are not cached
+ *  and run on a hit too. The analyses wait for both and only run on a miss. Results are
+ *  delivered as signals on the thread that owns the pipeline (the GUI thread), one per stage, so the spectrogram
+ *  appears while the pitch and formants are still being tracked.
+ *
+ * Key Members:
+ *  - 'int run': Bumped by start() and cancel(), results of an older run are dropped when they arrive
+ *  - 'std::shared_ptr<std::atomic_bool> cancelled': Shared with the tasks of the current run, set by cancel() so
+ *    queued stages return without doing their work
+ *  - 'std::shared_ptr<PitchTracker> pitchTracker', 'formantTracker', 'mfccExtractor': Made once in the constructor,
+ *    the plans of the 'PitchTracker' under 'Stft::plannerLock()' since the pipeline of another track may be planning
+ *    its STFT on a worker meanwhile (the FFTW planner is not thread safe). Tracking with them is thread safe
+ *
+ * Public Methods:
+ *  - 'AnalysisPipeline(int windowSize, int hopSize, QObject *parent = nullptr)': STFT parameters of the spectrogram
+ *  - 'void start(const QString &fileName, int priority)': Cancels the running graph and starts a new one with the
+ *    'WorkerPool' priority of the track
+ *  - 'void cancel()': Drops the running graph, nothing more of it is delivered
+ *  - 'bool isRunning() const': True until the last stage of the current run delivered
+ *  - 'void setDisplayBand(double lowHz, double highHz)': Frequency range of the display spectrograms of the next runs
+ *  - 'void updateDisplay(const QString &fileName, const QVector<double> &samples)': Runs the display stage alone on the
+ *    samples of the current run, after the range changed or the display frames were evicted. Empty samples (evicted)
+ *    are decoded from the file again inside the stage. Replaces a display stage that is still running
+ *  - 'void restoreSamples(const QString &fileName)', 'void restoreFrames(const QString &fileName,
+ *    const QString &cacheKey, const QVector<double> &samples)': Bring back what the 'MemoryBudget' evicted, as stages
+ *    of the current run. The frames come from the 'AnalysisCache' entry if there is one, else the STFT runs on the
+ *    samples (decoded again if they are empty)
+ *  - 'static DecodedAudio decode(const QString &fileName)': The decode stage on its own, mono samples at
+ *    'Resampler::analysisRate'
+ *
+ * Signals:
+ *  - 'void cacheChecked(const QString &key, bool hit)': Key of the file in the 'AnalysisCache' and whether it was there
+ *  - 'void analysesRestored(const AnalysisResults &results)': Everything from the cache, on a hit
+ *  - 'void samplesDecoded(const DecodedAudio &audio)', 'void decodeFailed()'
+ *  - 'void displayFramesReady(const QVector<SpectralFrames> &frames)': The 'MultiResolutionStft' frames, indexed by
+ *    'MultiResolutionStft::Resolution'
+ *  - 'void samplesRestored(const DecodedAudio &audio)', 'void framesRestored(const SpectralFrames &frames)': Results of
+ *    the restore stages, empty if the file could not be read again
+ *  - 'void framesReady(const SpectralFrames &frames)', 'void pitchReady(const PitchContour &contour)',
+ *    'void formantsReady(const FormantTracks &tracks)', 'void featuresReady(const MfccFeatures &features)'
+ *
+ * Notes:
+ *  - A running stage is not interrupted, cancelling only stops the stages after it. Each stage is a whole analysis
+ *    whose inner loops are split over the pool by the trackers themselves.
+ *  - The feature stage is queued from the STFT stage's result with the same priority, it needs the frames.
+ *
+ * References:
+ *  - https://doc.qt.io/qt-6/qfuture.html#then
+ */
+
+struct DecodedAudio
+{
+    QVector<double> samples; // mono, at 'Resampler::analysisRate'
+    int sourceSampleRate = 0;
+
+    bool isEmpty() const { return samples.isEmpty(); }
+};
+
+class AnalysisPipeline : public QObject
+{
+    Q_OBJECT
+
+    int windowSize;
+    int hopSize;
+    int priority = 0;
+    int run = 0;
+    std::shared_ptr<std::atomic_bool> cancelled;
+    int pendingStages = 0;
+
+    // join of the lookup and the decode
+    bool lookupDone = false;
+    bool cacheHit = false;
+    bool decodeDone = false;
+    bool analysesStarted = false;
+    DecodedAudio decoded;
+
+    // display spectrograms
+    double displayLowHz = 0.0;
+    double displayHighHz = 0.0;
+    int displayRequest = 0;
+
+    std::shared_ptr<PitchTracker> pitchTracker;
+    std::shared_ptr<FormantTracker> formantTracker;
+    std::shared_ptr<MfccExtractor> mfccExtractor;
+
+    void startAnalyses();
+    void startFeatures(const SpectralFrames &frames);
+    void startDisplay(const QString &fileName, const QVector<double> &samples);
+    template <typename T, typename Handler>
+    void whenReady(QFuture<T> future, Handler handler);
+
+public:
+    explicit AnalysisPipeline(int windowSize, int hopSize, QObject *parent = nullptr);
+    void start(const QString &fileName, int priority);
+    void cancel();
+    bool isRunning() const { return pendingStages > 0; }
+    void setDisplayBand(double lowHz, double highHz) { displayLowHz = lowHz; displayHighHz = highHz; }
+    void updateDisplay(const QString &fileName, const QVector<double> &samples) { startDisplay(fileName, samples); }
+    void restoreSamples(const QString &fileName);
+    void restoreFrames(const QString &fileName, const QString &cacheKey, const QVector<double> &samples);
+    static DecodedAudio decode(const QString &fileName);
+
+signals:
+    void cacheChecked(const QString &key, bool hit);
+    void analysesRestored(const AnalysisResults &results);
+    void samplesDecoded(const DecodedAudio &audio);
+    void decodeFailed();
+    void displayFramesReady(const QVector<SpectralFrames> &frames);
+    void samplesRestored(const DecodedAudio &audio);
+    void framesRestored(const SpectralFrames &frames);
+    void framesReady(const SpectralFrames &frames);
+    void pitchReady(const PitchContour &contour);
+    void formantsReady(const FormantTracks &tracks);
+    void featuresReady(const MfccFeatures &features);
+};
+
+#endif // ANALYSISPIPELINE_H
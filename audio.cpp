@@ -3,9 +3,13 @@
 #include <QLabel>
 #include "wavform.h"
 #include "waveformsegments.h"
+#include "tracer.h"
+#include "pcmcache.h"
+#include "workerpool.h"
 #include <QMediaPlayer>
 #include <QAudioOutput>
 #include <QFileDialog>
+#include <QMessageBox>
 
 #define WAVFORM_HEIGHT 200
 #define WAVFORM_WIDTH 400
@@ -22,7 +26,11 @@
  *
  * Key Methods:
  *  - 'newAudioPlayer()': Sets up the layout, buttons, waveform, and timer connections
- *  - 'uploadAudio()': Handles the file selection process and media player setup
+ *  - 'uploadAudio()': Handles the file selection process, 'loadAudio()' the media player setup
+ *  - 'loadAudio()': Compressed files go through 'PcmCache::prepare()' first, which looks up or makes the decoded copy
+ *    off the GUI thread, the waveform and spectrogram then read it and the player keeps playing the original file
+ *  - 'toggleRecording(bool record)': Swaps the wavChart for the live view while recording, the finished recording is
+ *    loaded through 'loadAudio()' like an uploaded file
  *  - 'handlePlayPause()': Manages the play/pause state of the audio player and updates the timer
  *  - 'setTrackPosition(qint64 position)': Updates the current track position and emits the
  *    'audioPositionChanged' signal
@@ -39,7 +47,9 @@
  *  - 'void segmentLengthShow(int numSamples, int sampleRate)': displayes number of samples and samples divided by sampleRate on segmentLengthLabel
  *  - 'segmentCreateControlsEnable(bool ready)': enables the create button once segments are established
  *  - 'toggleBoolManualSegments(double position)': enables the clear button and sends updated delta data and indicates to use segments from the delta value
- *  - 'toggleBoolAutoSegments()': enables clear button and indicates the segments are the auto ones
+ *  - 'toggleBoolAutoSegments()': enables clear button and indicates the segments are the auto ones, asks for the
+ *    spectrogram frames again before syllable segmenting in case the 'MemoryBudget' evicted them
+ *  - 'setSpectralFrames(SpectralFrames frames)': hands the spectrogram frames to the segmenter for syllable auto segments
  *  - 'watchForEndOfSegmentAudio(qint64 audioPosition)': watches for if the end of the indicated segment is reached if the segment play is on
  *  - 'handlePlayPauseButton()': deals with play pause specifically when the button for it is pressed (or if original audio needs to be paused/played)
  *  - 'clearSegmentsEnable(bool enable)': enable/disable the clear segments button
@@ -85,14 +95,22 @@ void Audio::newAudioPlayer(){
     connect(uploadAudioButton, &QPushButton::clicked, this, &Audio::uploadAudio);
     audioControls->addWidget(uploadAudioButton, 0, Qt::AlignLeft);
 
+    // the user's track can record the attempt directly
+    if (audioDiviceNumber == 1) {
+        recordButton = new QPushButton("Record");
+        recordButton->setCheckable(true);
+        connect(recordButton, &QPushButton::toggled, this, &Audio::toggleRecording);
+        audioControls->addWidget(recordButton, 0, Qt::AlignLeft);
+    }
+
     QAction *playAction = new QAction();
     connect(playAction, &QAction::triggered, this, &Audio::handlePlayPauseButton);
 
     if (audioDiviceNumber == 0) {
         playAction->setShortcut(Qt::Key_Space); // top audio play & pause: Space
-    } else {
+    } else if (audioDiviceNumber == 1) {
         playAction->setShortcut(Qt::SHIFT | Qt::Key_Space); // bottom audio: Shift+Space
-    }
+    } // further speaker tracks of the workspace have no shortcut
 
     playButton = new QToolButton;
     playButton->setDefaultAction(playAction);
@@ -159,6 +177,17 @@ void Audio::newAudioPlayer(){
     QHBoxLayout *ChartAndVerticalSliderLayout = new QHBoxLayout();
     displayAndControlsLayout->addLayout(ChartAndVerticalSliderLayout);
     ChartAndVerticalSliderLayout->addWidget(wavChart);
+    if (recordButton) {
+        liveView = new LiveRecordingView(WAVFORM_WIDTH, WAVFORM_HEIGHT);
+        liveView->setVisible(false);
+        liveRecorder = new LiveRecorder(this);
+        connect(liveRecorder, &LiveRecorder::liveUpdate, liveView, &LiveRecordingView::addUpdate);
+        connect(liveRecorder, &LiveRecorder::recordingFinished, this, [this](const QString &path) {
+            loadAudio(QUrl::fromLocalFile(path));
+        });
+        connect(liveRecorder, &LiveRecorder::recordingFailed, this, &Audio::recordingFailed);
+        ChartAndVerticalSliderLayout->addWidget(liveView);
+    }
     ChartAndVerticalSliderLayout->addWidget(verticalSlider);
     //zoom next to it
     displayAndControlsLayout->addWidget(horizontalSlider);
@@ -169,6 +198,7 @@ void Audio::newAudioPlayer(){
     timerRefreshRate = 10;
 
     connect(this, &Audio::audioPositionChanged, wavChart, &WavForm::updateScrubberPosition);
+    connect(wavChart, &WavForm::selectionChanged, this, &Audio::selectionChanged);
     connect(this->wavChart, &WavForm::sendAudioPosition, this, &Audio::updateTrackPositionFromScrubber);
 
     connect(zoomButtons, &Zoom::zoomGraphIn, this, &Audio::ZoomScrubberPosition);
@@ -186,6 +216,12 @@ void Audio::newAudioPlayer(){
     autoSegmentButton = new QPushButton("auto");
     autoSegmentButton->setEnabled(false);
 
+    //auto segment mode: amplitude peaks or syllables (energy, spectral flux and voicing of the spectrogram)
+    autoSegmentModeSelector = new QComboBox();
+    autoSegmentModeSelector->addItem("peaks", WaveFormSegments::PeakSegments);
+    autoSegmentModeSelector->addItem("syllables", WaveFormSegments::SyllableSegments);
+    autoSegmentModeSelector->setEnabled(false);
+
     connect(deltaSelector, &QDoubleSpinBox::valueChanged, this, &Audio::toggleBoolManualSegments);
     connect(autoSegmentButton, &QPushButton::clicked, this, &Audio::toggleBoolAutoSegments);
 
@@ -195,6 +231,7 @@ void Audio::newAudioPlayer(){
     QHBoxLayout *deltaLayout = new QHBoxLayout();
     deltaLayout->addWidget(deltaSelector);
     deltaLayout->addWidget(autoSegmentButton);
+    deltaLayout->addWidget(autoSegmentModeSelector);
     wavFormVertControls->addLayout(deltaLayout);
 
     //graph audio segments controls
@@ -232,6 +269,8 @@ void Audio::newAudioPlayer(){
     connect(wavChart, &WavForm::clearEnable, this,  &Audio::clearSegmentsEnable);
     connect(graphAudioSegments, &WaveFormSegments::createWavSegmentGraphs, segmentGraph, &SegmentGraph::updateGraphs);
     connect(graphAudioSegments, &WaveFormSegments::storeStartEndValuesOfSegments, segmentGraph, &SegmentGraph::getSegmentStartEnd);
+    connect(graphAudioSegments, &WaveFormSegments::statisticsReady, segmentGraph, &SegmentGraph::setStatistics);
+    connect(graphAudioSegments, &WaveFormSegments::spectralFramesNeeded, this, &Audio::spectralFramesNeeded);
     connect(graphAudioSegments, &WaveFormSegments::drawAutoSegments, wavChart, &WavForm::drawAutoIntervals);
     connect(wavChart, &WavForm::clearAllSegmentInfo, segmentGraph, &SegmentGraph::clearView);
     connect(wavChart, &WavForm::clearAllSegmentInfo, graphAudioSegments, &WaveFormSegments::clearAllWavSegments);
@@ -239,6 +278,8 @@ void Audio::newAudioPlayer(){
     connect(this, &Audio::segmentAudioNotPlaying,segmentGraph, &SegmentGraph::changePlayPauseButton);
     audioLayout->addWidget(segmentGraph);
 
+    connect(&pcmWatcher, &QFutureWatcher<QString>::finished, this, &Audio::pcmCacheReady);
+
 }
 
 void Audio::uploadAudio(){
@@ -247,6 +288,34 @@ void Audio::uploadAudio(){
     disableButtonsUntilAudio();
     QUrl aName = QFileDialog::getOpenFileUrl(this, "Select audio file");
     if (aName.isEmpty()) return;
+    loadAudio(aName);
+}
+
+void Audio::loadAudio(const QUrl &aName){
+    QString fileName = aName.toLocalFile();
+    if (PcmCache::isCompressed(fileName)) {
+        // the content hash that finds an earlier decode and the decode itself both run on a worker thread, later opens
+        // of the same content only hash
+        pendingAudio = aName;
+        uploadAudioButton->setEnabled(false);
+        uploadAudioButton->setText("Decoding...");
+        pcmWatcher.setFuture(PcmCache::prepare(fileName, audioDiviceNumber == 1 ? WorkerPool::Learner : WorkerPool::Visible));
+        return;
+    }
+    openAudio(aName);
+}
+
+void Audio::pcmCacheReady(){
+    uploadAudioButton->setEnabled(!recordButton || !recordButton->isChecked());
+    uploadAudioButton->setText("Upload");
+    if (pcmWatcher.result().isEmpty()) {
+        QMessageBox::warning(this, "Upload", "The file could not be decoded: " + pendingAudio.fileName());
+        return;
+    }
+    openAudio(pendingAudio);
+}
+
+void Audio::openAudio(const QUrl &aName){
     audioUploaded = true;
     disableButtonsUntilAudio();
     handleWavClearing();
@@ -259,6 +328,8 @@ void Audio::uploadAudio(){
     player->setSource(aName);
     audioOutput->setVolume(50);
     connect(player, &QMediaPlayer::positionChanged, this, &Audio::watchForEndOfSegmentAudio);
+    // before the timer slot below corrects the scrubber to the new position
+    connect(player, &QMediaPlayer::positionChanged, this, &Audio::measureScrubberLead);
 
     playButton->setEnabled(true);
     loopButton->setEnabled(true);
@@ -282,6 +353,39 @@ void Audio::uploadAudio(){
     }
 
 }
+void Audio::toggleRecording(bool record){
+    if (record) {
+        handleSpectWithPlay();
+        if (!liveRecorder->start(WAVFORM_WIDTH, liveView->getVisibleSeconds())) return; // recordingFailed resets the button
+        liveView->begin(liveRecorder->getSampleRate(), liveRecorder->getWindowSize(), liveRecorder->getHopSize());
+        uploadAudioButton->setEnabled(false);
+        playButton->setEnabled(false);
+        wavChart->setVisible(false);
+        liveView->setVisible(true);
+        recordButton->setText("Stop");
+    } else {
+        liveRecorder->stop(); // loads the recording, or reports why it could not
+        liveView->setVisible(false);
+        wavChart->setVisible(true);
+        uploadAudioButton->setEnabled(true);
+        playButton->setEnabled(audioUploaded);
+        recordButton->setText("Record");
+    }
+}
+
+void Audio::recordingFailed(const QString &message){
+    if (recordButton->isChecked()) {
+        QSignalBlocker blocker(recordButton);
+        recordButton->setChecked(false);
+        liveView->setVisible(false);
+        wavChart->setVisible(true);
+        uploadAudioButton->setEnabled(true);
+        playButton->setEnabled(audioUploaded);
+        recordButton->setText("Record");
+    }
+    QMessageBox::warning(this, "Recording", message);
+}
+
 void Audio::handlePlayPauseButton(){
 
     QIcon icon = audioPlaying ? QIcon(":/resources/icons/play.svg") : QIcon(":/resources/icons/pause.svg");
@@ -363,6 +467,7 @@ void Audio::updateTrackPositionFromSegment(QPair<double, double> startEnd){
     segmentAudioPlaying= true;
     segmentAudioEndPosition = (qint64)(startEnd.second * audioLength);
     handlePlayPause();
+    emit segmentPlayRequested(startEnd);
 
 
 }
@@ -389,11 +494,17 @@ void Audio::toggleBoolManualSegments(double position) {
 
 void Audio::toggleBoolAutoSegments() {
     autoSegmentBool = true;
+    WaveFormSegments::AutoSegmentMode mode = (WaveFormSegments::AutoSegmentMode) autoSegmentModeSelector->currentData().toInt();
+    graphAudioSegments->setAutoSegmentMode(mode);
+    if (mode == WaveFormSegments::SyllableSegments) emit spectralFramesNeeded(); // the frames may have been evicted
     if (!clearAllGraphSegmentsButton->isEnabled())clearAllGraphSegmentsButton->setEnabled(true);
 
     emit emitAutoSegmentBool(autoSegmentBool);
 }
 
+void Audio::setSpectralFrames(SpectralFrames frames) {
+    graphAudioSegments->setSpectralFrames(frames);
+}
 
 void Audio::ZoomScrubberPosition(){
     double floatPosition = (double) audioPosition / audioLength;
@@ -401,6 +512,7 @@ void Audio::ZoomScrubberPosition(){
 }
 
 void Audio::setTrackPosition(qint64 position) {
+    TRACE_SCOPE("Audio::setTrackPosition");
     audioPosition = position;
     double floatPosition = (double) audioPosition / audioLength;
     if (floatPosition < 1.0 & abs(audioPosition - player->position()) > 100) {
@@ -445,6 +557,25 @@ void Audio::setTrackPosition(qint64 position) {
 
 }
 
+qint64 Audio::segmentBufferBytes() const {
+    return graphAudioSegments->segmentBytes();
+}
+
+void Audio::measureScrubberLead(qint64 playerPosition) {
+    // the player's position is the clock of the sound that is heard, audioPosition is where the scrubber is drawn
+    if (!audioPlaying || segmentAudioPlaying) return;
+    emit scrubberLeadMeasured(audioPosition - playerPosition);
+}
+
+void Audio::seekPlayer(double proportion) {
+    player->setPosition((qint64) (proportion * audioLength));
+}
+
+double Audio::getTrackProportion() const {
+    if (!audioUploaded || audioLength <= 0) return 0.0;
+    return (double) audioPosition / audioLength;
+}
+
 void Audio::updateAudioDuration(qint64 duration){
     audioLength = duration;
 }
@@ -458,6 +589,7 @@ void Audio::audioLoaded(){
 void Audio::segmentIntervalControlsEnable(bool ready){
     deltaSelector->setEnabled(ready);
     autoSegmentButton->setEnabled(ready);
+    autoSegmentModeSelector->setEnabled(ready);
     segmentLengthLabel->setVisible(ready);
 }
 
@@ -507,6 +639,7 @@ void Audio::handleWavClearing() {
 void Audio::disableButtonsUntilAudio() {
 
     autoSegmentButton->setEnabled(audioUploaded);
+    autoSegmentModeSelector->setEnabled(audioUploaded);
     clearAllGraphSegmentsButton->setEnabled(audioUploaded);
     createGraphSegmentsButton->setEnabled(audioUploaded);
     deltaSelector->setEnabled(audioUploaded);
@@ -546,6 +679,7 @@ void Audio::disableAudioControls(bool disable){
     }
     audio2aligned = disable;
     if (autoSegmentButton->isEnabled()) autoSegmentButton->setDisabled(disable);
+    if (autoSegmentModeSelector->isEnabled()) autoSegmentModeSelector->setDisabled(disable);
     if (clearAllGraphSegmentsButton->isEnabled()) clearAllGraphSegmentsButton->setDisabled(disable);
     if (createGraphSegmentsButton->isEnabled()) createGraphSegmentsButton->setDisabled(disable);
     if (deltaSelector->isEnabled()) deltaSelector->setDisabled(disable);
@@ -7,10 +7,14 @@
 #include <QMediaPlayer>
 #include <QToolButton>
 #include <QBoxLayout>
+#include <QComboBox>
+#include <QFutureWatcher>
 #include "wavform.h"
 #include "zoom.h"
 #include "segmentgraph.h"
 #include "waveformsegments.h"
+#include "liverecorder.h"
+#include "liverecordingview.h"
 
 /*
  * File: audio.h
@@ -33,14 +37,26 @@
  *  - 'WavForm *wavChart': Displays the wavForm of the audio file
  *  - 'Zoom *zoomButtons': Zoom controls for adjusting the waveform display
  *  - 'QTimer *timer': Timer for updating audio position during playback
+ *  - 'QPushButton *recordButton', 'LiveRecorder *liveRecorder', 'LiveRecordingView *liveView': Records the user's attempt
+ *    from the microphone with a live waveform and spectrogram in place of the wavChart (user track only)
  *
  * Public Methods:
  *  - 'Audio(QWidget *parent = nullptr)': Constructor to initialize audio widget
  *  - 'void newAudioPlayer()': Initializes UI components and layout
  *  - 'void setTrackPosition(qint64 position)': Updates the track position
+ *  - 'double getTrackProportion() const': Track position as a proportion of the track (0 to 1)
+ *  - 'bool isPlaying() const': Whether the track is playing
+ *  - 'void seekPlayer(double proportion)': Moves the player alone to a proportion of the track, the scrubber follows
+ *    with the next position update of playback
+ *  - 'qint64 segmentBufferBytes() const': Bytes held by the segments of the segment graph, for the performance HUD
  *
  * Public Slots:
  *  - 'void uploadAudio()': Opens a file dialog for selecting an audio file and initializes playback
+ *  - 'void loadAudio(const QUrl &aName)': Initializes playback and the charts for a file, also used for recordings. A
+ *    compressed file is first looked up in the 'PcmCache' on a worker thread and decoded there unless it was before
+ *  - 'void pcmCacheReady()': Continues loading the compressed file once its decoded copy is in the cache
+ *  - 'void toggleRecording(bool record)': Starts recording and shows the live view, or stops and loads the recording
+ *  - 'void recordingFailed(const QString &message)': Puts the track back into upload mode and shows why
  *  - 'void handlePlayPause()': Toggles between playing and pausing the audio
  *  - 'void updateTrackPositionFromTimer()': Updates track position based on timer
  *  - 'void updateTrackPositionFromScrubber(double position)': Updates track position from scrubbler movement
@@ -52,7 +68,9 @@
  *  - 'void segmentLengthShow(int numSamples, int sampleRate)': displays selected segment length in samples and seconds on segmentLengthLabel
  *  - 'void segmentCreateControlsEnable(bool ready)': enables the create button once segments are established
  *  - 'void toggleBoolManualSegments(double position)': enables the clear button and sends updated delta data and indicates to use segments from the delta value
- *  - 'void toggleBoolAutoSegments()': enables clear button and indicates the segments are the auto ones
+ *  - 'void toggleBoolAutoSegments()': enables clear button and indicates the segments are the auto ones, made by the mode chosen in autoSegmentModeSelector
+ *  - 'void setSpectralFrames(SpectralFrames frames)': passes the spectrogram frames on for syllable auto segmentation and
+ *    the spectral statistics of the segments
  *  - 'void watchForEndOfSegmentAudio(qint64 audioPosition)': watches for if the end of the indicated segment is reached if the segment play is on
  *  - 'void handlePlayPauseButton()': deals with play pause specifically when the button for it is pressed (or if original audio needs to be paused/played)
  *  - 'void clearSegmentsEnable(bool enable)': enable/disable the clear segments button
@@ -64,15 +82,26 @@
  *  - 'void disableAudioControls(bool disable)': disables audio2 controls if audio1 aligning checkbox is checked and only allows for scrubber actions on audio2 for user
  *  - 'void audioAligningSegmentControls(bool segEnabled)': if the audio aligning is on but user on audio1 wants to use segmenting, aligning is turned off
  *  - 'void switchControlsWithAlign(bool aligning)': forces follow scrubber on if aligning is on
+ *  - 'void measureScrubberLead(qint64 playerPosition)': when the player reports a new position while playing, compares
+ *      it with the position the scrubber is drawn at
  * Signals:
  *  - 'void emitLoadAudioIn(QString fName)': Emits signal when an audio file is uploaded
  *  - 'void audioPositionChanged(double position)': Emits signal when the audio position is changed
  *  - 'void segmentAudioNotPlaying(bool)': emits when the segment audio is playing/not to update what the player is doing or segment ui
  *  - 'void audioFileSelected(const QString &fileName)': tells spectrograph that the audio is loaded
+ *  - 'void selectionChanged(double startProportion, double endProportion)': the segment lines of the waveform moved,
+ *    passed on from 'WavForm' for the spectrograph
  *  - signals for audio aliging so that audio2 can do whatever audio1 does:
  *      - 'void playPauseActivated()'
  *      - 'void scrubberUpdate(double position)': position of audio1 scrubber updated
  *      - 'void audioEnded(bool disconnect)': when either audio ends is updated signal for audio 2 to disconnect/connect from/to 1 until play/pause or scrubber is activated
+ *  - 'void segmentPlayRequested(QPair<double, double> startEnd)': a segment of the segment graph is played, so the other
+ *    track can cue the segment that goes with it
+ *  - 'void scrubberLeadMeasured(qint64 milliseconds)': how far the drawn scrubber is ahead of the player's clock (negative
+ *    if behind)
+ *  - 'void spectralFramesNeeded()': syllable segmenting is about to start, or the segment statistics of 'WavFormSegments'
+ *    need the frames, the spectrograph should send its frames if they were evicted. Connected directly, so they have
+ *    arrived when the emit returns
  * Notes:
  *  - The 'Audio' class relies on the 'WavForm', 'SegmentGraph', 'WavFormSegments', and 'Zoom' classes for waveform visualization and zooming
  *
@@ -113,6 +142,7 @@ class Audio : public QWidget
     QCheckBox *segmentToolsCheckbox;
     QLabel *segmentLengthLabel;
     QPushButton *autoSegmentButton;
+    QComboBox *autoSegmentModeSelector;
     bool segmentAudioPlaying;
     qint64 segmentAudioEndPosition;
     qint64 segmentAudioStartPosition;
@@ -127,17 +157,33 @@ class Audio : public QWidget
     bool spectrographReadyFlag;
     bool audioUploaded = false;
 
+    QPushButton *recordButton = nullptr;
+    LiveRecorder *liveRecorder = nullptr;
+    LiveRecordingView *liveView = nullptr;
+
+    QFutureWatcher<QString> pcmWatcher; // decode of a compressed file into the 'PcmCache'
+    QUrl pendingAudio;
+    void openAudio(const QUrl &aName);
+
 
 public:
     explicit Audio(QWidget *parent = nullptr, QString _label = "Sound Wave", int _audioDiviceNumber = 0);
     WavForm *wavChart;
     void newAudioPlayer();
     void setTrackPosition(qint64 position);
+    double getTrackProportion() const;
+    bool isPlaying() const { return audioPlaying; }
+    void seekPlayer(double proportion);
+    qint64 segmentBufferBytes() const;
     QCheckBox *alignAllAudioFocus;
     Zoom *zoomButtons;
 
 public slots:
     void uploadAudio();
+    void loadAudio(const QUrl &aName);
+    void toggleRecording(bool record);
+    void recordingFailed(const QString &message);
+    void pcmCacheReady();
     void handlePlayPause();
     void updateTrackPositionFromTimer();
     void updateTrackPositionFromScrubber(double position);
@@ -150,6 +196,7 @@ public slots:
     void segmentCreateControlsEnable(bool ready);
     void toggleBoolManualSegments(double position);
     void toggleBoolAutoSegments();
+    void setSpectralFrames(SpectralFrames frames);
 
     void watchForEndOfSegmentAudio(qint64 audioPosition);
     void handlePlayPauseButton();
@@ -164,6 +211,7 @@ public slots:
     void disableAudioControls(bool disable);
     void audioAligningSegmentControls(bool segEnabled);
     void switchControlsWithAlign(bool aligning);
+    void measureScrubberLead(qint64 playerPosition);
 
 signals:
     void emitLoadAudioIn(QString fName);
@@ -175,6 +223,10 @@ signals:
     void playPauseActivated();
     void scrubberUpdate(double position);
     void audioEnded(bool disconnect);
+    void segmentPlayRequested(QPair<double, double> startEnd);
+    void scrubberLeadMeasured(qint64 milliseconds);
+    void spectralFramesNeeded();
+    void selectionChanged(double startProportion, double endProportion);
 
 
 };
@@ -0,0 +1,49 @@
+# Headless batch analysis: peak files, spectrogram images and segment boundaries for whole directories.
+# Only QtCore, QtGui (QImage), QtConcurrent and QtMultimedia (decoding compressed files), no widgets, so it runs on
+# servers without a display.
+
+QT       += core gui concurrent multimedia
+QT       -= widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = phonetics-batch
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    batchprocessor.cpp \
+    ../ltas.cpp \
+    ../memorybudget.cpp \
+    ../pcmcache.cpp \
+    ../resampler.cpp \
+    ../spectrogramrenderer.cpp \
+    ../stft.cpp \
+    ../syllablesegmenter.cpp \
+    ../tracer.cpp \
+    ../waveformreducer.cpp \
+    ../waveformsegments.cpp \
+    ../wavfile.cpp \
+    ../workerpool.cpp
+
+HEADERS += \
+    batchprocessor.h \
+    ../ltas.h \
+    ../memorybudget.h \
+    ../pcmcache.h \
+    ../resampler.h \
+    ../spectralframes.h \
+    ../spectrogramrenderer.h \
+    ../stft.h \
+    ../syllablesegmenter.h \
+    ../tracer.h \
+    ../waveformreducer.h \
+    ../waveformsegments.h \
+    ../wavfile.h \
+    ../workerpool.h
+
+# adding the FFTW library
+INCLUDEPATH += /usr/local/include
+LIBS += -L/usr/local/lib -lfftw3
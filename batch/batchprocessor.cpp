@@ -0,0 +1,180 @@
+#include "batchprocessor.h"
+#include <QtConcurrent>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QImage>
+#include <QAtomicInt>
+#include "wavfile.h"
+#include "pcmcache.h"
+#include "stft.h"
+#include "resampler.h"
+#include "spectrogramrenderer.h"
+#include "waveformreducer.h"
+#include "waveformsegments.h"
+#include "syllablesegmenter.h"
+
+/*
+ * File: batchprocessor.cpp
+ * Description:
+ *  This source file implements the 'BatchProcessor'. Every file is independent, they are mapped over a thread pool of
+ *  options.threadCount threads with QtConcurrent::blockingMap.
+ *
+ * Peak file format (QDataStream, little endian):
+ *  - 'PEAK' magic, quint32 version (1), quint32 sample rate, quint32 samples per peak, quint32 peak count
+ *  - then per peak a float min and a float max
+ *
+ * Notes:
+ *  - The GUI draws 'WavFile' samples as they are stored (interleaved for stereo), the batch tool mixes the channels
+ *    down to mono first so the peaks and boundaries are in time of the recording.
+ */
+
+#define PEAK_FILE_VERSION 1
+
+BatchProcessor::BatchProcessor(const BatchOptions &_options)
+    : options(_options)
+{
+}
+
+QStringList BatchProcessor::findFiles() const {
+    QStringList files;
+    QDirIterator::IteratorFlags flags = options.recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags;
+    QStringList patterns = {"*.wav", "*.WAV", "*.mp3", "*.MP3", "*.m4a", "*.M4A", "*.flac", "*.FLAC"};
+    QDirIterator iterator(options.inputDirectory, patterns, QDir::Files, flags);
+    while (iterator.hasNext()) files << iterator.next();
+    files.sort();
+    return files;
+}
+
+int BatchProcessor::run() {
+    QStringList files = findFiles();
+    if (files.isEmpty()) {
+        qWarning() << "Batch Error: no WAV files in" << options.inputDirectory;
+        return 0;
+    }
+
+    QThreadPool filePool;
+    filePool.setMaxThreadCount(options.threadCount);
+    QThreadPool::globalInstance()->setMaxThreadCount(options.threadCount);
+
+    QAtomicInt failed = 0;
+    QAtomicInt done = 0;
+    int total = files.size();
+    QtConcurrent::blockingMap(&filePool, files, [&](const QString &path) {
+        bool ok = processFile(path);
+        if (!ok) failed.fetchAndAddRelaxed(1);
+        qInfo().noquote() << QString("[%1/%2]").arg(done.fetchAndAddRelaxed(1) + 1).arg(total)
+                          << (ok ? "done" : "FAILED") << path;
+    });
+    return failed.loadRelaxed();
+}
+
+bool BatchProcessor::processFile(const QString &path) const {
+    // compressed files are decoded into the cache the app reads too, WavFile then reads the decoded copy
+    if (PcmCache::isCompressed(path) && PcmCache::prepare(path).result().isEmpty()) return false;
+
+    WavFile wav(path);
+    if (!wav.loadFile()) return false;
+
+    int sampleRate = wav.getSampleRate();
+    int channels = std::max(wav.getNumChannels(), 1);
+    QList<float> interleaved = wav.getAudioSamples();
+    if (sampleRate <= 0 || interleaved.isEmpty()) {
+        qWarning() << "Batch Error: no samples in" << path;
+        return false;
+    }
+
+    // average the interleaved channels into one
+    qsizetype frameCount = interleaved.size() / channels;
+    QList<float> samples(frameCount);
+    QVector<double> mono(frameCount);
+    for (qsizetype frame = 0; frame < frameCount; ++frame) {
+        float sum = 0.0f;
+        for (int channel = 0; channel < channels; ++channel) sum += interleaved[frame * channels + channel];
+        samples[frame] = sum / channels;
+        mono[frame] = samples[frame];
+    }
+
+    // the spectrogram at the app's analysis rate, so its bins match the spectrogram of the app for any file
+    mono = Resampler::resample(mono, sampleRate, Resampler::analysisRate);
+    Stft stft(options.windowSize, options.windowSize);
+    SpectralFrames frames = stft.compute(mono, Resampler::analysisRate);
+
+    QFileInfo info(path);
+    QString relativeDirectory = QDir(options.inputDirectory).relativeFilePath(info.absolutePath());
+    QDir outputDirectory(QDir(options.outputDirectory).filePath(relativeDirectory));
+    if (!outputDirectory.mkpath(".")) {
+        qWarning() << "Batch Error: could not create" << outputDirectory.path();
+        return false;
+    }
+    QString base = outputDirectory.filePath(info.completeBaseName());
+
+    bool ok = writePeaks(base + ".peaks", samples, sampleRate);
+    ok = writeSpectrogram(base + ".png", frames) && ok;
+    ok = writeSegments(base + ".segments.json", info.fileName(), samples, sampleRate, frames) && ok;
+    return ok;
+}
+
+bool BatchProcessor::writePeaks(const QString &path, const QList<float> &samples, int sampleRate) const {
+    int peakCount = samples.size() / options.samplesPerPeak;
+    WaveformColumns columns = WaveformReducer::reduce(samples.first(peakCount * options.samplesPerPeak), peakCount);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Batch Error: could not write" << path;
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    stream.writeRawData("PEAK", 4);
+    stream << quint32(PEAK_FILE_VERSION) << quint32(sampleRate) << quint32(options.samplesPerPeak) << quint32(peakCount);
+    for (int i = 0; i < peakCount; ++i) stream << columns.mins[i] << columns.maxs[i];
+    return stream.status() == QDataStream::Ok;
+}
+
+bool BatchProcessor::writeSpectrogram(const QString &path, const SpectralFrames &frames) const {
+    QImage image = SpectrogramRenderer::render(frames, 0.0, options.maxFrequency, options.imageWidth, options.imageHeight);
+    if (image.isNull()) {
+        qWarning() << "Batch Error: nothing to draw for" << path;
+        return false;
+    }
+    if (!image.save(path, "PNG")) {
+        qWarning() << "Batch Error: could not write" << path;
+        return false;
+    }
+    return true;
+}
+
+bool BatchProcessor::writeSegments(const QString &path, const QString &sourceFile, const QList<float> &samples,
+                                   int sampleRate, const SpectralFrames &frames) const {
+    double duration = (double) samples.size() / sampleRate;
+
+    QJsonArray peakBoundaries;
+    for (int index : WaveFormSegments::autoSegmentPeaks(samples, 0, (int) samples.size())) {
+        peakBoundaries << (double) index / sampleRate;
+    }
+    QJsonArray syllableBoundaries;
+    for (double proportion : SyllableSegmenter::findBoundaries(frames, 0.0, 1.0)) {
+        syllableBoundaries << proportion * duration;
+    }
+
+    QJsonObject segments;
+    segments["file"] = sourceFile;
+    segments["sampleRate"] = sampleRate;
+    segments["durationSeconds"] = duration;
+    segments["peakBoundaries"] = peakBoundaries;
+    segments["syllableBoundaries"] = syllableBoundaries;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Batch Error: could not write" << path;
+        return false;
+    }
+    return file.write(QJsonDocument(segments).toJson()) >= 0;
+}
@@ -0,0 +1,70 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "spectralframes.h"
+
+/*
+ * File: batchprocessor.h
+ * Description:
+ *  This header file defines the 'BatchProcessor' class, which runs the analyses of the app over every audio file of a
+ *  directory without any widgets, and the 'BatchOptions' struct configuring it.
+ *
+ * Purpose:
+ *  - Prepares reference clips for a course in one run instead of one upload at a time in the GUI
+ *
+ * Outputs (next to each other in the output directory, the input's sub directories are kept):
+ *  - '<name>.peaks': Waveform peaks, see 'writePeaks()'
+ *  - '<name>.png': The spectrogram as drawn by the 'Spectrograph'
+ *  - '<name>.segments.json': Auto segment boundaries in seconds, by amplitude peaks ('WaveFormSegments') and by
+ *    syllables ('SyllableSegmenter')
+ *
+ * Public Methods:
+ *  - 'BatchProcessor(const BatchOptions &options)': Keeps the options
+ *  - 'QStringList findFiles() const': WAV, MP3, M4A and FLAC files of the input directory
+ *  - 'int run()': Processes all files, options.threadCount files at a time, returns the number of files that failed
+ *
+ * Private Methods:
+ *  - 'bool processFile(const QString &path) const': Loads one file with 'WavFile', mixes it down to mono, runs the
+ *    'Stft' once and writes the three outputs
+ *  - 'bool writePeaks(...)': Min and max of every samplesPerPeak samples, reduced with 'WaveformReducer'
+ *  - 'bool writeSpectrogram(...)': Image of the frames with 'SpectrogramRenderer'
+ *  - 'bool writeSegments(...)': Boundaries of both auto segment modes as JSON
+ *
+ * Notes:
+ *  - Files run on their own thread pool (threadCount threads), the analyses inside a file use the global pool, which
+ *    is sized the same. Waiting file threads never block the inner work that way.
+ */
+
+struct BatchOptions
+{
+    QString inputDirectory;
+    QString outputDirectory;
+    bool recursive = false;
+    int threadCount = 1;
+    int imageWidth = 650;
+    int imageHeight = 200;
+    int samplesPerPeak = 256;
+    int windowSize = 1024;
+    double maxFrequency = 5000.0;
+};
+
+class BatchProcessor
+{
+    BatchOptions options;
+
+    bool processFile(const QString &path) const;
+    bool writePeaks(const QString &path, const QList<float> &samples, int sampleRate) const;
+    bool writeSpectrogram(const QString &path, const SpectralFrames &frames) const;
+    bool writeSegments(const QString &path, const QString &sourceFile, const QList<float> &samples, int sampleRate,
+                       const SpectralFrames &frames) const;
+
+public:
+    explicit BatchProcessor(const BatchOptions &options);
+    QStringList findFiles() const;
+    int run();
+};
+
+#endif // BATCHPROCESSOR_H
@@ -0,0 +1,65 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QThread>
+#include "batchprocessor.h"
+#include "tracer.h"
+
+/*
+ * File: main.cpp (batch)
+ * Description:
+ *  Entry point of 'phonetics-batch', the command line version of the analyses for whole directories.
+ *
+ *      phonetics-batch [-r] [-j threads] [-o output] <input directory>
+ *
+ *  Exits with 0 if every file was processed, 1 if some failed and 2 for invalid arguments. PHONETICS_TRACE works as in
+ *  the app (see tracer.h).
+ */
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("phonetics-batch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Writes waveform peaks, spectrogram images and auto segment boundaries for every audio file (WAV, MP3, M4A, FLAC) of a directory.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Directory with the audio files.");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Output directory (default: <input>/analysis).", "directory");
+    QCommandLineOption threadsOption(QStringList() << "j" << "threads", "Number of worker threads (default: all cores).", "count",
+                                     QString::number(QThread::idealThreadCount()));
+    QCommandLineOption recursiveOption(QStringList() << "r" << "recursive", "Also process sub directories.");
+    QCommandLineOption widthOption("width", "Spectrogram image width.", "pixels", "650");
+    QCommandLineOption heightOption("height", "Spectrogram image height.", "pixels", "200");
+    QCommandLineOption peakOption("samples-per-peak", "Samples reduced into each waveform peak.", "samples", "256");
+    QCommandLineOption frequencyOption("max-frequency", "Highest frequency of the spectrogram image, 0 for all.", "Hz", "5000");
+    parser.addOptions({outputOption, threadsOption, recursiveOption, widthOption, heightOption, peakOption, frequencyOption});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(2);
+    }
+
+    BatchOptions options;
+    options.inputDirectory = QDir(parser.positionalArguments().first()).absolutePath();
+    options.outputDirectory = parser.isSet(outputOption) ? QDir(parser.value(outputOption)).absolutePath()
+                                                         : QDir(options.inputDirectory).filePath("analysis");
+    options.recursive = parser.isSet(recursiveOption);
+    options.threadCount = parser.value(threadsOption).toInt();
+    options.imageWidth = parser.value(widthOption).toInt();
+    options.imageHeight = parser.value(heightOption).toInt();
+    options.samplesPerPeak = parser.value(peakOption).toInt();
+    options.maxFrequency = parser.value(frequencyOption).toDouble();
+
+    if (!QDir(options.inputDirectory).exists() || options.threadCount < 1 || options.imageWidth < 1
+        || options.imageHeight < 1 || options.samplesPerPeak < 1 || options.maxFrequency < 0.0) {
+        qWarning() << "Batch Error: invalid arguments";
+        return 2;
+    }
+
+    Tracer::startFromEnvironment();
+    BatchProcessor processor(options);
+    int failed = processor.run();
+    Tracer::finishFromEnvironment();
+    return failed == 0 ? 0 : 1;
+}
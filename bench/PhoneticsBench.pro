@@ -0,0 +1,72 @@
+# Microbenchmarks of the DSP and I/O hot paths as a QTest benchmark (QBENCHMARK), 'make check' runs them.
+# '-json <file>' writes the results as JSON with the machine and build, for comparing builds.
+# The widgets are driven without a window (QT_QPA_PLATFORM=offscreen is the default of the executable).
+
+QT       += core gui widgets charts multimedia concurrent testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = phonetics-bench
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    benchmarkenvironment.cpp \
+    benchmarkreport.cpp \
+    hotpathbench.cpp \
+    syntheticwav.cpp \
+    ../analysiscache.cpp \
+    ../analysispipeline.cpp \
+    ../formanttracker.cpp \
+    ../ltas.cpp \
+    ../memorybudget.cpp \
+    ../mfccextractor.cpp \
+    ../multiresolutionstft.cpp \
+    ../pcmcache.cpp \
+    ../pitchtracker.cpp \
+    ../resampler.cpp \
+    ../spectralslice.cpp \
+    ../spectrogramrenderer.cpp \
+    ../spectrograph.cpp \
+    ../stft.cpp \
+    ../syllablesegmenter.cpp \
+    ../tracer.cpp \
+    ../waveformreducer.cpp \
+    ../waveformsegments.cpp \
+    ../wavfile.cpp \
+    ../wavform.cpp \
+    ../workerpool.cpp
+
+HEADERS += \
+    benchmarkenvironment.h \
+    benchmarkreport.h \
+    hotpathbench.h \
+    syntheticwav.h \
+    ../analysiscache.h \
+    ../analysispipeline.h \
+    ../formanttracker.h \
+    ../ltas.h \
+    ../memorybudget.h \
+    ../mfccextractor.h \
+    ../multiresolutionstft.h \
+    ../pcmcache.h \
+    ../pitchtracker.h \
+    ../resampler.h \
+    ../spectralframes.h \
+    ../spectralslice.h \
+    ../spectrogramrenderer.h \
+    ../spectrograph.h \
+    ../stft.h \
+    ../syllablesegmenter.h \
+    ../tracer.h \
+    ../waveformreducer.h \
+    ../waveformsegments.h \
+    ../wavfile.h \
+    ../wavform.h \
+    ../workerpool.h
+
+# adding the FFTW library
+INCLUDEPATH += /usr/local/include
+LIBS += -L/usr/local/lib -lfftw3
@@ -0,0 +1,25 @@
+#include "benchmarkenvironment.h"
+#include <QLibraryInfo>
+#include <QSysInfo>
+#include <QThread>
+
+/*
+ * File: benchmarkenvironment.cpp
+ * Description:
+ *  This source file implements the 'BenchmarkEnvironment', used by the render benchmark report and the JSON report of
+ *  the microbenchmarks ('BenchmarkReport').
+ */
+
+QJsonObject BenchmarkEnvironment::describe() {
+    QJsonObject environment;
+    environment["qt"] = QLibraryInfo::build();
+#ifdef QT_NO_DEBUG
+    environment["buildType"] = "release";
+#else
+    environment["buildType"] = "debug";
+#endif
+    environment["cpu"] = QSysInfo::currentCpuArchitecture();
+    environment["os"] = QSysInfo::prettyProductName();
+    environment["threads"] = QThread::idealThreadCount();
+    return environment;
+}
@@ -0,0 +1,22 @@
+#ifndef BENCHMARKENVIRONMENT_H
+#define BENCHMARKENVIRONMENT_H
+
+#include <QJsonObject>
+
+/*
+ * File: benchmarkenvironment.h
+ * Description:
+ *  This header file defines the 'BenchmarkEnvironment' class, which describes the machine and build a benchmark ran on
+ *  so reports of different builds can be told apart.
+ *
+ * Public Methods:
+ *  - 'static QJsonObject describe()': Qt build, build type, CPU, OS and thread count
+ */
+
+class BenchmarkEnvironment
+{
+public:
+    static QJsonObject describe();
+};
+
+#endif // BENCHMARKENVIRONMENT_H
@@ -0,0 +1,62 @@
+#include "benchmarkreport.h"
+#include "benchmarkenvironment.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonArray>
+#include <QXmlStreamReader>
+
+/*
+ * File: benchmarkreport.cpp
+ * Description:
+ *  This source file implements 'BenchmarkReport'. The XML logger writes a TestFunction element per case, holding a
+ *  BenchmarkResult element per data row (its value is already divided by the iterations) and an Incident element per
+ *  row that passed or failed.
+ *
+ * References:
+ *  - https://doc.qt.io/qt-6/qtest-overview.html#logging-options
+ */
+
+QJsonDocument BenchmarkReport::fromQTestXml(const QByteArray &xml, const QJsonObject &input) {
+    QJsonArray results;
+    QJsonArray failures;
+    QString function;
+    QXmlStreamReader reader(xml);
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement) continue;
+        QXmlStreamAttributes attributes = reader.attributes();
+        if (reader.name() == QLatin1String("TestFunction")) {
+            function = attributes.value("name").toString();
+        } else if (reader.name() == QLatin1String("BenchmarkResult")) {
+            QJsonObject entry;
+            entry["name"] = function;
+            entry["tag"] = attributes.value("tag").toString();
+            entry["metric"] = attributes.value("metric").toString();
+            entry["value"] = attributes.value("value").toDouble();
+            entry["iterations"] = attributes.value("iterations").toInt();
+            results.append(entry);
+        } else if (reader.name() == QLatin1String("Incident")
+                   && (attributes.value("type") == QLatin1String("fail") || attributes.value("type") == QLatin1String("xpass"))) {
+            QJsonObject entry;
+            entry["name"] = function;
+            entry["file"] = attributes.value("file").toString();
+            entry["line"] = attributes.value("line").toInt();
+            // the row and the message are child elements of the incident
+            while (reader.readNextStartElement()) {
+                if (reader.name() == QLatin1String("DataTag")) entry["tag"] = reader.readElementText();
+                else if (reader.name() == QLatin1String("Description")) entry["description"] = reader.readElementText();
+                else reader.skipCurrentElement();
+            }
+            failures.append(entry);
+        }
+    }
+    if (reader.hasError()) qWarning() << "Bench Error: could not read the QTest log," << reader.errorString();
+
+    QJsonObject report;
+    report["suite"] = "phonetics-bench";
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["environment"] = BenchmarkEnvironment::describe();
+    report["input"] = input;
+    report["results"] = results;
+    report["failures"] = failures;
+    return QJsonDocument(report);
+}
@@ -0,0 +1,29 @@
+#ifndef BENCHMARKREPORT_H
+#define BENCHMARKREPORT_H
+
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+/*
+ * File: benchmarkreport.h
+ * Description:
+ *  This header file defines 'BenchmarkReport', which turns the XML log of a QTest benchmark run into the JSON report the
+ *  benchmarks are compared by across builds.
+ *
+ * Public Methods:
+ *  - 'static QJsonDocument fromQTestXml(const QByteArray &xml, const QJsonObject &input)': One entry per
+ *    BenchmarkResult (case, data row, metric, value per iteration and iterations), the failed rows and the environment,
+ *    in the layout of the render benchmark report (suite, timestamp, environment, input)
+ *
+ * Notes:
+ *  - QTest has loggers for text, XML, JUnit XML, CSV, TAP and TeamCity but none for JSON, the XML one is read back.
+ */
+
+class BenchmarkReport
+{
+public:
+    static QJsonDocument fromQTestXml(const QByteArray &xml, const QJsonObject &input);
+};
+
+#endif // BENCHMARKREPORT_H
@@ -0,0 +1,300 @@
+#include "hotpathbench.h"
+#include <QFile>
+#include <QtTest>
+#include <cmath>
+#include "syntheticwav.h"
+#include "wavfile.h"
+#include "wavform.h"
+#include "spectrograph.h"
+#include "stft.h"
+#include "multiresolutionstft.h"
+#include "spectralslice.h"
+#include "resampler.h"
+#include "waveformsegments.h"
+#include "syllablesegmenter.h"
+#include "ltas.h"
+
+/*
+ * File: hotpathbench.cpp
+ * Description:
+ *  This source file implements the 'HotPathBench'. The file cases have one row per file, the analysis cases one row per
+ *  duration. Inputs are prepared before QBENCHMARK so only the call itself is timed.
+ */
+
+#define BENCH_SAMPLE_RATE 44100
+#define WAVEFORM_HEIGHT 190
+#define DEFAULT_DURATIONS "1,10,60,3600"
+#define ACCURACY_SECONDS 10
+#define ACCURACY_EDGE 0.1 // seconds skipped at both ends, where the filter meets the silence around the track
+
+static const int bitDepths[] = {16, 24, 32};
+static const int channelCounts[] = {1, 2};
+static const int chartWidths[] = {650, 6500, 13000, 130000};
+
+HotPathBench::HotPathBench() = default;
+HotPathBench::~HotPathBench() = default;
+
+QString HotPathBench::fixturePath(int seconds, int bitDepth, int channels) const {
+    return directory.filePath(QString("bench_%1s_%2bit_%3ch.wav").arg(seconds).arg(bitDepth).arg(channels));
+}
+
+QList<int> HotPathBench::configuredDurations() {
+    QList<int> seconds;
+    QString list = qEnvironmentVariable("PHONETICS_BENCH_DURATIONS", DEFAULT_DURATIONS);
+    for (const QString &part : list.split(',', Qt::SkipEmptyParts)) seconds << part.trimmed().toInt();
+    return seconds;
+}
+
+void HotPathBench::initTestCase() {
+    QVERIFY2(directory.isValid(), "no temporary directory for the fixtures");
+
+    durations = configuredDurations();
+    QVERIFY2(!durations.isEmpty(), "PHONETICS_BENCH_DURATIONS has no durations");
+
+    wavForm = std::make_unique<WavForm>(650, 200);
+    spectrograph = std::make_unique<Spectrograph>();
+    spectrograph->resize(650, 250);
+    stft = std::make_unique<Stft>(spectrograph->getWindowSize(), spectrograph->getWindowSize());
+    slice = std::make_unique<SpectralSlice>(stft.get(), BENCH_SAMPLE_RATE);
+
+    for (int seconds : durations) {
+        for (int bitDepth : bitDepths) {
+            for (int channels : channelCounts) {
+                QString path = fixturePath(seconds, bitDepth, channels);
+                QVERIFY2(SyntheticWav::write(path, seconds, BENCH_SAMPLE_RATE, bitDepth, channels), qPrintable("could not write " + path));
+            }
+        }
+
+        // the analyses run on the 16 bit mono file, the spectrogram decodes every file to mono
+        WavFile mono(fixturePath(seconds, 16, 1));
+        QVERIFY2(mono.loadFile(), "could not load the mono fixture");
+        monoFloatSamples[seconds] = mono.getAudioSamples();
+        const QList<float> &samples = monoFloatSamples[seconds];
+        monoSamples[seconds] = QVector<double>(samples.begin(), samples.end());
+        frames[seconds] = stft->compute(monoSamples[seconds], BENCH_SAMPLE_RATE);
+    }
+}
+
+void HotPathBench::addFileRows() {
+    QTest::addColumn<QString>("path");
+    for (int seconds : durations) {
+        for (int bitDepth : bitDepths) {
+            for (int channels : channelCounts) {
+                QTest::addRow("%ds %dbit %dch", seconds, bitDepth, channels) << fixturePath(seconds, bitDepth, channels);
+            }
+        }
+    }
+}
+
+void HotPathBench::addTrackRows() {
+    QTest::addColumn<int>("seconds");
+    for (int seconds : durations) QTest::addRow("%ds", seconds) << seconds;
+}
+
+void HotPathBench::readAll_data() {
+    addFileRows();
+}
+
+void HotPathBench::readAll() {
+    QFETCH(QString, path);
+    QFile input(path);
+    QVERIFY2(input.open(QIODevice::ReadOnly), qPrintable("missing fixture " + path));
+    QVERIFY(input.size() > 0);
+    QBENCHMARK {
+        input.seek(0);
+        input.readAll();
+    }
+}
+
+void HotPathBench::loadFile_data() {
+    addFileRows();
+}
+
+void HotPathBench::loadFile() {
+    QFETCH(QString, path);
+    QVERIFY2(QFile::exists(path), qPrintable("missing fixture " + path));
+    QVERIFY2(WavFile(path).loadFile(), qPrintable("could not load " + path));
+    QBENCHMARK {
+        WavFile wav(path);
+        wav.loadFile();
+    }
+}
+
+void HotPathBench::setChart_data() {
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<int>("width");
+    for (int seconds : durations) {
+        for (int bitDepth : bitDepths) {
+            for (int channels : channelCounts) {
+                for (int width : chartWidths) {
+                    QTest::addRow("%ds %dbit %dch %dpx", seconds, bitDepth, channels, width)
+                        << fixturePath(seconds, bitDepth, channels) << width;
+                }
+            }
+        }
+    }
+}
+
+void HotPathBench::setChart() {
+    QFETCH(QString, path);
+    QFETCH(int, width);
+    WavFile wav(path);
+    QVERIFY2(wav.loadFile(), qPrintable("could not load " + path));
+    QList<float> samples = wav.getAudioSamples();
+    QVERIFY(!samples.isEmpty());
+    QBENCHMARK {
+        wavForm->setChart(samples, width, WAVEFORM_HEIGHT);
+    }
+}
+
+void HotPathBench::stftCompute_data() {
+    addTrackRows();
+}
+
+void HotPathBench::stftCompute() {
+    QFETCH(int, seconds);
+    const QVector<double> &mono = monoSamples[seconds];
+    QBENCHMARK {
+        stft->compute(mono, BENCH_SAMPLE_RATE);
+    }
+}
+
+void HotPathBench::multiResolutionStft_data() {
+    addTrackRows();
+}
+
+void HotPathBench::multiResolutionStft() {
+    QFETCH(int, seconds);
+    const QVector<double> &mono = monoSamples[seconds];
+    QBENCHMARK {
+        MultiResolutionStft displayStft(BENCH_SAMPLE_RATE);
+        displayStft.compute(mono);
+    }
+}
+
+void HotPathBench::spectralSlice_data() {
+    addTrackRows();
+}
+
+void HotPathBench::spectralSlice() {
+    QFETCH(int, seconds);
+    slice->setSamples(monoSamples[seconds], BENCH_SAMPLE_RATE);
+    QVERIFY(slice->computeSlice(0.5));
+    QBENCHMARK {
+        slice->computeSlice(0.5);
+    }
+}
+
+void HotPathBench::setupSpectrograph_data() {
+    addTrackRows();
+}
+
+void HotPathBench::setupSpectrograph() {
+    QFETCH(int, seconds);
+    QVector<double> mono = monoSamples[seconds];
+    QBENCHMARK {
+        spectrograph->reset();
+        spectrograph->setSampleRate(BENCH_SAMPLE_RATE);
+        spectrograph->setupSpectrograph(mono);
+    }
+}
+
+void HotPathBench::renderToPixmap_data() {
+    addTrackRows();
+}
+
+void HotPathBench::renderToPixmap() {
+    QFETCH(int, seconds);
+    QVector<double> mono = monoSamples[seconds];
+    spectrograph->reset();
+    spectrograph->setSampleRate(BENCH_SAMPLE_RATE);
+    spectrograph->setupSpectrograph(mono);
+    QBENCHMARK {
+        spectrograph->renderToPixmap();
+    }
+}
+
+void HotPathBench::resample_data() {
+    addTrackRows();
+}
+
+void HotPathBench::resample() {
+    QFETCH(int, seconds);
+    const QVector<double> &mono = monoSamples[seconds];
+    QBENCHMARK {
+        Resampler::resample(mono, 48000, Resampler::analysisRate);
+    }
+}
+
+void HotPathBench::resamplerAccuracy_data() {
+    QTest::addColumn<int>("inputRate");
+    QTest::addColumn<int>("outputRate");
+    QTest::addColumn<double>("frequency");
+    QTest::addColumn<bool>("passband");
+    QTest::addColumn<double>("maxErrorDb");
+    QTest::addRow("48000 to 44100, 1 kHz") << 48000 << 44100 << 1000.0 << true << -70.0;
+    QTest::addRow("44100 to 48000, 5 kHz") << 44100 << 48000 << 5000.0 << true << -70.0;
+    QTest::addRow("44100 to 47999, 3 kHz (rounded phases)") << 44100 << 47999 << 3000.0 << true << -70.0;
+    QTest::addRow("48000 to 16000, 10 kHz (alias)") << 48000 << 16000 << 10000.0 << false << -80.0;
+}
+
+void HotPathBench::resamplerAccuracy() {
+    QFETCH(int, inputRate);
+    QFETCH(int, outputRate);
+    QFETCH(double, frequency);
+    QFETCH(bool, passband);
+    QFETCH(double, maxErrorDb);
+
+    QVector<double> tone(inputRate * ACCURACY_SECONDS);
+    for (int i = 0; i < tone.size(); ++i) tone[i] = std::sin(2.0 * M_PI * frequency * i / inputRate);
+    QVector<double> output = Resampler::resample(tone, inputRate, outputRate);
+    QCOMPARE(output.size(), outputRate * ACCURACY_SECONDS);
+
+    double maxError = 0.0;
+    int edge = (int) (ACCURACY_EDGE * outputRate);
+    for (int i = edge; i < output.size() - edge; ++i) {
+        double expected = passband ? std::sin(2.0 * M_PI * frequency * i / outputRate) : 0.0;
+        maxError = std::max(maxError, std::abs(output[i] - expected));
+    }
+    double errorDb = 20.0 * std::log10(std::max(maxError, 1e-12));
+    qInfo("%s error %.1f dB", passband ? "passband" : "alias", errorDb);
+    QVERIFY2(errorDb < maxErrorDb, qPrintable(QString("%1 dB is above the limit of %2 dB").arg(errorDb, 0, 'f', 1).arg(maxErrorDb)));
+}
+
+void HotPathBench::autoSegmentPeaks_data() {
+    addTrackRows();
+}
+
+void HotPathBench::autoSegmentPeaks() {
+    QFETCH(int, seconds);
+    const QList<float> &samples = monoFloatSamples[seconds];
+    QBENCHMARK {
+        WaveFormSegments::autoSegmentPeaks(samples, 0, (int) samples.size());
+    }
+}
+
+void HotPathBench::findBoundaries_data() {
+    addTrackRows();
+}
+
+void HotPathBench::findBoundaries() {
+    QFETCH(int, seconds);
+    const SpectralFrames &spectralFrames = frames[seconds];
+    QVERIFY(!spectralFrames.isEmpty());
+    QBENCHMARK {
+        SyllableSegmenter::findBoundaries(spectralFrames, 0.0, 1.0);
+    }
+}
+
+void HotPathBench::ltasCompute_data() {
+    addTrackRows();
+}
+
+void HotPathBench::ltasCompute() {
+    QFETCH(int, seconds);
+    const SpectralFrames &spectralFrames = frames[seconds];
+    QVERIFY(!spectralFrames.isEmpty());
+    QBENCHMARK {
+        Ltas::compute(spectralFrames);
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef HOTPATHBENCH_H
+#define HOTPATHBENCH_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QTemporaryDir>
+#include <QVector>
+#include <memory>
+#include "spectralframes.h"
+
+class WavForm;
+class Spectrograph;
+class Stft;
+class SpectralSlice;
+
+/*
+ * File: hotpathbench.h
+ * Description:
+ *  This header file defines the 'HotPathBench' QTest class, the microbenchmarks of the DSP and I/O hot paths. Every
+ *  case is a QBENCHMARK over the synthetic WAV files 'initTestCase()' writes, so QTest picks the iteration count and
+ *  reports the time per call (walltime by default, -callgrind/-perf/-tickcounter switch the measurer).
+ *
+ * Cases (data rows per file: duration, bit depth and channels, per track: duration):
+ *  - 'readAll': Reading the file alone, the floor for 'WavFile::loadFile'
+ *  - 'loadFile': Header, copy of the data chunk and the sample conversion of 'WavFile::loadFile'
+ *  - 'setChart': Scene of the waveform at each width (650 is the unzoomed view, the widest is zoom 200)
+ *  - 'stftCompute', 'setupSpectrograph', 'renderToPixmap': On the mono track
+ *  - 'multiResolutionStft': Both display resolutions of the mono track in one pass
+ *  - 'spectralSlice': Spectrum and LPC envelope of the frame in the middle, the work of one slice update
+ *  - 'resample': The mono track from 48 kHz to the analysis rate, as a 48 kHz file is converted on load
+ *  - 'resamplerAccuracy': Not timed, the largest error of a resampled tone against the exact tone at the new rate
+ *    (passband) or against silence (a tone above the new Nyquist frequency, aliasing), printed in dB
+ *  - 'autoSegmentPeaks', 'findBoundaries': The work of both 'WaveFormSegments::autoSegment()' modes
+ *  - 'ltasCompute': Long-term average spectrum and statistics of all the frames, the parallel reduction
+ *
+ * Key Members:
+ *  - 'QTemporaryDir directory': The fixture files, removed with the object
+ *  - 'QList<int> durations': Seconds of the tracks, PHONETICS_BENCH_DURATIONS (comma separated, default 1,10,60,3600)
+ *  - 'QHash<int, QVector<double>> monoSamples', 'QHash<int, SpectralFrames> frames': The mono track of each duration
+ *    and its STFT frames, computed once in 'initTestCase()'
+ *
+ * Public Methods:
+ *  - 'static QList<int> configuredDurations()': The durations of PHONETICS_BENCH_DURATIONS, for the report too
+ *
+ * Notes:
+ *  - A fixture that could not be written or opened fails its case instead of timing an empty buffer.
+ *  - The hour long fixtures take about 4.3 GB of temporary disk (six files) and the mono track, its float copy and its
+ *    frames about 2.5 GB of memory. PHONETICS_BENCH_DURATIONS=1,10,60 leaves them out for a quick run.
+ */
+
+class HotPathBench : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir directory;
+    QList<int> durations;
+    QHash<int, QVector<double>> monoSamples;
+    QHash<int, QList<float>> monoFloatSamples;
+    QHash<int, SpectralFrames> frames;
+    std::unique_ptr<WavForm> wavForm;
+    std::unique_ptr<Spectrograph> spectrograph;
+    std::unique_ptr<Stft> stft;
+    std::unique_ptr<SpectralSlice> slice;
+
+    QString fixturePath(int seconds, int bitDepth, int channels) const;
+    void addFileRows();
+    void addTrackRows();
+
+public:
+    HotPathBench();
+    ~HotPathBench();
+    static QList<int> configuredDurations();
+
+private slots:
+    void initTestCase();
+
+    void readAll_data();
+    void readAll();
+    void loadFile_data();
+    void loadFile();
+    void setChart_data();
+    void setChart();
+
+    void stftCompute_data();
+    void stftCompute();
+    void multiResolutionStft_data();
+    void multiResolutionStft();
+    void spectralSlice_data();
+    void spectralSlice();
+    void setupSpectrograph_data();
+    void setupSpectrograph();
+    void renderToPixmap_data();
+    void renderToPixmap();
+    void resample_data();
+    void resample();
+    void resamplerAccuracy_data();
+    void resamplerAccuracy();
+    void autoSegmentPeaks_data();
+    void autoSegmentPeaks();
+    void findBoundaries_data();
+    void findBoundaries();
+    void ltasCompute_data();
+    void ltasCompute();
+};
+
+#endif // HOTPATHBENCH_H
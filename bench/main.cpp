@@ -0,0 +1,86 @@
+#include <QApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "hotpathbench.h"
+#include "benchmarkreport.h"
+
+/*
+ * File: main.cpp (bench)
+ * Description:
+ *  Entry point of 'phonetics-bench', runs the 'HotPathBench' QTest benchmarks. All the QTest options apply, e.g.
+ *
+ *      phonetics-bench -json results.json
+ *      PHONETICS_BENCH_DURATIONS=1,10,60 phonetics-bench -o results.xml,xml
+ *      phonetics-bench -callgrind stftCompute:10s
+ *
+ *  '-json <file>' (- for stdout) adds an XML logger to a temporary file and writes it as the JSON report of
+ *  'BenchmarkReport' once the run is over, the report builds are compared by. The text log still goes to stdout unless
+ *  other -o loggers are given or the report goes there.
+ *
+ * Notes:
+ *  - Runs with QT_QPA_PLATFORM=offscreen unless the variable is set, no display is needed.
+ *  - With -json the other loggers need the 'file,format' form of -o, QTest takes a plain '-o file' only on its own.
+ */
+
+int main(int argc, char *argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("phonetics-bench");
+
+    // -json is ours, everything else goes to QTest
+    QStringList arguments;
+    QString jsonPath;
+    bool hasLogger = false;
+    for (int i = 0; i < argc; ++i) {
+        QString argument = QString::fromLocal8Bit(argv[i]);
+        if (argument == "-json" && i + 1 < argc) {
+            jsonPath = QString::fromLocal8Bit(argv[++i]);
+            continue;
+        }
+        if (argument == "-o") hasLogger = true;
+        arguments << argument;
+    }
+
+    QTemporaryDir logDirectory;
+    QString xmlPath = logDirectory.filePath("results.xml");
+    if (!jsonPath.isEmpty()) {
+        if (!logDirectory.isValid()) {
+            qWarning() << "Bench Error: no temporary directory for the QTest log";
+            return 1;
+        }
+        if (!hasLogger && jsonPath != "-") arguments << "-o" << "-,txt"; // stdout is the report's otherwise
+        arguments << "-o" << xmlPath + ",xml";
+    }
+
+    HotPathBench bench;
+    int failures = QTest::qExec(&bench, arguments);
+    if (jsonPath.isEmpty()) return failures;
+
+    QFile log(xmlPath);
+    if (!log.open(QIODevice::ReadOnly)) {
+        qWarning() << "Bench Error: could not read the QTest log" << xmlPath;
+        return 1;
+    }
+    QJsonObject input;
+    QJsonArray durations;
+    for (int seconds : HotPathBench::configuredDurations()) durations.append(seconds);
+    input["durations"] = durations;
+    QByteArray json = BenchmarkReport::fromQTestXml(log.readAll(), input).toJson();
+
+    QFile output;
+    bool opened;
+    if (jsonPath == "-") {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    } else {
+        output.setFileName(jsonPath);
+        opened = output.open(QIODevice::WriteOnly);
+    }
+    if (!opened || output.write(json) != json.size()) {
+        qWarning() << "Bench Error: could not write" << jsonPath;
+        return 1;
+    }
+    return failures;
+}
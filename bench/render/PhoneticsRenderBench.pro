@@ -0,0 +1,77 @@
+# Offscreen render benchmark: replays scripted sessions on the waveform, spectrogram and segment graph widgets and
+# reports per-frame time, scene item counts and peak memory as JSON. Runs with QT_QPA_PLATFORM=offscreen.
+
+QT       += core gui widgets charts multimedia concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = phonetics-render-bench
+
+INCLUDEPATH += .. ../..
+
+SOURCES += \
+    main.cpp \
+    renderscript.cpp \
+    sessionrecorder.cpp \
+    ../benchmarkenvironment.cpp \
+    ../syntheticwav.cpp \
+    ../../analysiscache.cpp \
+    ../../analysispipeline.cpp \
+    ../../formanttracker.cpp \
+    ../../ltas.cpp \
+    ../../memorybudget.cpp \
+    ../../mfccextractor.cpp \
+    ../../multiresolutionstft.cpp \
+    ../../pcmcache.cpp \
+    ../../pitchtracker.cpp \
+    ../../resampler.cpp \
+    ../../segmentgraph.cpp \
+    ../../spectralslice.cpp \
+    ../../spectrogramrenderer.cpp \
+    ../../spectrograph.cpp \
+    ../../stft.cpp \
+    ../../syllablesegmenter.cpp \
+    ../../tracer.cpp \
+    ../../waveformreducer.cpp \
+    ../../waveformsegments.cpp \
+    ../../wavfile.cpp \
+    ../../wavform.cpp \
+    ../../workerpool.cpp \
+    ../../zoom.cpp
+
+HEADERS += \
+    renderscript.h \
+    sessionrecorder.h \
+    ../benchmarkenvironment.h \
+    ../syntheticwav.h \
+    ../../analysiscache.h \
+    ../../analysispipeline.h \
+    ../../formanttracker.h \
+    ../../ltas.h \
+    ../../memorybudget.h \
+    ../../mfccextractor.h \
+    ../../multiresolutionstft.h \
+    ../../pcmcache.h \
+    ../../pitchtracker.h \
+    ../../resampler.h \
+    ../../segmentgraph.h \
+    ../../spectralframes.h \
+    ../../spectralslice.h \
+    ../../spectrogramrenderer.h \
+    ../../spectrograph.h \
+    ../../stft.h \
+    ../../syllablesegmenter.h \
+    ../../tracer.h \
+    ../../waveformreducer.h \
+    ../../waveformsegments.h \
+    ../../wavfile.h \
+    ../../wavform.h \
+    ../../workerpool.h \
+    ../../zoom.h
+
+RESOURCES += ../../resources.qrc
+
+# adding the FFTW library
+INCLUDEPATH += /usr/local/include
+LIBS += -L/usr/local/lib -lfftw3
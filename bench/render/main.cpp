@@ -0,0 +1,77 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QDebug>
+#include "renderscript.h"
+#include "syntheticwav.h"
+
+/*
+ * File: main.cpp (render bench)
+ * Description:
+ *  Entry point of 'phonetics-render-bench'. Writes a synthetic WAV file (or takes one with --file), replays the
+ *  'RenderScript' session on it offscreen and prints the per phase frame times, scene item counts and memory as JSON.
+ *
+ *      phonetics-render-bench [--seconds 60] [--ticks 1000] [--frames] [-o results.json]
+ *
+ *  Exits with 1 if the file could not be loaded or an auto segmentation did not finish.
+ */
+
+#define BENCH_SAMPLE_RATE 44100
+
+int main(int argc, char *argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("phonetics-render-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a scripted session on the widgets offscreen and prints frame times, scene sizes and memory as JSON.");
+    parser.addHelpOption();
+    QCommandLineOption secondsOption("seconds", "Length of the synthetic track.", "seconds", "60");
+    QCommandLineOption depthOption("bit-depth", "Bit depth of the synthetic track.", "bits", "16");
+    QCommandLineOption channelsOption("channels", "Channels of the synthetic track.", "count", "1");
+    QCommandLineOption fileOption("file", "Use this WAV file instead of a synthetic one (its rate and channels must be given).", "path");
+    QCommandLineOption rateOption("sample-rate", "Sample rate of --file.", "hz", QString::number(BENCH_SAMPLE_RATE));
+    QCommandLineOption ticksOption("ticks", "Scrubber ticks of the playback phase (10 ms each).", "count", "1000");
+    QCommandLineOption framesOption("frames", "Include every frame in the report, not only the phase summaries.");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Write the JSON report to this file instead of stdout.", "file");
+    parser.addOptions({secondsOption, depthOption, channelsOption, fileOption, rateOption, ticksOption, framesOption, outputOption});
+    parser.process(app);
+
+    int channels = std::max(parser.value(channelsOption).toInt(), 1);
+    int sampleRate = parser.value(rateOption).toInt();
+    QJsonObject input;
+    QTemporaryDir directory;
+    QString path = parser.value(fileOption);
+    if (path.isEmpty()) {
+        double seconds = parser.value(secondsOption).toDouble();
+        int bitDepth = parser.value(depthOption).toInt();
+        path = directory.filePath("render_bench.wav");
+        if (!directory.isValid() || !SyntheticWav::write(path, seconds, sampleRate, bitDepth, channels)) return 1;
+        input["seconds"] = seconds;
+        input["bitDepth"] = bitDepth;
+    } else {
+        input["file"] = path;
+    }
+    input["sampleRate"] = sampleRate;
+    input["channels"] = channels;
+    input["ticks"] = parser.value(ticksOption).toInt();
+
+    RenderScript script;
+    bool ok = script.run(path, sampleRate, channels, parser.value(ticksOption).toInt());
+
+    QByteArray json = script.getRecorder().report(input, parser.isSet(framesOption)).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly) || output.write(json) != json.size()) {
+            qWarning() << "Bench Error: could not write" << output.fileName();
+            return 1;
+        }
+    } else {
+        QFile output;
+        output.open(stdout, QIODevice::WriteOnly);
+        output.write(json);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+#include "renderscript.h"
+#include <QBoxLayout>
+#include <QChartView>
+#include <QXYSeries>
+#include <QEventLoop>
+#include <QGraphicsView>
+#include <QMouseEvent>
+#include <QTimer>
+#include <QDebug>
+
+/*
+ * File: renderscript.cpp
+ * Description:
+ *  This source file implements the 'RenderScript'. Sizes match 'Audio' (waveform and segment graph 400 x 200) and the
+ *  'Spectrograph' (650 x 200). Clicks are sent to the waveform's viewport as mouse events, so they take the same path
+ *  as a user's.
+ */
+
+#define VIEW_WIDTH 400
+#define VIEW_HEIGHT 200
+#define ZOOM_STEPS 200
+#define SEGMENT_START 0.25
+#define SEGMENT_END 0.5
+#define INTERVAL_PIXELS 10.0
+#define MAX_BROWSED_SEGMENTS 100
+#define AUTO_SEGMENT_TIMEOUT_MS 60000
+#define LOAD_TIMEOUT_MS 60000
+#define TICK_SECONDS 0.01
+
+RenderScript::RenderScript()
+    : wavForm(VIEW_WIDTH, VIEW_HEIGHT), zoom(nullptr, VIEW_WIDTH, VIEW_HEIGHT), segmentGraph(VIEW_WIDTH, VIEW_HEIGHT),
+      recorder(&container)
+{
+    horizontalSlider.setOrientation(Qt::Horizontal);
+    horizontalSlider.setRange(1, ZOOM_STEPS);
+    verticalSlider.setOrientation(Qt::Vertical);
+    verticalSlider.setRange(1, 10);
+    zoom.setHorizontalSlider(&horizontalSlider);
+    zoom.setVerticalSlider(&verticalSlider);
+
+    QObject::connect(&zoom, &Zoom::zoomGraphIn, &wavForm, &WavForm::updateChart);
+    QObject::connect(&wavForm, &WavForm::intervalsForSegments, &segments, &WaveFormSegments::collectWavSegment);
+    QObject::connect(&segments, &WaveFormSegments::createWavSegmentGraphs, &segmentGraph, &SegmentGraph::updateGraphs);
+    QObject::connect(&segments, &WaveFormSegments::storeStartEndValuesOfSegments, &segmentGraph, &SegmentGraph::getSegmentStartEnd);
+    QObject::connect(&segments, &WaveFormSegments::drawAutoSegments, &wavForm, &WavForm::drawAutoIntervals);
+    QObject::connect(&wavForm, &WavForm::clearAllSegmentInfo, &segmentGraph, &SegmentGraph::clearView);
+    QObject::connect(&wavForm, &WavForm::clearAllSegmentInfo, &segments, &WaveFormSegments::clearAllWavSegments);
+
+    QVBoxLayout *layout = new QVBoxLayout(&container);
+    QHBoxLayout *chartLayout = new QHBoxLayout();
+    chartLayout->addWidget(&wavForm);
+    chartLayout->addWidget(&verticalSlider);
+    chartLayout->addWidget(&segmentGraph);
+    layout->addLayout(chartLayout);
+    layout->addWidget(&horizontalSlider);
+    layout->addWidget(&spectrograph);
+    container.resize(1100, 700);
+    container.show();
+
+    recorder.setCounters([this]() { return counters(); });
+}
+
+QJsonObject RenderScript::counters() const {
+    QJsonObject values;
+    values["wavFormItems"] = wavForm.scene()->items().size();
+    const QGraphicsView *spectrogramView = spectrograph.findChild<QGraphicsView*>();
+    values["spectrographItems"] = spectrogramView ? spectrogramView->scene()->items().size() : 0;
+
+    qint64 points = 0;
+    for (const QChartView *view : segmentGraph.findChildren<QChartView*>()) {
+        if (!view->chart()) continue;
+        for (const QAbstractSeries *series : view->chart()->series()) {
+            if (const QXYSeries *line = qobject_cast<const QXYSeries*>(series)) points += line->count();
+        }
+    }
+    values["segmentGraphPoints"] = points;
+    return values;
+}
+
+void RenderScript::click(double proportion) {
+    QRectF scene = wavForm.sceneRect();
+    QPoint position = wavForm.mapFromScene(QPointF(scene.left() + proportion * scene.width(), scene.height() / 2));
+    QMouseEvent press(QEvent::MouseButtonPress, position, wavForm.viewport()->mapToGlobal(position),
+                      Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(wavForm.viewport(), &press);
+}
+
+bool RenderScript::autoSegment(const QString &phase, WaveFormSegments::AutoSegmentMode mode) {
+    bool drawn = false;
+    recorder.beginPhase(phase);
+    recorder.frame([&]() {
+        QEventLoop loop;
+        QMetaObject::Connection done = QObject::connect(&segments, &WaveFormSegments::drawAutoSegments, &loop, [&]() {
+            drawn = true;
+            loop.quit();
+        });
+        QTimer::singleShot(AUTO_SEGMENT_TIMEOUT_MS, &loop, &QEventLoop::quit);
+        segments.setAutoSegmentMode(mode);
+        wavForm.changeBoolAutoSegment(true); // sends the selection to the segmenter
+        if (!drawn) loop.exec();
+        QObject::disconnect(done);
+    });
+    recorder.endPhase();
+    if (!drawn) qWarning() << "Bench Error: auto segmentation did not finish in" << phase;
+    return drawn;
+}
+
+bool RenderScript::run(const QString &path, int sampleRate, int channels, int playbackTicks) {
+    recorder.beginPhase("upload");
+    recorder.frame([&]() {
+        // the file is read on a worker thread, the upload frame lasts until it is drawn
+        QEventLoop loop;
+        bool loaded = false;
+        QMetaObject::Connection done = QObject::connect(&wavForm, &WavForm::audioFileLoadedTrue, &loop, [&]() {
+            loaded = true;
+            loop.quit();
+        });
+        QTimer::singleShot(LOAD_TIMEOUT_MS, &loop, &QEventLoop::quit);
+        wavForm.uploadAudio(path);
+        if (!loaded) loop.exec();
+        QObject::disconnect(done);
+
+        QList<float> samples = wavForm.getSamples();
+        segments.uploadAudio(samples);
+        zoom.resetZoom();
+
+        // the spectrograph decodes to mono, average the channels the same way
+        QVector<double> mono(samples.size() / channels);
+        for (qsizetype i = 0; i < mono.size(); ++i) {
+            double sum = 0.0;
+            for (int channel = 0; channel < channels; ++channel) sum += samples[i * channels + channel];
+            mono[i] = sum / channels;
+        }
+        spectrograph.reset();
+        spectrograph.setSampleRate(sampleRate);
+        spectrograph.setupSpectrograph(mono);
+        segments.setSpectralFrames(spectrograph.getSpectralFrames());
+    });
+    recorder.endPhase();
+    if (wavForm.getSamples().isEmpty()) {
+        qWarning() << "Bench Error: could not load" << path;
+        return false;
+    }
+
+    recorder.beginPhase("zoomSweep");
+    for (int position = 1; position <= ZOOM_STEPS; ++position) {
+        recorder.frame([&]() { zoom.horizontalZoom(position); });
+    }
+    recorder.endPhase();
+
+    recorder.beginPhase("zoomReset");
+    recorder.frame([&]() { zoom.resetZoom(); });
+    recorder.endPhase();
+
+    recorder.beginPhase("segment");
+    wavForm.switchMouseEventControls(true);
+    recorder.frame([&]() { click(SEGMENT_START); });
+    recorder.frame([&]() { click(SEGMENT_END); });
+    recorder.frame([&]() { wavForm.updateDelta(INTERVAL_PIXELS); });
+    recorder.frame([&]() {
+        wavForm.changeBoolAutoSegment(false);
+        wavForm.sendIntervalsForSegment();
+    });
+    recorder.endPhase();
+
+    recorder.beginPhase("segmentBrowse");
+    QSlider *segmentSlider = segmentGraph.findChild<QSlider*>();
+    int segmentCount = segmentSlider ? std::min(segmentSlider->maximum() + 1, MAX_BROWSED_SEGMENTS) : 0;
+    for (int position = 0; position < segmentCount; ++position) {
+        recorder.frame([&]() { segmentGraph.slideSegments(position); });
+    }
+    recorder.endPhase();
+
+    bool ok = autoSegment("autoSegmentPeaks", WaveFormSegments::PeakSegments);
+    ok = autoSegment("autoSegmentSyllables", WaveFormSegments::SyllableSegments) && ok;
+
+    recorder.beginPhase("playback");
+    wavForm.switchMouseEventControls(false);
+    double seconds = (double) wavForm.getSamples().size() / channels / sampleRate;
+    for (int tick = 0; tick < playbackTicks; ++tick) {
+        double position = seconds > 0.0 ? std::min(tick * TICK_SECONDS / seconds, 1.0) : 0.0;
+        recorder.frame([&]() { wavForm.updateScrubberPosition(position); });
+    }
+    recorder.endPhase();
+    return ok;
+}
@@ -0,0 +1,63 @@
+#ifndef RENDERSCRIPT_H
+#define RENDERSCRIPT_H
+
+#include <QWidget>
+#include <QSlider>
+#include <QString>
+#include "sessionrecorder.h"
+#include "wavform.h"
+#include "spectrograph.h"
+#include "segmentgraph.h"
+#include "waveformsegments.h"
+#include "zoom.h"
+
+/*
+ * File: renderscript.h
+ * Description:
+ *  This header file defines the 'RenderScript' class, which builds the waveform, spectrogram and segment graph widgets
+ *  connected the way 'Audio' connects them and replays a scripted session on them, timed by its 'SessionRecorder'.
+ *
+ * Session (one phase each):
+ *  - 'upload': Loads the file into the waveform and the segmenter, computes and draws the spectrogram
+ *  - 'zoomSweep': Horizontal zoom 1 to 200, one frame per slider step
+ *  - 'zoomReset': Back to zoom 1
+ *  - 'segment': Start and end line clicks, interval lines, creating the segment graphs
+ *  - 'segmentBrowse': Slides through the segment graphs (the QLineSeries of each is built here)
+ *  - 'autoSegmentPeaks', 'autoSegmentSyllables': Auto segmentation of the selection in both modes, until drawn
+ *  - 'playback': Scrubber ticks at the 10 ms rate of the 'Audio' timer
+ *
+ * Public Methods:
+ *  - 'RenderScript()': Builds and shows the window
+ *  - 'const SessionRecorder &getRecorder() const': The frames recorded by run()
+ *  - 'bool run(const QString &path, int sampleRate, int channels, int playbackTicks)': Replays the session on a WAV file
+ *  - 'QJsonObject counters() const': Scene items of the waveform and spectrogram, points of the segment graph
+ *
+ * Notes:
+ *  - The spectrogram is computed from the samples with 'setupSpectrograph', the QAudioDecoder path needs a multimedia
+ *    backend that headless machines often do not have.
+ */
+
+class RenderScript
+{
+    QWidget container;
+    QSlider horizontalSlider;
+    QSlider verticalSlider;
+    WavForm wavForm;
+    Zoom zoom;
+    Spectrograph spectrograph;
+    SegmentGraph segmentGraph;
+    WaveFormSegments segments;
+    SessionRecorder recorder;
+
+    void click(double proportion);
+    bool autoSegment(const QString &phase, WaveFormSegments::AutoSegmentMode mode);
+
+public:
+    RenderScript();
+
+    const SessionRecorder &getRecorder() const { return recorder; }
+    bool run(const QString &path, int sampleRate, int channels, int playbackTicks);
+    QJsonObject counters() const;
+};
+
+#endif // RENDERSCRIPT_H
@@ -0,0 +1,125 @@
+#include "sessionrecorder.h"
+#include "benchmarkenvironment.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+/*
+ * File: sessionrecorder.cpp
+ * Description:
+ *  This source file implements the 'SessionRecorder'. Memory comes from getrusage (peak) and /proc/self/statm
+ *  (current, Linux only), other systems report -1.
+ */
+
+SessionRecorder::SessionRecorder(QWidget *_window)
+    : window(_window)
+{
+}
+
+void SessionRecorder::setCounters(std::function<QJsonObject()> _counters) {
+    counters = _counters;
+}
+
+void SessionRecorder::beginPhase(const QString &name) {
+    phases.append(Phase());
+    phases.last().name = name;
+}
+
+void SessionRecorder::endPhase() {
+    if (phases.isEmpty()) return;
+    Phase &phase = phases.last();
+    phase.peakResidentKilobytes = peakResidentKilobytes();
+    phase.residentKilobytes = residentKilobytes();
+
+    double total = 0.0;
+    for (const Frame &frame : phase.frames) total += frame.milliseconds;
+    qInfo().noquote() << phase.name << phase.frames.size() << "frames" << QString::number(total, 'f', 1) << "ms";
+}
+
+void SessionRecorder::addFrame(double milliseconds) {
+    if (phases.isEmpty()) beginPhase("unnamed");
+    phases.last().frames.append({milliseconds, counters ? counters() : QJsonObject()});
+}
+
+static double percentile(QVector<double> values, double fraction) {
+    if (values.isEmpty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    int index = std::min<int>(values.size() - 1, (int) std::ceil(fraction * values.size()) - 1);
+    return values[std::max(index, 0)];
+}
+
+QJsonDocument SessionRecorder::report(const QJsonObject &input, bool includeFrames) const {
+    QJsonArray phaseEntries;
+    for (const Phase &phase : phases) {
+        QVector<double> milliseconds;
+        QJsonObject maxCounters;
+        QJsonArray frameEntries;
+        for (const Frame &frame : phase.frames) {
+            milliseconds << frame.milliseconds;
+            for (auto it = frame.counters.begin(); it != frame.counters.end(); ++it) {
+                maxCounters[it.key()] = std::max(maxCounters.value(it.key()).toDouble(), it.value().toDouble());
+            }
+            if (includeFrames) {
+                QJsonObject entry = frame.counters;
+                entry["ms"] = frame.milliseconds;
+                frameEntries.append(entry);
+            }
+        }
+
+        QJsonObject entry;
+        entry["name"] = phase.name;
+        entry["frames"] = phase.frames.size();
+        entry["totalMs"] = std::accumulate(milliseconds.begin(), milliseconds.end(), 0.0);
+        entry["medianMs"] = percentile(milliseconds, 0.5);
+        entry["p95Ms"] = percentile(milliseconds, 0.95);
+        entry["maxMs"] = percentile(milliseconds, 1.0);
+        entry["countersAtEnd"] = phase.frames.isEmpty() ? QJsonObject() : phase.frames.last().counters;
+        entry["countersMax"] = maxCounters;
+        entry["peakResidentKb"] = phase.peakResidentKilobytes;
+        entry["residentKb"] = phase.residentKilobytes;
+        if (includeFrames) entry["frameList"] = frameEntries;
+        phaseEntries.append(entry);
+    }
+
+    QJsonObject report;
+    report["suite"] = "phonetics-render-bench";
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["environment"] = BenchmarkEnvironment::describe();
+    report["input"] = input;
+    report["phases"] = phaseEntries;
+    return QJsonDocument(report);
+}
+
+qint64 SessionRecorder::peakResidentKilobytes() {
+#ifdef Q_OS_UNIX
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef Q_OS_MACOS
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+qint64 SessionRecorder::residentKilobytes() {
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) return -1;
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2) return -1;
+    return fields[1].toLongLong() * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return -1;
+#endif
+}
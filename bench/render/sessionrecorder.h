@@ -0,0 +1,78 @@
+#ifndef SESSIONRECORDER_H
+#define SESSIONRECORDER_H
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QString>
+#include <QVector>
+#include <QWidget>
+#include <functional>
+
+/*
+ * File: sessionrecorder.h
+ * Description:
+ *  This header file defines the 'SessionRecorder' class, which times the frames of a scripted session on a window and
+ *  groups them into phases (upload, zoom sweep, ...).
+ *
+ * Public Methods:
+ *  - 'SessionRecorder(QWidget *window)': Every frame ends with a synchronous repaint of the window
+ *  - 'void setCounters(std::function<QJsonObject()> counters)': Scene item counts etc., sampled after every frame
+ *  - 'void beginPhase(const QString &name)' / 'void endPhase()': Frames in between belong to the phase
+ *  - 'void frame(Action action)': Runs the action, delivers the events it posted, repaints and records the time
+ *  - 'QJsonDocument report(const QJsonObject &input, bool includeFrames) const': Per phase frame count, total, median,
+ *    95th percentile and max milliseconds, the counters at the end and their maximum, and the memory after the phase
+ *  - 'static qint64 peakResidentKilobytes()', 'static qint64 residentKilobytes()': Process memory, -1 where unknown
+ *
+ * Notes:
+ *  - A frame is what the user waits for after one input: the slot it triggers, the queued events and the paint.
+ *  - Peak memory is the high-water mark of the process since it started, it only grows from phase to phase.
+ */
+
+class SessionRecorder
+{
+    struct Frame
+    {
+        double milliseconds;
+        QJsonObject counters;
+    };
+
+    struct Phase
+    {
+        QString name;
+        QVector<Frame> frames;
+        qint64 peakResidentKilobytes = -1;
+        qint64 residentKilobytes = -1;
+    };
+
+    QWidget *window;
+    std::function<QJsonObject()> counters;
+    QVector<Phase> phases;
+
+    void addFrame(double milliseconds);
+
+public:
+    explicit SessionRecorder(QWidget *window);
+
+    void setCounters(std::function<QJsonObject()> counters);
+    void beginPhase(const QString &name);
+    void endPhase();
+
+    template<typename Action>
+    void frame(Action action) {
+        QElapsedTimer timer;
+        timer.start();
+        action();
+        QCoreApplication::processEvents();
+        window->repaint();
+        addFrame(timer.nsecsElapsed() / 1.0e6);
+    }
+
+    QJsonDocument report(const QJsonObject &input, bool includeFrames) const;
+
+    static qint64 peakResidentKilobytes();
+    static qint64 residentKilobytes();
+};
+
+#endif // SESSIONRECORDER_H
@@ -0,0 +1,96 @@
+#include "syntheticwav.h"
+#include <QFile>
+#include <QByteArray>
+#include <QtEndian>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+/*
+ * File: syntheticwav.cpp
+ * Description:
+ *  This source file implements 'SyntheticWav'. The header is the canonical 44 byte RIFF/WAVE header with a 16 byte
+ *  fmt chunk, format 1 (PCM) for 16 and 24 bit and format 3 (IEEE float) for 32 bit, as 'WavFile' expects.
+ *
+ * References:
+ *  - WAV File Format Basics: https://docs.fileformat.com/audio/wav/
+ */
+
+#define FUNDAMENTAL_HZ 120.0
+#define SYLLABLE_HZ 4.0
+#define HARMONICS 20
+#define NOISE_LEVEL 0.01
+#define PEAK_LEVEL 0.5
+
+bool SyntheticWav::write(const QString &path, double seconds, int sampleRate, int bitDepth, int channels) {
+    if (bitDepth != 16 && bitDepth != 24 && bitDepth != 32) {
+        qWarning() << "Bench Error: unsupported bit depth" << bitDepth;
+        return false;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Bench Error: could not write" << path;
+        return false;
+    }
+
+    int bytesPerSample = bitDepth / 8;
+    qint64 frames = qRound64(seconds * sampleRate);
+    quint32 dataSize = quint32(frames * channels * bytesPerSample);
+
+    QByteArray header(44, '\0');
+    uchar *h = reinterpret_cast<uchar*>(header.data());
+    memcpy(h, "RIFF", 4);
+    qToLittleEndian<quint32>(36 + dataSize, h + 4);
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);
+    qToLittleEndian<quint32>(16, h + 16);
+    qToLittleEndian<quint16>(bitDepth == 32 ? 3 : 1, h + 20);
+    qToLittleEndian<quint16>(channels, h + 22);
+    qToLittleEndian<quint32>(sampleRate, h + 24);
+    qToLittleEndian<quint32>(sampleRate * channels * bytesPerSample, h + 28);
+    qToLittleEndian<quint16>(channels * bytesPerSample, h + 32);
+    qToLittleEndian<quint16>(bitDepth, h + 34);
+    memcpy(h + 36, "data", 4);
+    qToLittleEndian<quint32>(dataSize, h + 40);
+    file.write(header);
+
+    quint32 noiseState = 12345;
+    QByteArray block;
+    for (qint64 start = 0; start < frames; start += sampleRate) {
+        qint64 count = std::min<qint64>(sampleRate, frames - start);
+        block.resize(count * channels * bytesPerSample);
+        uchar *out = reinterpret_cast<uchar*>(block.data());
+
+        for (qint64 i = 0; i < count; ++i) {
+            double t = double(start + i) / sampleRate;
+            double voice = 0.0;
+            for (int k = 1; k <= HARMONICS; ++k) voice += std::sin(2.0 * M_PI * FUNDAMENTAL_HZ * k * t) / k;
+            double envelope = std::pow(std::sin(M_PI * SYLLABLE_HZ * t), 2.0);
+            noiseState = noiseState * 1664525u + 1013904223u; // LCG, the same noise on every run
+            double noise = (noiseState / 4294967296.0 - 0.5) * 2.0 * NOISE_LEVEL;
+            double value = PEAK_LEVEL * envelope * voice / 3.6 + noise; // the harmonic sum peaks at about 3.6
+
+            for (int channel = 0; channel < channels; ++channel) {
+                double sample = channel == 0 ? value : 0.8 * value;
+                if (bitDepth == 16) {
+                    qToLittleEndian<qint16>(qint16(qBound(-32768.0, std::round(sample * 32768.0), 32767.0)), out);
+                } else if (bitDepth == 24) {
+                    qint32 pcm = qint32(qBound(-8388608.0, std::round(sample * 8388608.0), 8388607.0));
+                    out[0] = uchar(pcm);
+                    out[1] = uchar(pcm >> 8);
+                    out[2] = uchar(pcm >> 16);
+                } else {
+                    qToLittleEndian<float>(float(sample), out);
+                }
+                out += bytesPerSample;
+            }
+        }
+        if (file.write(block) != block.size()) {
+            qWarning() << "Bench Error: could not write" << path;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef SYNTHETICWAV_H
+#define SYNTHETICWAV_H
+
+#include <QString>
+
+/*
+ * File: syntheticwav.h
+ * Description:
+ *  This header file defines 'SyntheticWav', which writes reproducible speech-like WAV files for the benchmarks.
+ *
+ * Purpose:
+ *  - Gives every benchmark run the same input without shipping large recordings
+ *
+ * Public Methods:
+ *  - 'static bool write(const QString &path, double seconds, int sampleRate, int bitDepth, int channels)': Writes a
+ *    PCM (16/24 bit) or float (32 bit) file, the layout 'WavFile' reads (44 byte header)
+ *
+ * Notes:
+ *  - The signal is a 120 Hz harmonic tone with a 4 Hz syllable envelope plus a little noise from a fixed seed, so the
+ *    auto segmentation and the spectrogram have something to find. The second channel is the first at 80% level.
+ *  - Written one second at a time, an hour long file never has to fit in memory twice.
+ */
+
+class SyntheticWav
+{
+public:
+    static bool write(const QString &path, double seconds, int sampleRate, int bitDepth, int channels);
+};
+
+#endif // SYNTHETICWAV_H
@@ -0,0 +1,184 @@
+#include "dtwaligner.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+/*
+ * File: dtwaligner.cpp
+ * Description:
+ *  This source file implements the 'DtwAligner'. Row i of the cost matrix (speaker frame i) only covers the user frames
+ *  within bandRadius of the band center, so every row is a short contiguous run. Only two rows of accumulated costs are
+ *  kept, the step taken into every cell is stored as one byte for the backtracking.
+ *
+ * Key Methods:
+ *  - 'align()':
+ *      1. computes the local distances of all band cells in parallel (blocks of rows on the global thread pool), the
+ *         distance between two frames is the squared euclidean distance of their MFCCs without c0 (loudness)
+ *      2. for every row takes the minimum of the diagonal and vertical predecessors in one flat loop over the band,
+ *         then a single sweep adds the horizontal predecessor, the only part that depends on the previous cell
+ *      3. backtracks from the last cell and averages the user frames matched to every speaker frame
+ *  - 'WarpPath::mapProportion()': Speaker proportion to fractional speaker frame, linear interpolation of the mapping,
+ *    user frame back to a proportion
+ *
+ * Notes:
+ *  - The distance and minimum loops are plain float loops over contiguous memory that the compiler vectorizes,
+ *    the frame-major MFCC layout keeps the coefficients of one frame next to each other.
+ *  - A minute of speech is about 2600 frames, with the default band that is around a million cells, a few MB.
+ */
+
+#define FIRST_COEFFICIENT 1 // c0 is the frame energy, recordings at different levels should still match
+#define BAND_FRACTION 0.2 // band radius as a share of the longer track, learners can drift a lot from the speaker's timing
+#define MIN_BAND_FRAMES 20
+#define MAX_BAND_FRAMES 400
+#define ROWS_PER_TASK 64
+
+enum Step : quint8 { Diagonal, Vertical, Horizontal };
+
+WarpPath DtwAligner::align(const MfccFeatures &speaker, const MfccFeatures &user) {
+    WarpPath path;
+    path.speakerHopSize = speaker.hopSize;
+    path.speakerNumSamples = speaker.numSamples;
+    path.userHopSize = user.hopSize;
+    path.userNumSamples = user.numSamples;
+
+    int n = speaker.frameCount();
+    int m = user.frameCount();
+    if (speaker.isEmpty() || user.isEmpty() || n == 0 || m == 0 || speaker.coefficientCount != user.coefficientCount) {
+        return path;
+    }
+
+    int coefficients = speaker.coefficientCount;
+    int slope = (m + n - 1) / n; // columns the band center moves per row at most
+    int bandRadius = std::clamp((int) (BAND_FRACTION * std::max(n, m)), MIN_BAND_FRAMES, MAX_BAND_FRAMES);
+    bandRadius = std::max(bandRadius, slope + 1); // neighbouring rows have to overlap
+    int bandWidth = 2 * bandRadius + 1;
+
+    QVector<int> rowStart(n);
+    QVector<int> rowEnd(n); // inclusive
+    for (int i = 0; i < n; ++i) {
+        int center = n > 1 ? (int) std::llround((double) i * (m - 1) / (n - 1)) : 0;
+        rowStart[i] = std::max(0, center - bandRadius);
+        rowEnd[i] = std::min(m - 1, center + bandRadius);
+    }
+
+    // local distances of every band cell, row i at distances[i * bandWidth]
+    QVector<float> distances((qsizetype) n * bandWidth);
+    float *distanceData = distances.data();
+    QVector<int> blocks;
+    for (int firstRow = 0; firstRow < n; firstRow += ROWS_PER_TASK) blocks << firstRow;
+    QtConcurrent::blockingMap(blocks, [&](int firstRow) {
+        int lastRow = std::min(firstRow + ROWS_PER_TASK, n);
+        for (int i = firstRow; i < lastRow; ++i) {
+            const float *a = speaker.frame(i);
+            float *row = distanceData + (qsizetype) i * bandWidth;
+            for (int j = rowStart[i]; j <= rowEnd[i]; ++j) {
+                const float *b = user.frame(j);
+                float sum = 0.0f;
+                for (int c = FIRST_COEFFICIENT; c < coefficients; ++c) {
+                    float difference = a[c] - b[c];
+                    sum += difference * difference;
+                }
+                row[j - rowStart[i]] = std::sqrt(sum);
+            }
+        }
+    });
+
+    const float infinity = std::numeric_limits<float>::infinity();
+    QVector<quint8> steps((qsizetype) n * bandWidth);
+    QVector<float> previous(bandWidth, infinity);
+    QVector<float> current(bandWidth, infinity);
+    QVector<float> fromAbove(bandWidth);
+
+    // first row, only horizontal steps
+    int width = rowEnd[0] - rowStart[0] + 1;
+    current[0] = distanceData[0];
+    steps[0] = Diagonal;
+    for (int k = 1; k < width; ++k) {
+        current[k] = current[k - 1] + distanceData[k];
+        steps[k] = Horizontal;
+    }
+
+    for (int i = 1; i < n; ++i) {
+        std::swap(previous, current);
+        int start = rowStart[i];
+        int previousStart = rowStart[i - 1];
+        int previousEnd = rowEnd[i - 1];
+        width = rowEnd[i] - start + 1;
+        const float *previousCosts = previous.constData();
+        const float *rowDistances = distanceData + (qsizetype) i * bandWidth;
+        quint8 *rowSteps = steps.data() + (qsizetype) i * bandWidth;
+        float *above = fromAbove.data();
+        float *costs = current.data();
+
+        // diagonal and vertical predecessors do not depend on this row
+        for (int k = 0; k < width; ++k) {
+            int j = start + k;
+            float vertical = j <= previousEnd ? previousCosts[j - previousStart] : infinity;
+            float diagonal = j - 1 >= previousStart && j - 1 <= previousEnd ? previousCosts[j - 1 - previousStart] : infinity;
+            bool takeDiagonal = diagonal <= vertical;
+            above[k] = takeDiagonal ? diagonal : vertical;
+            rowSteps[k] = takeDiagonal ? Diagonal : Vertical;
+        }
+
+        float left = infinity;
+        for (int k = 0; k < width; ++k) {
+            if (left < above[k]) {
+                above[k] = left;
+                rowSteps[k] = Horizontal;
+            }
+            costs[k] = above[k] + rowDistances[k];
+            left = costs[k];
+        }
+    }
+
+    // backtrack from the last frames of both tracks
+    int i = n - 1;
+    int j = m - 1;
+    if (j < rowStart[i] || j > rowEnd[i]) return path;
+    double totalCost = current[j - rowStart[i]];
+    while (true) {
+        path.speakerFrames << i;
+        path.userFrames << j;
+        if (i == 0 && j == 0) break;
+        quint8 step = steps[(qsizetype) i * bandWidth + (j - rowStart[i])];
+        if (step == Diagonal) { --i; --j; }
+        else if (step == Vertical) --i;
+        else --j;
+        if (i < 0 || j < 0) break;
+    }
+    std::reverse(path.speakerFrames.begin(), path.speakerFrames.end());
+    std::reverse(path.userFrames.begin(), path.userFrames.end());
+    path.averageCost = totalCost / path.speakerFrames.size();
+
+    QVector<double> userFrameSums(n, 0.0);
+    QVector<int> matches(n, 0);
+    for (int step = 0; step < path.speakerFrames.size(); ++step) {
+        userFrameSums[path.speakerFrames[step]] += path.userFrames[step];
+        ++matches[path.speakerFrames[step]];
+    }
+    path.userFrameOfSpeakerFrame.resize(n);
+    for (int frame = 0; frame < n; ++frame) {
+        path.userFrameOfSpeakerFrame[frame] = matches[frame] > 0 ? userFrameSums[frame] / matches[frame] : 0.0f;
+    }
+    return path;
+}
+
+double WarpPath::mapProportion(double proportion) const {
+    if (isEmpty()) return proportion;
+
+    int frames = userFrameOfSpeakerFrame.size();
+    double speakerFrame = std::clamp(proportion * speakerNumSamples / speakerHopSize, 0.0, (double) frames - 1);
+    int before = (int) speakerFrame;
+    int after = std::min(before + 1, frames - 1);
+    double fraction = speakerFrame - before;
+    double userFrame = userFrameOfSpeakerFrame[before] * (1.0 - fraction) + userFrameOfSpeakerFrame[after] * fraction;
+
+    // whatever lies past the last frame (or the end of the track) is carried over unwarped
+    double overshoot = std::max(0.0, proportion * speakerNumSamples / speakerHopSize - (frames - 1)) * speakerHopSize;
+    return (userFrame * userHopSize + overshoot) / userNumSamples;
+}
+
+QPair<double, double> WarpPath::mapSegment(QPair<double, double> segment) const {
+    return qMakePair(mapProportion(segment.first), mapProportion(segment.second));
+}
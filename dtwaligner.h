@@ -0,0 +1,59 @@
+#ifndef DTWALIGNER_H
+#define DTWALIGNER_H
+
+#include <QVector>
+#include <QPair>
+#include "mfccextractor.h"
+
+/*
+ * File: dtwaligner.h
+ * Description:
+ *  This header file defines the 'DtwAligner' class, which aligns the speaker and the user recording with dynamic time
+ *  warping (DTW) over their MFCC frames, and the 'WarpPath' struct holding the alignment.
+ *
+ * Purpose:
+ *  - Learners speak at a different rate than the speaker, the warp path tells which part of the user recording goes with
+ *    which part of the speaker recording so scrubbing and segments can be linked by content instead of by timestamp
+ *
+ * Public Methods:
+ *  - 'static WarpPath align(const MfccFeatures &speaker, const MfccFeatures &user)': DTW restricted to a Sakoe-Chiba
+ *    band around the diagonal, memory and time are O(n * band) instead of O(n * m)
+ *
+ * WarpPath:
+ *  - 'QVector<int> speakerFrames, userFrames': The path from (0, 0) to the last frames of both tracks, one entry per step
+ *  - 'QVector<float> userFrameOfSpeakerFrame': Average user frame matched to every speaker frame, used for the mapping
+ *  - 'double mapProportion(double proportion) const': Position in the user track (0 to 1) that goes with a position in
+ *    the speaker track, interpolated between frames
+ *  - 'QPair<double, double> mapSegment(QPair<double, double> segment) const': Same for both ends of a segment
+ *
+ * Notes:
+ *  - The band is centered on the line between the two corners rather than on the main diagonal, so tracks of different
+ *    lengths still keep their whole band.
+ *
+ * References:
+ *  - Sakoe, H., & Chiba, S. (1978). Dynamic programming algorithm optimization for spoken word recognition.
+ */
+
+struct WarpPath
+{
+    QVector<int> speakerFrames;
+    QVector<int> userFrames;
+    QVector<float> userFrameOfSpeakerFrame;
+    int speakerHopSize = 0;
+    qint64 speakerNumSamples = 0;
+    int userHopSize = 0;
+    qint64 userNumSamples = 0;
+    double averageCost = 0.0; // accumulated distance per path step, lower is a closer match
+
+    bool isEmpty() const { return userFrameOfSpeakerFrame.isEmpty() || speakerNumSamples == 0 || userNumSamples == 0; }
+    double mapProportion(double proportion) const;
+    QPair<double, double> mapSegment(QPair<double, double> segment) const;
+};
+
+class DtwAligner
+{
+public:
+    static WarpPath align(const MfccFeatures &speaker, const MfccFeatures &user);
+};
+
+#endif // DTWALIGNER_H
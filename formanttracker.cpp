@@ -0,0 +1,175 @@
+#include "formanttracker.h"
+#include "resampler.h"
+#include <QtConcurrent>
+#include <QVarLengthArray>
+#include <QDebug>
+#include <algorithm>
+#include <complex>
+#include <cmath>
+
+/*
+ * File: formanttracker.cpp
+ * Description:
+ *  This source file implements the 'FormantTracker'. The samples are resampled to the analysis rate with the
+ *  'Resampler', pre-emphasised (first order high pass from PRE_EMPHASIS_HZ, which flattens the spectral tilt of the voice) and
+ *  cut into windowed frames. For every frame the autocorrelation gives the LPC coefficients through Levinson-Durbin, the
+ *  roots of the prediction polynomial are found with Durand-Kerner iteration and every complex root pair that is narrow
+ *  enough (bandwidth below MAX_BANDWIDTH_HZ) is a formant candidate. The lowest three candidates are F1, F2 and F3.
+ *
+ * Key Methods:
+ *  - 'track()': Splits the frames into batches that run on the global thread pool with QtConcurrent::blockingMap
+ *  - 'analyseBatch()': Copies the windowed frames of a batch next to each other and computes all their autocorrelations
+ *    over that contiguous block, the inner loops are plain multiply-adds the compiler vectorizes
+ *  - 'lpcCoefficients()': Levinson-Durbin recursion
+ *  - 'formantsFromRoots()': Durand-Kerner root finding, frequency and bandwidth of every root with a positive angle
+ *
+ * References:
+ *  - https://en.wikipedia.org/wiki/Levinson_recursion
+ *  - https://en.wikipedia.org/wiki/Durand%E2%80%93Kerner_method
+ *  - Praat's "To Formant (burg)" documents the same pre-emphasis and bandwidth conventions
+ */
+
+#define FORMANT_ANALYSIS_RATE 11000
+#define FORMANT_FRAME_SECONDS 0.025
+#define FORMANT_HOP_SECONDS 0.01
+#define PRE_EMPHASIS_HZ 50.0
+#define MIN_FORMANT_HZ 90.0
+#define MAX_BANDWIDTH_HZ 400.0
+#define SILENCE_POWER 1e-8 // mean square of a windowed, pre-emphasised frame below which nothing is tracked
+#define FRAMES_PER_BATCH 64
+#define ROOT_ITERATIONS 100
+
+FormantTracker::FormantTracker(int _sampleRate)
+    : sampleRate(std::max(_sampleRate, 1))
+{
+    analysisRate = std::min(sampleRate, FORMANT_ANALYSIS_RATE);
+    order = 2 + analysisRate / 1000;
+    frameLength = qRound(FORMANT_FRAME_SECONDS * analysisRate);
+    hopSize = qRound(FORMANT_HOP_SECONDS * analysisRate);
+}
+
+void FormantTracker::setWindow(const QVector<double> &_window) {
+    window = _window;
+}
+
+FormantTracks FormantTracker::track(const QVector<double> &samples) const {
+    FormantTracks tracks;
+    tracks.hopSize = hopSize;
+    tracks.frameLength = frameLength;
+    tracks.sampleRate = analysisRate;
+    if (window.size() != frameLength) {
+        qWarning() << "Formant Error: analysis window has the wrong length";
+        return tracks;
+    }
+
+    QVector<double> signal = Resampler::resample(samples, sampleRate, analysisRate);
+    double alpha = std::exp(-2.0 * M_PI * PRE_EMPHASIS_HZ / analysisRate);
+    for (qsizetype i = signal.size() - 1; i > 0; --i) signal[i] -= alpha * signal[i - 1];
+    tracks.numSamples = signal.size();
+
+    int numFrames = signal.size() >= frameLength ? (signal.size() - frameLength) / hopSize + 1 : 0;
+    tracks.frequencies.resize(numFrames * FormantTracks::formantCount);
+    float *frequencies = tracks.frequencies.data();
+    const double *input = signal.constData();
+
+    QVector<int> batches;
+    for (int firstFrame = 0; firstFrame < numFrames; firstFrame += FRAMES_PER_BATCH) batches << firstFrame;
+    QtConcurrent::blockingMap(batches, [&](int firstFrame) {
+        int frameCount = std::min(FRAMES_PER_BATCH, numFrames - firstFrame);
+        analyseBatch(input, firstFrame, frameCount, frequencies + firstFrame * FormantTracks::formantCount);
+    });
+    return tracks;
+}
+
+void FormantTracker::analyseBatch(const double *signal, int firstFrame, int frameCount, float *frequencies) const {
+    // windowed frames next to each other, one row per frame
+    QVector<double> frames(frameCount * frameLength);
+    double *windowed = frames.data();
+    const double *analysisWindow = window.constData();
+    for (int f = 0; f < frameCount; ++f) {
+        const double *frame = signal + (qint64) (firstFrame + f) * hopSize;
+        double *row = windowed + f * frameLength;
+        for (int i = 0; i < frameLength; ++i) row[i] = frame[i] * analysisWindow[i];
+    }
+
+    QVector<double> autocorrelations(frameCount * (order + 1));
+    for (int f = 0; f < frameCount; ++f) {
+        const double *row = windowed + f * frameLength;
+        double *r = autocorrelations.data() + f * (order + 1);
+        for (int lag = 0; lag <= order; ++lag) {
+            double acc = 0.0;
+            for (int i = lag; i < frameLength; ++i) acc += row[i] * row[i - lag];
+            r[lag] = acc;
+        }
+    }
+
+    QVarLengthArray<double, 32> coefficients(order + 1);
+    for (int f = 0; f < frameCount; ++f) {
+        const double *r = autocorrelations.constData() + f * (order + 1);
+        if (r[0] / frameLength < SILENCE_POWER) continue; // stays 0, no formants
+        lpcCoefficients(r, order, coefficients.data());
+        formantsFromRoots(coefficients.data(), frequencies + f * FormantTracks::formantCount);
+    }
+}
+
+double FormantTracker::lpcCoefficients(const double *autocorrelation, int order, double *coefficients) {
+    // prediction polynomial 1 + a1 z^-1 + ... + ap z^-p
+    QVarLengthArray<double, 64> previous(order + 1);
+    std::fill(coefficients, coefficients + order + 1, 0.0);
+    coefficients[0] = 1.0;
+    double error = autocorrelation[0];
+
+    for (int i = 1; i <= order && error > 0.0; ++i) {
+        double acc = autocorrelation[i];
+        for (int j = 1; j < i; ++j) acc += coefficients[j] * autocorrelation[i - j];
+        double reflection = -acc / error;
+
+        std::copy(coefficients, coefficients + i, previous.data());
+        for (int j = 1; j < i; ++j) coefficients[j] = previous[j] + reflection * previous[i - j];
+        coefficients[i] = reflection;
+        error *= 1.0 - reflection * reflection;
+    }
+    return error;
+}
+
+int FormantTracker::formantsFromRoots(const double *coefficients, float *frequencies) const {
+    typedef std::complex<double> Complex;
+
+    // Durand-Kerner on z^p + a1 z^(p-1) + ... + ap, starting from powers of a point that is not a root of unity
+    QVarLengthArray<Complex, 32> roots(order);
+    const Complex seed(0.4, 0.9);
+    roots[0] = Complex(1.0, 0.0);
+    for (int i = 1; i < order; ++i) roots[i] = roots[i - 1] * seed;
+
+    for (int iteration = 0; iteration < ROOT_ITERATIONS; ++iteration) {
+        double largestStep = 0.0;
+        for (int i = 0; i < order; ++i) {
+            Complex value(1.0, 0.0);
+            for (int j = 1; j <= order; ++j) value = value * roots[i] + coefficients[j];
+            Complex denominator(1.0, 0.0);
+            for (int j = 0; j < order; ++j) {
+                if (j != i) denominator *= roots[i] - roots[j];
+            }
+            if (std::abs(denominator) == 0.0) continue;
+            Complex step = value / denominator;
+            roots[i] -= step;
+            largestStep = std::max(largestStep, std::abs(step));
+        }
+        if (largestStep < 1e-9) break;
+    }
+
+    QVarLengthArray<float, 32> candidates;
+    for (const Complex &root : roots) {
+        if (root.imag() <= 0.0) continue; // each formant is a conjugate pair, keep the upper one
+        double frequency = std::arg(root) * analysisRate / (2.0 * M_PI);
+        double bandwidth = -std::log(std::abs(root)) * analysisRate / M_PI;
+        if (frequency > MIN_FORMANT_HZ && frequency < analysisRate / 2.0 - MIN_FORMANT_HZ && bandwidth < MAX_BANDWIDTH_HZ) {
+            candidates.append((float) frequency);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    int found = std::min<int>(candidates.size(), FormantTracks::formantCount);
+    for (int i = 0; i < found; ++i) frequencies[i] = candidates[i];
+    return found;
+}
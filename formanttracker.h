@@ -0,0 +1,76 @@
+#ifndef FORMANTTRACKER_H
+#define FORMANTTRACKER_H
+
+#include <QVector>
+
+/*
+ * File: formanttracker.h
+ * Description:
+ *  This header file defines the 'FormantTracker' class, which estimates the first three formants (F1-F3) of speech by
+ *  linear prediction (LPC), and the 'FormantTracks' struct holding the result for one track.
+ *
+ * Purpose:
+ *  - Lets learners compare vowel quality of the speaker and their own recording without an external tool
+ *
+ * Key Members:
+ *  - 'int sampleRate': Sample rate of the samples given to track()
+ *  - 'int analysisRate': Rate the samples are resampled to before the analysis (FORMANT_ANALYSIS_RATE, or sampleRate if
+ *    that is lower), formants are searched below about 5.5 kHz so the LPC only needs an order of about a dozen
+ *  - 'int order': LPC order, 2 + analysisRate / 1000 (two poles per kHz plus two for the spectral tilt)
+ *  - 'int frameLength, hopSize': 25 ms analysis frames every 10 ms, at the analysis rate
+ *  - 'QVector<double> window': Analysis window of frameLength samples, set by the owner with 'Spectrograph::hammingWindow'
+ *
+ * Public Methods:
+ *  - 'FormantTracker(int sampleRate)': Computes the analysis rate, order and frame sizes
+ *  - 'int getFrameLength() const': Length the window given to setWindow has to have
+ *  - 'void setWindow(const QVector<double> &window)': Sets the analysis window
+ *  - 'FormantTracks track(const QVector<double> &samples) const': Resamples, pre-emphasises and analyses every frame,
+ *    frames are processed in batches of FRAMES_PER_BATCH on the global thread pool
+ *  - 'static double lpcCoefficients(const double *autocorrelation, int order, double *coefficients)': Levinson-Durbin,
+ *    returns the prediction error. Also used by the 'SpectralSlice' for its LPC envelope
+ *
+ * Notes:
+ *  - Frequencies are stored frame-major (F1, F2, F3 of frame 0, then of frame 1, ...) in one contiguous array,
+ *    0 means no formant was found in that frame.
+ *
+ * References:
+ *  - Markel, J. D., & Gray, A. H. (1976). Linear Prediction of Speech.
+ */
+
+struct FormantTracks
+{
+    static const int formantCount = 3;
+    QVector<float> frequencies;
+    int hopSize = 0;
+    int frameLength = 0;
+    int sampleRate = 0; // analysis rate the hop and frame length are counted in
+    qint64 numSamples = 0; // at the analysis rate
+
+    int frameCount() const { return frequencies.size() / formantCount; }
+    bool isEmpty() const { return frequencies.isEmpty() || numSamples == 0; }
+    float formant(int frame, int formant) const { return frequencies[frame * formantCount + formant]; }
+    double frameToProportion(int frame) const { return ((double) frame * hopSize + frameLength / 2.0) / numSamples; }
+};
+
+class FormantTracker
+{
+    int sampleRate;
+    int analysisRate;
+    int order;
+    int frameLength;
+    int hopSize;
+    QVector<double> window;
+
+    void analyseBatch(const double *signal, int firstFrame, int frameCount, float *frequencies) const;
+    int formantsFromRoots(const double *coefficients, float *frequencies) const;
+
+public:
+    explicit FormantTracker(int sampleRate);
+    int getSampleRate() const { return sampleRate; }
+    int getFrameLength() const { return frameLength; }
+    void setWindow(const QVector<double> &_window);
+    FormantTracks track(const QVector<double> &samples) const;
+    static double lpcCoefficients(const double *autocorrelation, int order, double *coefficients);
+};
+
+#endif // FORMANTTRACKER_H
@@ -0,0 +1,256 @@
+#include "liverecorder.h"
+#include <QMediaDevices>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDir>
+#include <QDebug>
+#include <algorithm>
+#include "wavfile.h"
+#include "tracer.h"
+
+/*
+ * File: liverecorder.cpp
+ * Description:
+ *  This source file implements live recording. 'LiveRecorder::start()' picks the default input device, asks for mono
+ *  float samples (falling back to the device's preferred format, which 'RingWriterDevice' mixes down) and starts the
+ *  capture thread and the analysis thread. The analysis thread polls the ring every ANALYSIS_POLL_MS, so the view gets
+ *  about one update per display frame no matter how the device sizes its buffers.
+ *
+ * Key Methods:
+ *  - 'RingWriterDevice::writeData()': Converts whole frames with QAudioFormat::normalizedSampleValue, a frame split over
+ *    two writes is kept until the rest arrives
+ *  - 'LiveAnalyser::poll()': Moves the new samples out of the ring into the recording and the pyramid, computes the STFT
+ *    columns of every complete window and keeps the samples after the last hop for the next poll
+ *  - 'LiveRecorder::stop()': Stops the source, drains the ring a last time on the analysis thread, joins the threads and
+ *    writes AppDataLocation/recordings/attempt-<date>-<time>.wav
+ */
+
+#define CAPTURE_BUFFER_US 20000 // audio source buffer, small so samples reach the ring quickly
+#define RING_SECONDS 4
+#define ANALYSIS_POLL_MS 10
+#define LIVE_WINDOW_SIZE 1024
+#define LIVE_HOP_SIZE 512
+
+RingWriterDevice::RingWriterDevice(const QAudioFormat &_format, std::shared_ptr<LiveBuffer> _buffer, QObject *parent)
+    : QIODevice(parent), format(_format), buffer(std::move(_buffer))
+{
+    mono.reserve(format.framesForDuration(1000000)); // the callback never has to grow it
+    partialFrame.reserve(format.bytesPerFrame());
+}
+
+qint64 RingWriterDevice::readData(char *, qint64) {
+    return 0;
+}
+
+qint64 RingWriterDevice::writeData(const char *data, qint64 size) {
+    int frameBytes = format.bytesPerFrame();
+    int sampleBytes = format.bytesPerSample();
+    int channels = format.channelCount();
+    if (frameBytes <= 0) return size;
+
+    auto mixDown = [&](const char *frame) {
+        float sum = 0.0f;
+        for (int channel = 0; channel < channels; ++channel) sum += format.normalizedSampleValue(frame + channel * sampleBytes);
+        return sum / channels;
+    };
+
+    // complete a frame that was split over the previous write first
+    qint64 consumed = 0;
+    if (!partialFrame.isEmpty()) {
+        consumed = std::min<qint64>(frameBytes - partialFrame.size(), size);
+        partialFrame.append(data, consumed);
+        if (partialFrame.size() < frameBytes) return size;
+    }
+
+    qint64 frames = (size - consumed) / frameBytes;
+    mono.resize(frames + (partialFrame.isEmpty() ? 0 : 1));
+    float *out = mono.data();
+    if (!partialFrame.isEmpty()) {
+        *out++ = mixDown(partialFrame.constData());
+        partialFrame.resize(0);
+    }
+    const char *frame = data + consumed;
+    for (qint64 i = 0; i < frames; ++i, frame += frameBytes) *out++ = mixDown(frame);
+    partialFrame.append(frame, data + size - frame);
+
+    qsizetype written = buffer->samples.write(mono.constData(), mono.size());
+    if (written < mono.size()) buffer->droppedSamples.fetch_add(mono.size() - written, std::memory_order_relaxed);
+    return size;
+}
+
+LiveCapture::LiveCapture(const QAudioDevice &_device, const QAudioFormat &_format, std::shared_ptr<LiveBuffer> _buffer)
+    : device(_device), format(_format), buffer(std::move(_buffer))
+{
+}
+
+void LiveCapture::start() {
+    source = new QAudioSource(device, format, this);
+    source->setBufferSize(format.bytesForDuration(CAPTURE_BUFFER_US));
+    connect(source, &QAudioSource::stateChanged, this, &LiveCapture::sourceStateChanged);
+    sink = new RingWriterDevice(format, buffer, this);
+    sink->open(QIODevice::WriteOnly);
+    source->start(sink);
+    if (source->error() != QAudio::NoError) emit failed("The microphone could not be opened");
+}
+
+void LiveCapture::stop() {
+    if (source) {
+        disconnect(source, &QAudioSource::stateChanged, this, &LiveCapture::sourceStateChanged);
+        source->stop();
+    }
+    if (sink) sink->close();
+}
+
+void LiveCapture::sourceStateChanged(QAudio::State state) {
+    if (state == QAudio::StoppedState && source->error() != QAudio::NoError) {
+        emit failed("The microphone stopped unexpectedly");
+    }
+}
+
+LiveAnalyser::LiveAnalyser(std::shared_ptr<LiveBuffer> _buffer, int _sampleRate, int windowSize, int _viewWidth, double _visibleSeconds)
+    : buffer(std::move(_buffer)), sampleRate(_sampleRate), viewWidth(std::max(_viewWidth, 1)), visibleSeconds(_visibleSeconds),
+      stft(std::make_unique<Stft>(windowSize, LIVE_HOP_SIZE))
+{
+    recording.reserve(sampleRate * 60);
+}
+
+void LiveAnalyser::start() {
+    pollTimer = new QTimer(this);
+    pollTimer->setTimerType(Qt::PreciseTimer);
+    connect(pollTimer, &QTimer::timeout, this, &LiveAnalyser::poll);
+    pollTimer->start(ANALYSIS_POLL_MS);
+}
+
+void LiveAnalyser::poll() {
+    TRACE_SCOPE("LiveAnalyser::poll");
+    qsizetype available = buffer->samples.readAvailable();
+    if (available == 0) return;
+
+    scratch.resize(available);
+    buffer->samples.read(scratch.data(), available);
+    recording.append(scratch);
+    pyramid.append(scratch.constData(), available);
+    for (float sample : scratch) pending.append(sample);
+
+    LiveUpdate update;
+    if (pending.size() >= stft->getWindowSize()) {
+        SpectralFrames frames = stft->compute(pending, sampleRate);
+        pending.remove(0, frames.magnitudes.size() * stft->getHopSize());
+        update.columns = frames.magnitudes;
+    }
+
+    int level = pyramid.levelFor(visibleSeconds * sampleRate / viewWidth);
+    qsizetype peaks = pyramid.mins(level).size();
+    qsizetype first = std::max<qsizetype>(0, peaks - viewWidth);
+    update.mins = pyramid.mins(level).mid(first);
+    update.maxs = pyramid.maxs(level).mid(first);
+    update.samplesPerPeak = pyramid.samplesPerPeak(level);
+    update.totalSamples = pyramid.sampleCount();
+    update.droppedSamples = buffer->droppedSamples.load(std::memory_order_relaxed);
+    emit updated(update);
+}
+
+QList<float> LiveAnalyser::finish() {
+    if (pollTimer) pollTimer->stop();
+    poll(); // whatever the source wrote before it stopped
+    QList<float> samples;
+    samples.swap(recording);
+    return samples;
+}
+
+LiveRecorder::LiveRecorder(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<LiveUpdate>();
+}
+
+LiveRecorder::~LiveRecorder() {
+    stopThreads();
+}
+
+int LiveRecorder::getWindowSize() const {
+    return LIVE_WINDOW_SIZE;
+}
+
+int LiveRecorder::getHopSize() const {
+    return LIVE_HOP_SIZE;
+}
+
+bool LiveRecorder::start(int viewWidth, double visibleSeconds) {
+    if (recording) return true;
+
+    QAudioDevice device = QMediaDevices::defaultAudioInput();
+    if (device.isNull()) {
+        emit recordingFailed("No microphone was found");
+        return false;
+    }
+    QAudioFormat format = device.preferredFormat();
+    format.setSampleFormat(QAudioFormat::Float);
+    format.setChannelCount(1);
+    if (!device.isFormatSupported(format)) format = device.preferredFormat();
+    sampleRate = format.sampleRate();
+
+    auto buffer = std::make_shared<LiveBuffer>(qsizetype(sampleRate) * RING_SECONDS);
+
+    captureThread = new QThread;
+    capture = new LiveCapture(device, format, buffer);
+    capture->moveToThread(captureThread);
+    connect(captureThread, &QThread::started, capture, &LiveCapture::start);
+    connect(capture, &LiveCapture::failed, this, &LiveRecorder::captureFailed);
+    connect(captureThread, &QThread::finished, capture, &QObject::deleteLater);
+    connect(captureThread, &QThread::finished, captureThread, &QObject::deleteLater);
+
+    analysisThread = new QThread;
+    analyser = new LiveAnalyser(buffer, sampleRate, LIVE_WINDOW_SIZE, viewWidth, visibleSeconds);
+    analyser->moveToThread(analysisThread);
+    connect(analysisThread, &QThread::started, analyser, &LiveAnalyser::start);
+    connect(analyser, &LiveAnalyser::updated, this, &LiveRecorder::liveUpdate);
+    connect(analysisThread, &QThread::finished, analyser, &QObject::deleteLater);
+    connect(analysisThread, &QThread::finished, analysisThread, &QObject::deleteLater);
+
+    analysisThread->start(QThread::HighPriority);
+    captureThread->start(QThread::TimeCriticalPriority);
+    recording = true;
+    return true;
+}
+
+void LiveRecorder::stop() {
+    if (!recording) return;
+    recording = false;
+
+    QMetaObject::invokeMethod(capture, &LiveCapture::stop, Qt::BlockingQueuedConnection);
+    QList<float> samples;
+    QMetaObject::invokeMethod(analyser, [&]() { samples = analyser->finish(); }, Qt::BlockingQueuedConnection);
+    stopThreads();
+
+    if (samples.isEmpty()) {
+        emit recordingFailed("Nothing was recorded");
+        return;
+    }
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/recordings";
+    QString path = directory + "/attempt-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".wav";
+    if (!QDir().mkpath(directory) || !WavFile::writeFile(path, samples, sampleRate)) {
+        emit recordingFailed("The recording could not be saved to " + directory);
+        return;
+    }
+    emit recordingFinished(path);
+}
+
+void LiveRecorder::stopThreads() {
+    for (QThread *thread : {captureThread, analysisThread}) {
+        if (!thread) continue;
+        thread->quit();
+        thread->wait();
+    }
+    captureThread = nullptr;
+    analysisThread = nullptr;
+    capture = nullptr;
+    analyser = nullptr;
+}
+
+void LiveRecorder::captureFailed(const QString &message) {
+    if (!recording) return;
+    recording = false;
+    stopThreads();
+    emit recordingFailed(message);
+}
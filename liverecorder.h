@@ -0,0 +1,178 @@
+#ifndef LIVERECORDER_H
+#define LIVERECORDER_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QThread>
+#include <QTimer>
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QAudioSource>
+#include <atomic>
+#include <memory>
+#include "spscringbuffer.h"
+#include "peakpyramid.h"
+#include "stft.h"
+
+/*
+ * File: liverecorder.h
+ * Description:
+ *  This header file defines the classes behind live recording from the microphone. Capture, analysis and drawing run on
+ *  three different threads so neither the analysis nor a slow repaint can make the audio callback miss samples:
+ *
+ *      microphone -> 'LiveCapture' (capture thread) -> 'LiveBuffer' ring -> 'LiveAnalyser' (analysis thread)
+ *                 -> 'LiveUpdate' signal -> 'LiveRecordingView' (GUI thread)
+ *
+ * Key Members:
+ *  - 'LiveUpdate': What the view needs for one refresh, the newest waveform peaks at the resolution of the view and the
+ *    spectrogram columns computed since the previous update
+ *  - 'LiveBuffer': The single producer, single consumer ring between the capture and the analysis thread, and the number
+ *    of samples that did not fit into it
+ *  - 'RingWriterDevice': QIODevice the audio source writes into, mixes every frame down to mono and pushes it into the ring
+ *  - 'LiveCapture': Owns the QAudioSource, lives on the capture thread
+ *  - 'LiveAnalyser': Drains the ring, keeps the whole recording, extends the 'PeakPyramid' and runs the STFT on the
+ *    samples that arrived, lives on the analysis thread
+ *  - 'LiveRecorder': GUI side, starts and stops the two threads and saves the recording
+ *
+ * LiveRecorder Public Methods:
+ *  - 'bool start(int viewWidth, double visibleSeconds)': Opens the default input device, false if there is none
+ *  - 'void stop()': Stops the capture, writes the recording to a WAV file and emits 'recordingFinished'
+ *  - 'bool isRecording() const', 'int getSampleRate() const', 'int getWindowSize() const', 'int getHopSize() const'
+ *
+ * LiveRecorder Signals:
+ *  - 'void liveUpdate(LiveUpdate update)': New peaks and columns for the view
+ *  - 'void recordingFinished(const QString &path)': The recording was saved and can be loaded like any uploaded file
+ *  - 'void recordingFailed(const QString &message)': No device, the device stopped with an error or the file could not
+ *    be written
+ *
+ * Notes:
+ *  - Nothing on the capture thread allocates or locks after the start: the scratch buffer of the device keeps its
+ *    capacity and the ring is preallocated. If the analysis falls behind by more than the ring holds, the newest
+ *    samples are dropped and counted instead of blocking the audio callback.
+ *  - Both threads run at raised priority, capture above analysis.
+ *  - The analysis thread owns the 'Stft', 'PeakPyramid' and recording, the GUI thread only sees copies in 'LiveUpdate'.
+ *  - On macOS the app needs microphone permission (NSMicrophoneUsageDescription in the bundle's Info.plist), without it
+ *    the device delivers silence.
+ *
+ * References:
+ *  - https://doc.qt.io/qt-6/qaudiosource.html
+ *  - https://doc.qt.io/qt-6/qthread.html#details (worker object pattern)
+ */
+
+struct LiveUpdate
+{
+    QVector<float> mins; // newest waveform peaks, at most the view width of them
+    QVector<float> maxs;
+    int samplesPerPeak = 0;
+    QVector<QVector<double>> columns; // STFT columns computed since the previous update
+    qint64 totalSamples = 0;
+    qint64 droppedSamples = 0;
+};
+
+Q_DECLARE_METATYPE(LiveUpdate)
+
+struct LiveBuffer
+{
+    explicit LiveBuffer(qsizetype capacity) : samples(capacity) {}
+    SpscRingBuffer<float> samples;
+    std::atomic<qint64> droppedSamples{0};
+};
+
+class RingWriterDevice : public QIODevice
+{
+    Q_OBJECT
+    QAudioFormat format;
+    std::shared_ptr<LiveBuffer> buffer;
+    QVector<float> mono;
+    QByteArray partialFrame;
+
+public:
+    RingWriterDevice(const QAudioFormat &format, std::shared_ptr<LiveBuffer> buffer, QObject *parent = nullptr);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+};
+
+class LiveCapture : public QObject
+{
+    Q_OBJECT
+    QAudioDevice device;
+    QAudioFormat format;
+    std::shared_ptr<LiveBuffer> buffer;
+    QAudioSource *source = nullptr;
+    RingWriterDevice *sink = nullptr;
+
+public:
+    LiveCapture(const QAudioDevice &device, const QAudioFormat &format, std::shared_ptr<LiveBuffer> buffer);
+
+public slots:
+    void start();
+    void stop();
+
+private slots:
+    void sourceStateChanged(QAudio::State state);
+
+signals:
+    void failed(const QString &message);
+};
+
+class LiveAnalyser : public QObject
+{
+    Q_OBJECT
+    std::shared_ptr<LiveBuffer> buffer;
+    int sampleRate;
+    int viewWidth;
+    double visibleSeconds;
+    QTimer *pollTimer = nullptr;
+    std::unique_ptr<Stft> stft;
+    PeakPyramid pyramid;
+    QList<float> recording;
+    QVector<float> scratch;
+    QVector<double> pending; // samples not yet covered by an STFT column
+
+public:
+    LiveAnalyser(std::shared_ptr<LiveBuffer> buffer, int sampleRate, int windowSize, int viewWidth, double visibleSeconds);
+    QList<float> finish();
+
+public slots:
+    void start();
+    void poll();
+
+signals:
+    void updated(LiveUpdate update);
+};
+
+class LiveRecorder : public QObject
+{
+    Q_OBJECT
+    QThread *captureThread = nullptr;
+    QThread *analysisThread = nullptr;
+    LiveCapture *capture = nullptr;
+    LiveAnalyser *analyser = nullptr;
+    int sampleRate = 0;
+    bool recording = false;
+
+    void stopThreads();
+
+public:
+    explicit LiveRecorder(QObject *parent = nullptr);
+    ~LiveRecorder();
+
+    bool start(int viewWidth, double visibleSeconds);
+    void stop();
+    bool isRecording() const { return recording; }
+    int getSampleRate() const { return sampleRate; }
+    int getWindowSize() const;
+    int getHopSize() const;
+
+private slots:
+    void captureFailed(const QString &message);
+
+signals:
+    void liveUpdate(LiveUpdate update);
+    void recordingFinished(const QString &path);
+    void recordingFailed(const QString &message);
+};
+
+#endif // LIVERECORDER_H
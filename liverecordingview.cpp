@@ -0,0 +1,123 @@
+#include "liverecordingview.h"
+#include <QPainter>
+#include <algorithm>
+#include "spectrogramrenderer.h"
+#include "tracer.h"
+
+/*
+ * File: liverecordingview.cpp
+ * Description:
+ *  This source file implements the 'LiveRecordingView'. The waveform is drawn from the peaks of the 'LiveUpdate', one
+ *  vertical line per peak, placed by the samples it covers so the time scale stays the same while the pyramid level
+ *  changes. The spectrogram image has one column per STFT hop of the visible seconds.
+ */
+
+#define VISIBLE_SECONDS 5.0
+#define MAX_FREQUENCY_HZ 5000.0
+#define REFRESH_MS 16
+
+LiveRecordingView::LiveRecordingView(int width, int height, QWidget *parent)
+    : QWidget(parent), viewWidth(width), viewHeight(height)
+{
+    setFixedSize(viewWidth, viewHeight);
+    refreshTimer = new QTimer(this);
+    connect(refreshTimer, &QTimer::timeout, this, &LiveRecordingView::refresh);
+}
+
+double LiveRecordingView::getVisibleSeconds() const {
+    return VISIBLE_SECONDS;
+}
+
+void LiveRecordingView::begin(int _sampleRate, int _windowSize, int _hopSize) {
+    sampleRate = std::max(_sampleRate, 1);
+    windowSize = _windowSize;
+    hopSize = std::max(_hopSize, 1);
+    mins.clear();
+    maxs.clear();
+    samplesPerPeak = 0;
+    maxAmp = 0.0;
+    totalSamples = 0;
+    droppedSamples = 0;
+
+    int columns = std::max(1, qRound(VISIBLE_SECONDS * sampleRate / hopSize));
+    spectrogram = QImage(columns, viewHeight / 2, QImage::Format_RGB32);
+    spectrogram.fill(Qt::black);
+    nextColumn = 0;
+    dirty = true;
+}
+
+void LiveRecordingView::addUpdate(LiveUpdate update) {
+    mins = update.mins;
+    maxs = update.maxs;
+    samplesPerPeak = update.samplesPerPeak;
+    totalSamples = update.totalSamples;
+    droppedSamples = update.droppedSamples;
+    for (const QVector<double> &column : update.columns) paintColumn(column);
+    dirty = true;
+}
+
+void LiveRecordingView::paintColumn(const QVector<double> &column) {
+    if (spectrogram.isNull() || column.isEmpty()) return;
+    for (double amplitude : column) maxAmp = std::max(maxAmp, amplitude);
+
+    int rows = spectrogram.height();
+    int maxBin = std::min<int>(column.size(), qRound(MAX_FREQUENCY_HZ * windowSize / sampleRate));
+    for (int y = 0; y < rows; ++y) {
+        int bin = (rows - 1 - y) * maxBin / rows;
+        int intensity = maxAmp > 0.0 ? static_cast<int>((column[bin] / maxAmp) * 255.0) : 0;
+        QRgb *line = reinterpret_cast<QRgb*>(spectrogram.scanLine(y));
+        line[nextColumn] = SpectrogramRenderer::intensityColor(intensity).rgb();
+    }
+    nextColumn = (nextColumn + 1) % spectrogram.width();
+}
+
+void LiveRecordingView::refresh() {
+    if (!dirty) return;
+    dirty = false;
+    update();
+}
+
+void LiveRecordingView::showEvent(QShowEvent *event) {
+    refreshTimer->start(REFRESH_MS);
+    QWidget::showEvent(event);
+}
+
+void LiveRecordingView::hideEvent(QHideEvent *event) {
+    refreshTimer->stop();
+    QWidget::hideEvent(event);
+}
+
+void LiveRecordingView::paintEvent(QPaintEvent *) {
+    TRACE_SCOPE("LiveRecordingView::paintEvent");
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+    int waveHeight = viewHeight / 2;
+
+    // waveform, newest peak at the right edge
+    painter.setPen(QColor(31, 119, 180));
+    double middle = waveHeight / 2.0;
+    double pixelsPerPeak = samplesPerPeak * viewWidth / (VISIBLE_SECONDS * sampleRate);
+    for (qsizetype i = 0; i < mins.size(); ++i) {
+        double x = viewWidth - (mins.size() - i) * pixelsPerPeak;
+        if (x < 0) continue;
+        painter.drawLine(QPointF(x, middle - maxs[i] * middle), QPointF(x, middle - mins[i] * middle));
+    }
+
+    // spectrogram ring: oldest column first
+    if (!spectrogram.isNull()) {
+        QRect target(0, waveHeight, viewWidth, viewHeight - waveHeight);
+        int columns = spectrogram.width();
+        int olderWidth = columns - nextColumn;
+        double scale = (double) viewWidth / columns;
+        painter.drawImage(QRectF(target.x(), target.y(), olderWidth * scale, target.height()),
+                          spectrogram, QRectF(nextColumn, 0, olderWidth, spectrogram.height()));
+        painter.drawImage(QRectF(target.x() + olderWidth * scale, target.y(), nextColumn * scale, target.height()),
+                          spectrogram, QRectF(0, 0, nextColumn, spectrogram.height()));
+    }
+
+    // elapsed time and dropped samples
+    painter.setPen(Qt::black);
+    QString status = QString("recording %1 s").arg((double) totalSamples / std::max(sampleRate, 1), 0, 'f', 1);
+    if (droppedSamples > 0) status += QString(", %1 samples dropped").arg(droppedSamples);
+    painter.drawText(QRect(4, 2, viewWidth - 8, 16), Qt::AlignLeft | Qt::AlignTop, status);
+}
@@ -0,0 +1,70 @@
+#ifndef LIVERECORDINGVIEW_H
+#define LIVERECORDINGVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QTimer>
+#include "liverecorder.h"
+
+/*
+ * File: liverecordingview.h
+ * Description:
+ *  This header file defines the 'LiveRecordingView' class, which shows what the microphone records while it records:
+ *  the waveform of the last seconds in the top half and a scrolling spectrogram (0 to 5 kHz) in the bottom half, the
+ *  newest audio at the right edge.
+ *
+ * Public Methods:
+ *  - 'LiveRecordingView(int width, int height, QWidget *parent = nullptr)': Same size as the 'WavForm' it replaces
+ *  - 'void begin(int sampleRate, int windowSize, int hopSize)': Clears the view for a new recording
+ *  - 'double getVisibleSeconds() const': Seconds of audio across the width
+ *
+ * Public Slots:
+ *  - 'void addUpdate(LiveUpdate update)': Takes the newest peaks, paints the new spectrogram columns into the image and
+ *    marks the view for the next refresh
+ *
+ * Notes:
+ *  - Updates arrive about every 10 ms, the view repaints at most once per REFRESH_MS and only if something changed.
+ *  - The spectrogram is a ring of image columns: a new STFT column overwrites the oldest one, nothing is shifted, and
+ *    the paint draws the ring in two pieces.
+ *  - Colours are normalised by the loudest amplitude so far, the colour map is the one of 'SpectrogramRenderer'.
+ */
+
+class LiveRecordingView : public QWidget
+{
+    Q_OBJECT
+    int viewWidth;
+    int viewHeight;
+    int sampleRate = 0;
+    int windowSize = 0;
+    int hopSize = 0;
+    QVector<float> mins;
+    QVector<float> maxs;
+    int samplesPerPeak = 0;
+    QImage spectrogram;
+    int nextColumn = 0;
+    double maxAmp = 0.0;
+    qint64 totalSamples = 0;
+    qint64 droppedSamples = 0;
+    bool dirty = false;
+    QTimer *refreshTimer;
+
+    void paintColumn(const QVector<double> &column);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+public:
+    LiveRecordingView(int width, int height, QWidget *parent = nullptr);
+    void begin(int sampleRate, int windowSize, int hopSize);
+    double getVisibleSeconds() const;
+
+public slots:
+    void addUpdate(LiveUpdate update);
+
+private slots:
+    void refresh();
+};
+
+#endif // LIVERECORDINGVIEW_H
@@ -0,0 +1,135 @@
+#include "ltas.h"
+#include "stft.h"
+#include "tracer.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+/*
+ * File: ltas.cpp
+ * Description:
+ *  This source file implements the 'Ltas'. The power of every bin (amplitude squared, relative to the amplitude the
+ *  'Stft' gives a full scale sine) is summed over the frames of the range with QtConcurrent::blockingMappedReduced and
+ *  divided by the number of frames. The statistics are read off that mean spectrum:
+ *  - centroid: sum of f * P(f) over the sum of P(f), without the DC bin
+ *  - tilt: least squares slope of the LTAS in dB against log2 of the frequency, so it is in dB per octave
+ *  - band energies: sum of P(f) over the bins of each band of bandEdges
+ *
+ * References:
+ *  - https://doc.qt.io/qt-6/qtconcurrent-map.html
+ */
+
+#define FRAMES_PER_BATCH 64
+#define TILT_MIN_HZ 100.0
+#define TILT_MAX_HZ 5000.0
+#define MIN_POWER 1e-20 // -200 dB, for bins without any energy
+
+// octave bands over the range of speech, the lowest holds F0 and F1 of most vowels
+static const double bandEdges[][2] = {{0.0, 500.0}, {500.0, 1000.0}, {1000.0, 2000.0}, {2000.0, 4000.0}, {4000.0, 8000.0}};
+static const int BAND_COUNT = sizeof(bandEdges) / sizeof(bandEdges[0]);
+
+namespace {
+struct PowerSum
+{
+    QVector<double> power;
+    int frames = 0;
+};
+}
+
+int Ltas::bandCount() {
+    return BAND_COUNT;
+}
+
+QString Ltas::bandName(int band) {
+    return QString("%1-%2 Hz").arg(bandEdges[band][0]).arg(bandEdges[band][1]);
+}
+
+LtasStatistics Ltas::compute(const SpectralFrames &frames, double startProportion, double endProportion) {
+    TRACE_SCOPE("Ltas::compute");
+    LtasStatistics statistics;
+    if (frames.isEmpty()) return statistics;
+
+    int frameCount = frames.magnitudes.size();
+    int firstFrame = std::clamp(frames.proportionToFrame(startProportion), 0, frameCount);
+    int lastFrame = std::clamp(frames.proportionToFrame(endProportion), firstFrame, frameCount);
+    if (lastFrame == firstFrame && firstFrame < frameCount) lastFrame = firstFrame + 1; // shorter than a hop, still one frame
+    if (lastFrame <= firstFrame) return statistics;
+
+    const QVector<QVector<double>> &magnitudes = frames.magnitudes;
+    int bins = magnitudes[firstFrame].size();
+
+    QVector<int> batches;
+    for (int first = firstFrame; first < lastFrame; first += FRAMES_PER_BATCH) batches << first;
+    PowerSum sum = QtConcurrent::blockingMappedReduced<PowerSum>(batches, [&magnitudes, bins, lastFrame](int first) {
+        PowerSum partial;
+        partial.power.resize(bins);
+        double *power = partial.power.data();
+        int end = std::min(first + FRAMES_PER_BATCH, lastFrame);
+        for (int frame = first; frame < end; ++frame) {
+            const double *amplitudes = magnitudes[frame].constData();
+            for (int k = 0; k < bins; ++k) power[k] += amplitudes[k] * amplitudes[k];
+        }
+        partial.frames = end - first;
+        return partial;
+    }, [](PowerSum &total, const PowerSum &partial) {
+        if (total.power.isEmpty()) total.power.resize(partial.power.size());
+        for (qsizetype k = 0; k < partial.power.size(); ++k) total.power[k] += partial.power[k];
+        total.frames += partial.frames;
+    }, QtConcurrent::UnorderedReduce);
+    if (sum.frames == 0) return statistics;
+
+    // 2 * |X| of a full scale sine is the sum of the window
+    QVector<double> window;
+    Stft::hammingWindow(frames.windowSize, window);
+    double windowSum = std::accumulate(window.begin(), window.end(), 0.0);
+    double scale = 1.0 / (windowSum * windowSum * sum.frames);
+
+    statistics.frameCount = sum.frames;
+    statistics.binHz = frames.binFrequency(1) - frames.binFrequency(0);
+    statistics.ltasDb.resize(bins);
+    QVector<double> bandPower(BAND_COUNT);
+    double totalPower = 0.0;
+    double weightedFrequency = 0.0;
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+    int tiltBins = 0;
+    for (int k = 0; k < bins; ++k) {
+        double power = sum.power[k] * scale;
+        double frequency = frames.binFrequency(k);
+        double decibels = 10.0 * std::log10(std::max(power, MIN_POWER));
+        statistics.ltasDb[k] = decibels;
+
+        if (k > 0) {
+            totalPower += power;
+            weightedFrequency += frequency * power;
+        }
+        if (frequency >= TILT_MIN_HZ && frequency <= TILT_MAX_HZ) {
+            double octave = std::log2(frequency);
+            sumX += octave;
+            sumY += decibels;
+            sumXX += octave * octave;
+            sumXY += octave * decibels;
+            ++tiltBins;
+        }
+        for (int band = 0; band < BAND_COUNT; ++band) {
+            if (frequency >= bandEdges[band][0] && frequency < bandEdges[band][1]) bandPower[band] += power;
+        }
+    }
+
+    statistics.centroidHz = totalPower > 0.0 ? weightedFrequency / totalPower : 0.0;
+    double denominator = tiltBins * sumXX - sumX * sumX;
+    statistics.tiltDbPerOctave = tiltBins > 1 && denominator > 0.0 ? (tiltBins * sumXY - sumX * sumY) / denominator : 0.0;
+    statistics.bandEnergiesDb.resize(BAND_COUNT);
+    for (int band = 0; band < BAND_COUNT; ++band) {
+        statistics.bandEnergiesDb[band] = 10.0 * std::log10(std::max(bandPower[band], MIN_POWER));
+    }
+    return statistics;
+}
+
+QList<LtasStatistics> Ltas::computeSegments(const SpectralFrames &frames, const QList<QPair<double, double>> &segments) {
+    TRACE_SCOPE("Ltas::computeSegments");
+    QList<LtasStatistics> statistics;
+    statistics.reserve(segments.size());
+    for (const QPair<double, double> &segment : segments) statistics << compute(frames, segment.first, segment.second);
+    return statistics;
+}
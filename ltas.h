@@ -0,0 +1,72 @@
+#ifndef LTAS_H
+#define LTAS_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <QMetaType>
+#include "spectralframes.h"
+
+/*
+ * File: ltas.h
+ * Description:
+ *  This header file defines the 'Ltas' class, the long-term average spectrum of a stretch of the track and the spectral
+ *  statistics derived from it, and the 'LtasStatistics' struct holding them. It averages the STFT frames of the
+ *  'Spectrograph', so nothing is transformed again, for the whole file and for every segment of 'WaveFormSegments'.
+ *
+ * Purpose:
+ *  - Lets teachers compare the average spectra of learner and native recordings, per segment, inside the app
+ *
+ * Key Members:
+ *  - 'QVector<double> ltasDb': Mean power of every bin of the frames, dB relative to a full scale sine
+ *  - 'double binHz': Spacing of the bins
+ *  - 'double centroidHz': Power weighted mean frequency
+ *  - 'double tiltDbPerOctave': Slope of the LTAS against log frequency between TILT_MIN_HZ and TILT_MAX_HZ
+ *  - 'QVector<double> bandEnergiesDb': Energy of each band (octaves from 500 Hz to 8 kHz and the band below), dB like
+ *    ltasDb
+ *  - 'int frameCount': Frames averaged, 0 if there were none
+ *
+ * Public Methods:
+ *  - 'static LtasStatistics compute(const SpectralFrames &frames, double startProportion, double endProportion)': The
+ *    statistics of the frames starting inside [startProportion, endProportion) of the track
+ *  - 'static QList<LtasStatistics> computeSegments(const SpectralFrames &frames, const QList<QPair<double, double>> &segments)':
+ *    The statistics of each segment, start and end as proportions like 'WaveFormSegments' stores them
+ *  - 'static int bandCount()', 'static QString bandName(int band)': The bands of bandEnergiesDb, for display
+ *
+ * Notes:
+ *  - The power sum is a parallel reduction: frames are split into batches of FRAMES_PER_BATCH, each batch is summed by
+ *    a task and the partial sums are added as they finish. Only the statistics of the summed spectrum are sequential,
+ *    they are linear in the number of bins.
+ *  - Every frame counts, silent ones too, as in Praat's LTAS. Compare segments of similar content.
+ *
+ * References:
+ *  - Praat, "Sound: To Ltas..."
+ *  - https://en.wikipedia.org/wiki/Spectral_centroid
+ *  - Löfqvist, A. (1986). The long-time-average spectrum as a tool in voice research. Journal of Phonetics, 14.
+ */
+
+struct LtasStatistics
+{
+    QVector<double> ltasDb;
+    double binHz = 0.0;
+    double centroidHz = 0.0;
+    double tiltDbPerOctave = 0.0;
+    QVector<double> bandEnergiesDb;
+    int frameCount = 0;
+
+    bool isEmpty() const { return frameCount == 0; }
+};
+
+Q_DECLARE_METATYPE(LtasStatistics)
+
+class Ltas
+{
+public:
+    static LtasStatistics compute(const SpectralFrames &frames, double startProportion = 0.0, double endProportion = 1.0);
+    static QList<LtasStatistics> computeSegments(const SpectralFrames &frames, const QList<QPair<double, double>> &segments);
+    static int bandCount();
+    static QString bandName(int band);
+};
+
+#endif // LTAS_H
@@ -2,12 +2,18 @@
 
 #include <QApplication>
 #include <QStyleFactory>
+#include "tracer.h"
+#include "memorybudget.h"
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
     a.setStyle(QStyleFactory::create("Fusion"));
+    Tracer::startFromEnvironment();
+    MemoryBudget::setBudgetFromEnvironment();
     MainWindow w;
     w.show();
-    return a.exec();
+    int result = a.exec();
+    Tracer::finishFromEnvironment();
+    return result;
 }
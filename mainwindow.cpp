@@ -3,16 +3,17 @@
 #include <QAudioOutput>
 #include "audio.h"
 #include "spectrograph.h"
+#include "tracer.h"
+#include "workerpool.h"
 
 /*
  * File: mainwindow.cpp
  * Description:
  *  This source file impl:ements the 'MainWindow' class, providing functionality for the main UI.
- *  It initializes the main window, sets up the main layout in a vertical layout, and creates two
- *  'Audio' objects for dual audio playback functionality. The constructor creates the central widget,
- *  configures the vertical layout, and adds two 'Audio' widgets. The 'audio1' and 'audio2' widgets
- *  are integrated into the layout to enable independent audio playback and visualiztion within the
- *  UI layout.
+ *  It initializes the main window and makes a 'Workspace' its central widget. The constructor adds the
+ *  speaker and user tracks to the workspace and builds them right away, 'audio1' and 'audio2' and their
+ *  spectrographs are wired to each other here. Further speaker tracks are built by the workspace as they
+ *  scroll into view and only join the performance HUD.
  *
  * *Slots:
  *  - 'audio2ConnectAllowed(bool secondAudioExists)': emits a signal that the first audio
@@ -22,6 +23,14 @@
  *  - 'handleEndOfAudio2(bool disc)': connects/disconnects the second audio playing from the first incase the
  *      audios are two different sizes or are played simultaniously from different position and the second ends before
  *      the first.
+ *  - 'alignTracks()': runs 'DtwAligner::align' on the MFCCs of both spectrographs, the request counter drops results
+ *      of tracks that were replaced while it ran
+ *  - 'estimateOffset()': plans the FFT of the 'OffsetEstimator' here on the GUI thread (the FFTW planner is not thread
+ *      safe) and cross-correlates the envelopes of both tracks on a worker thread
+ *  - 'followSpeakerScrubber(double position)': linked scrubbing through the warp path, or the offset until there is one
+ *  - 'followSpeakerPlayPause()': linked playback, the user track starts from the speaker position shifted by the offset
+ *  - 'cueUserSegment(QPair<double, double> startEnd)': segment to segment mapping through the warp path
+ *  - 'addSpeakerTracks()': each selected file becomes a track named after the file, loaded once it is built
  * Notes:
  *  - The 'Audio' class is used for playback and visualization(*). See 'audio.h' and 'audio.cpp' for
  *    its implementation.
@@ -35,39 +44,58 @@
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), connected(false)
 {
-    QScrollArea *scrollArea = new QScrollArea(this);
     // create central widget
-    QWidget *center = new QWidget();
-    setCentralWidget(scrollArea);
-    scrollArea->setWidget(center);
-    scrollArea->show();
-    scrollArea->setWidgetResizable(true);
-
-    // create main layout for central widget
-    // this was V before
-    mainLayout = new QVBoxLayout(center);
-
-    audio1 = new Audio(nullptr, "Speaker Sound Wave");
-    mainLayout->addWidget(audio1);
-
-    // spectrograph 1
-    Spectrograph *spectrograph1 = new Spectrograph();
-    mainLayout->addWidget(spectrograph1, 0, Qt::AlignRight);
-    connect(audio1, &Audio::audioFileSelected, spectrograph1, &Spectrograph::loadAudioFile);
+    workspace = new Workspace(this);
+    setCentralWidget(workspace);
+
+    // the two compared tracks, built now so they can be wired to each other
+    int speakerTrack = workspace->addTrack("Speaker Sound Wave", 0);
+    int userTrack = workspace->addTrack("User Sound Wave", 1);
+    workspace->ensureBuilt(speakerTrack);
+    workspace->ensureBuilt(userTrack);
+    audio1 = workspace->audio(speakerTrack);
+    spectrograph1 = workspace->spectrograph(speakerTrack);
+    audio2 = workspace->audio(userTrack);
+    spectrograph2 = workspace->spectrograph(userTrack);
+    connect(workspace, &Workspace::trackBuilt, this, &MainWindow::trackBuilt);
+
     connect(audio1->alignAllAudioFocus, &QCheckBox::clicked, this, &MainWindow::audio2Connect);
     connect(this, &MainWindow::canEnableAudioAlignment, audio1, &Audio::enableAudioAligning);
-    audio2 = new Audio(nullptr, "User Sound Wave", 1);
-    mainLayout->addWidget(audio2);
-
-    // spectrograph 2
-    Spectrograph *spectrograph2 = new Spectrograph();
-    mainLayout->addWidget(spectrograph2, 0, Qt::AlignRight);
-    connect(audio2, &Audio::audioFileSelected, spectrograph2, &Spectrograph::loadAudioFile);
     connect(audio2, &Audio::secondAudioExists, this, &MainWindow::audio2ConnectAllowed);
     connect(this, &MainWindow::disableAudio2, audio2, &Audio::disableAudioControls);
     connect(audio2, &Audio::audioEnded, this, &MainWindow::handleEndOfAudio2);
     connect(audio1, &Audio::audioEnded, this, &MainWindow::handleEndOfAudio2);
-    center->setLayout(mainLayout);
+
+    // DTW alignment of the two tracks
+    connect(audio1, &Audio::audioFileSelected, this, &MainWindow::clearAlignment);
+    connect(audio2, &Audio::audioFileSelected, this, &MainWindow::clearAlignment);
+    connect(spectrograph1, &Spectrograph::mfccFeaturesReady, this, &MainWindow::alignTracks);
+    connect(spectrograph2, &Spectrograph::mfccFeaturesReady, this, &MainWindow::alignTracks);
+    connect(&alignmentWatcher, &QFutureWatcher<WarpPath>::finished, this, &MainWindow::alignmentFinished);
+    connect(audio1, &Audio::segmentPlayRequested, this, &MainWindow::cueUserSegment);
+
+    // leading silence offset between the tracks
+    connect(spectrograph1, &Spectrograph::samplesDecoded, this, &MainWindow::estimateOffset);
+    connect(spectrograph2, &Spectrograph::samplesDecoded, this, &MainWindow::estimateOffset);
+    connect(&offsetWatcher, &QFutureWatcher<TrackOffset>::finished, this, &MainWindow::offsetEstimated);
+
+    QMenu *fileMenu = menuBar()->addMenu("File");
+    fileMenu->addAction("Add speaker tracks...", this, &MainWindow::addSpeakerTracks);
+
+    // tracing of the hot paths, PHONETICS_TRACE may have started it already
+    QMenu *debugMenu = menuBar()->addMenu("Debug");
+    QAction *recordTraceAction = debugMenu->addAction("Record trace");
+    recordTraceAction->setCheckable(true);
+    recordTraceAction->setChecked(Tracer::isEnabled());
+    connect(recordTraceAction, &QAction::toggled, this, &MainWindow::recordTrace);
+    debugMenu->addAction("Save trace...", this, &MainWindow::saveTrace);
+
+    performanceHud = new PerformanceHud(this);
+    performanceHud->addTrack("Speaker", audio1, spectrograph1);
+    performanceHud->addTrack("User", audio2, spectrograph2);
+    QAction *hudAction = debugMenu->addAction("Performance HUD");
+    hudAction->setCheckable(true);
+    connect(hudAction, &QAction::toggled, performanceHud, &PerformanceHud::setActive);
 }
 //all based on audio 0, the zoom, whenever one reaches the end, both stop, play pause affected, segment click stops allignment
 void MainWindow::audio2ConnectAllowed(bool secondAudioExists){
@@ -77,30 +105,98 @@ void MainWindow::audio2Connect(bool connectAudios){
     if (connectAudios){
         emit disableAudio2(true);
         connected = true;
-        connect(audio1, &Audio::playPauseActivated, audio2, &Audio::handlePlayPause);
+        connect(audio1, &Audio::playPauseActivated, this, &MainWindow::followSpeakerPlayPause);
         connect(audio1->zoomButtons, &Zoom::horizontalSliderChanged, audio2->zoomButtons, &Zoom::horizontalZoom);
         connect(audio1->zoomButtons, &Zoom::verticalSliderChanged, audio2->zoomButtons, &Zoom::verticalZoom);
         connect(audio1->zoomButtons, &Zoom::resetZoomActivated, audio2->zoomButtons, &Zoom::resetZoom);
-        connect(audio1, &Audio::scrubberUpdate, audio2, &Audio::updateTrackPositionFromScrubber);
+        connect(audio1, &Audio::scrubberUpdate, this, &MainWindow::followSpeakerScrubber);
+        followSpeakerScrubber(audio1->getTrackProportion());
     }
     else{
         emit disableAudio2(false);
         connected = false;
-        disconnect(audio1, &Audio::playPauseActivated, audio2, &Audio::handlePlayPause);
+        disconnect(audio1, &Audio::playPauseActivated, this, &MainWindow::followSpeakerPlayPause);
         disconnect(audio1->zoomButtons, &Zoom::horizontalSliderChanged, audio2->zoomButtons, &Zoom::horizontalZoom);
         disconnect(audio1->zoomButtons, &Zoom::verticalSliderChanged, audio2->zoomButtons, &Zoom::verticalZoom);
         disconnect(audio1->zoomButtons, &Zoom::resetZoomActivated, audio2->zoomButtons, &Zoom::resetZoom);
-        disconnect(audio1, &Audio::scrubberUpdate, audio2, &Audio::updateTrackPositionFromScrubber);
+        disconnect(audio1, &Audio::scrubberUpdate, this, &MainWindow::followSpeakerScrubber);
     }
 }
 void MainWindow::handleEndOfAudio2(bool disc){
     if (disc && connected){
         connected = false;
-        disconnect(audio1, &Audio::playPauseActivated, audio2, &Audio::handlePlayPause);
+        disconnect(audio1, &Audio::playPauseActivated, this, &MainWindow::followSpeakerPlayPause);
     }else if (!connected && !disc){
         connected = true;
-        connect(audio1, &Audio::playPauseActivated, audio2, &Audio::handlePlayPause);
+        connect(audio1, &Audio::playPauseActivated, this, &MainWindow::followSpeakerPlayPause);
+    }
+}
+
+void MainWindow::alignTracks() {
+    MfccFeatures speaker = spectrograph1->getMfccFeatures();
+    MfccFeatures user = spectrograph2->getMfccFeatures();
+    if (speaker.isEmpty() || user.isEmpty()) return;
+
+    runningAlignmentRequest = ++alignmentRequest;
+    // the alignment and the offset are the learner's feedback, queued like the learner track's own analyses
+    alignmentWatcher.setFuture(WorkerPool::run(WorkerPool::Learner, [speaker, user]() {
+        return DtwAligner::align(speaker, user);
+    }));
+}
+
+void MainWindow::alignmentFinished() {
+    if (runningAlignmentRequest != alignmentRequest) return;
+    warpPath = alignmentWatcher.result();
+}
+
+void MainWindow::clearAlignment() {
+    ++alignmentRequest;
+    warpPath = WarpPath();
+    ++offsetRequest;
+    trackOffset = TrackOffset();
+}
+
+void MainWindow::estimateOffset() {
+    QVector<double> speaker = spectrograph1->getDecodedSamples();
+    QVector<double> user = spectrograph2->getDecodedSamples();
+    int speakerRate = spectrograph1->getSampleRate();
+    int userRate = spectrograph2->getSampleRate();
+    if (speaker.isEmpty() || user.isEmpty()) return;
+
+    int fftSize = OffsetEstimator::fftSizeFor(speaker.size(), speakerRate, user.size(), userRate);
+    if (!offsetEstimator || offsetEstimator->getFftSize() != fftSize) {
+        offsetEstimator = std::make_shared<OffsetEstimator>(fftSize);
     }
+
+    runningOffsetRequest = ++offsetRequest;
+    std::shared_ptr<OffsetEstimator> estimator = offsetEstimator;
+    offsetWatcher.setFuture(WorkerPool::run(WorkerPool::Learner, [estimator, speaker, speakerRate, user, userRate]() {
+        return estimator->estimate(speaker, speakerRate, user, userRate);
+    }));
+}
+
+void MainWindow::offsetEstimated() {
+    if (runningOffsetRequest != offsetRequest) return;
+    trackOffset = offsetWatcher.result();
+}
+
+void MainWindow::followSpeakerScrubber(double position) {
+    double userPosition = warpPath.isEmpty() ? trackOffset.mapProportion(position) : warpPath.mapProportion(position);
+    audio2->updateTrackPositionFromScrubber(std::clamp(userPosition, 0.0, 1.0));
+}
+
+void MainWindow::followSpeakerPlayPause() {
+    // only a start is lined up with the speaker, pausing leaves the user track where it is
+    if (!audio2->isPlaying() && trackOffset.valid) {
+        double userPosition = trackOffset.mapProportion(audio1->getTrackProportion());
+        audio2->seekPlayer(std::clamp(userPosition, 0.0, 1.0));
+    }
+    audio2->handlePlayPause();
+}
+
+void MainWindow::cueUserSegment(QPair<double, double> startEnd) {
+    if (warpPath.isEmpty()) return;
+    audio2->updateTrackPositionFromScrubber(warpPath.mapSegment(startEnd).first);
 }
 
 MainWindow::~MainWindow() {
@@ -112,3 +208,24 @@ MainWindow::~MainWindow() {
 
 
 
+
+void MainWindow::addSpeakerTracks() {
+    QList<QUrl> files = QFileDialog::getOpenFileUrls(this, "Select speaker recordings");
+    for (const QUrl &file : files) workspace->addTrack(file.fileName(), 2, file);
+}
+
+void MainWindow::trackBuilt(int index) {
+    performanceHud->addTrack(workspace->trackName(index), workspace->audio(index), workspace->spectrograph(index));
+}
+
+void MainWindow::recordTrace(bool record) {
+    Tracer::setEnabled(record);
+}
+
+void MainWindow::saveTrace() {
+    QString fileName = QFileDialog::getSaveFileName(this, "Save trace", "phonetics-trace.json", "Chrome trace (*.json)");
+    if (fileName.isEmpty()) return;
+    if (!Tracer::writeChromeTrace(fileName)) {
+        QMessageBox::warning(this, "Save trace", "Could not write " + fileName);
+    }
+}
@@ -3,25 +3,36 @@
 
 #include <QMainWindow>
 #include <QHBoxLayout>
+#include <QFutureWatcher>
 #include "audio.h"
+#include "spectrograph.h"
+#include "dtwaligner.h"
+#include "offsetestimator.h"
+#include "performancehud.h"
+#include "workspace.h"
+#include <memory>
 
 /*
  * File: mainwindow.h
  * Description:
  *  This header file defines the 'MainWindow' class, which provides the main UI for the
- *  application. It inherits from QMainWindow and creates two instances of the 'Audio'
- *  class to represent dual Audio widgets. It uses a vertical layout (QVBoxLayout) for
- *  organization and embeds the Audio widgets.
+ *  application. It inherits from QMainWindow and shows the tracks in a 'Workspace': the speaker
+ *  and user tracks, which are compared with each other, and any further speakers added from
+ *  the File menu.
  *
  * Purpose:
  *  - Serves as primary UI, enabling interactions with audio playback
- *  - Organizes main layout within a 'QVBoxLayout'
- *  - Initializes and manages child components for the two Audio objects
+ *  - Organizes the tracks within a 'Workspace' that builds them as they scroll into view
+ *  - Initializes and manages child components for the two compared Audio objects
  *
  * Key Members:
- *  - 'QVBoxLayout *mainLayout': Vertical layout for arranging UI elements (audio players)
- *  - 'Audio *audio1': First audio player widget
- *  - 'Audio *audio2': Second audio player widget
+ *  - 'Workspace *workspace': Scrollable list of all tracks, the speaker and user tracks are built right away
+ *  - 'Audio *audio1': Speaker track of the workspace
+ *  - 'Audio *audio2': User track of the workspace
+ *  - 'Spectrograph *spectrograph1, *spectrograph2': Spectrograms of the two tracks, they also hold the MFCC features
+ *  - 'WarpPath warpPath': DTW alignment of the user track to the speaker track, empty until both tracks have features
+ *  - 'TrackOffset trackOffset': Time offset between the tracks from their energy envelopes, invalid until both are decoded
+ *  - 'PerformanceHud *performanceHud': Frame time, memory and scrubber sync overlay, toggled in the Debug menu
  *
  * Public Methods:
  *  - 'MainWindow(QWidget *parent = nullptr)': Constructor to initialize main window layout
@@ -35,6 +46,21 @@
  *  - 'void handleEndOfAudio2(bool disc)': connects/disconnects the second audio playing from the first incase the
  *      audios are two different sizes or are played simultaniously from different position and the second ends before
  *      the first.
+ *  - 'void alignTracks()': runs the DTW alignment of the two tracks' MFCCs on a worker thread once both are ready
+ *  - 'void alignmentFinished()': keeps the warp path of the worker thread
+ *  - 'void clearAlignment()': drops the warp path (and a running alignment) when either track gets a new file
+ *  - 'void estimateOffset()': runs the 'OffsetEstimator' on the decoded samples of both tracks on a worker thread
+ *  - 'void offsetEstimated()': keeps the offset of the worker thread
+ *  - 'void followSpeakerScrubber(double position)': moves the user scrubber to the position the warp path maps the
+ *      speaker position to, shifted by the track offset if there is no warp path yet
+ *  - 'void followSpeakerPlayPause()': plays/pauses the user track with the speaker, when it starts it is first moved
+ *      to the speaker position shifted by the track offset
+ *  - 'void cueUserSegment(QPair<double, double> startEnd)': moves the user track to the start of the part that goes
+ *      with the speaker segment being played
+ *  - 'void recordTrace(bool record)': Debug menu, starts or stops recording trace spans with the 'Tracer'
+ *  - 'void saveTrace()': Debug menu, saves the recorded spans as Chrome trace JSON
+ *  - 'void addSpeakerTracks()': File menu, adds a speaker track for each selected file
+ *  - 'void trackBuilt(int index)': adds a further speaker track to the performance HUD once the workspace built it
  * Signals:
  *  - 'void disableAudio2(bool disableAudio)': sends a signal to enable/disable audio2 controls when the audio1 controls have taken over
  *  - 'void canEnableAudioAlignment(bool enable)': signal that the checkbox for aligning audio can be enabled on audio1 if audio2 exists
@@ -47,11 +73,26 @@ class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
-    QVBoxLayout *mainLayout;
+    Workspace *workspace;
     Audio *audio1;
     Audio *audio2;
+    Spectrograph *spectrograph1;
+    Spectrograph *spectrograph2;
     bool connected;
 
+    WarpPath warpPath;
+    QFutureWatcher<WarpPath> alignmentWatcher;
+    int alignmentRequest = 0;
+    int runningAlignmentRequest = -1;
+
+    TrackOffset trackOffset;
+    std::shared_ptr<OffsetEstimator> offsetEstimator;
+    QFutureWatcher<TrackOffset> offsetWatcher;
+    int offsetRequest = 0;
+    int runningOffsetRequest = -1;
+
+    PerformanceHud *performanceHud;
+
 public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
@@ -60,6 +101,18 @@ public slots:
     void audio2ConnectAllowed(bool secondAudioExists);
     void audio2Connect(bool connectAudios);
     void handleEndOfAudio2(bool disc);
+    void alignTracks();
+    void alignmentFinished();
+    void clearAlignment();
+    void estimateOffset();
+    void offsetEstimated();
+    void followSpeakerScrubber(double position);
+    void followSpeakerPlayPause();
+    void cueUserSegment(QPair<double, double> startEnd);
+    void recordTrace(bool record);
+    void saveTrace();
+    void addSpeakerTracks();
+    void trackBuilt(int index);
 
 signals:
     void disableAudio2(bool disableAudio);
@@ -0,0 +1,124 @@
+#include "memorybudget.h"
+#include <QHash>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include "tracer.h"
+
+/*
+ * File: memorybudget.cpp
+ * Description:
+ *  This source file implements the 'MemoryBudget'. Every entry remembers the value of a use counter from its last use,
+ *  'enforce()' sorts the entries that have an evictor by it and evicts from the oldest until the total fits. It runs
+ *  once per event loop iteration at most, whenever setBytes() left the total over the budget.
+ */
+
+#define DEFAULT_BUDGET_MB 1024
+
+struct BudgetEntry
+{
+    QString name;
+    qint64 bytes = 0;
+    quint64 lastUse = 0;
+    MemoryBudget::Evictor evictor;
+};
+
+static QHash<int, BudgetEntry> entries;
+static int nextId = 0;
+static quint64 useClock = 0;
+static qint64 totalBytes = 0;
+static qint64 totalEvicted = 0;
+static qint64 budget = qint64(DEFAULT_BUDGET_MB) * 1024 * 1024;
+static bool enforceQueued = false;
+static bool evicting = false; // setBytes() of an evictor is not a use
+
+int MemoryBudget::add(const QString &name, Evictor evictor) {
+    BudgetEntry entry;
+    entry.name = name;
+    entry.lastUse = ++useClock;
+    entry.evictor = evictor;
+    entries.insert(++nextId, entry);
+    return nextId;
+}
+
+void MemoryBudget::remove(int id) {
+    auto entry = entries.find(id);
+    if (entry == entries.end()) return;
+    totalBytes -= entry->bytes;
+    entries.erase(entry);
+}
+
+void MemoryBudget::setBytes(int id, qint64 bytes) {
+    auto entry = entries.find(id);
+    if (entry == entries.end()) return;
+    totalBytes += bytes - entry->bytes;
+    entry->bytes = bytes;
+    if (!evicting) entry->lastUse = ++useClock;
+
+    if (totalBytes > budget && !enforceQueued) {
+        enforceQueued = true;
+        QTimer::singleShot(0, &MemoryBudget::enforce);
+    }
+}
+
+void MemoryBudget::touch(int id) {
+    auto entry = entries.find(id);
+    if (entry != entries.end()) entry->lastUse = ++useClock;
+}
+
+qint64 MemoryBudget::usedBytes() {
+    return totalBytes;
+}
+
+qint64 MemoryBudget::evictedBytes() {
+    return totalEvicted;
+}
+
+qint64 MemoryBudget::getBudget() {
+    return budget;
+}
+
+void MemoryBudget::setBudget(qint64 bytes) {
+    budget = std::max<qint64>(bytes, 0);
+    if (totalBytes > budget && !enforceQueued) {
+        enforceQueued = true;
+        QTimer::singleShot(0, &MemoryBudget::enforce);
+    }
+}
+
+void MemoryBudget::setBudgetFromEnvironment() {
+    bool ok = false;
+    qint64 megabytes = qEnvironmentVariable("PHONETICS_MEMORY_BUDGET_MB").toLongLong(&ok);
+    if (ok && megabytes > 0) setBudget(megabytes * 1024 * 1024);
+}
+
+void MemoryBudget::enforce() {
+    TRACE_SCOPE("MemoryBudget::enforce");
+    if (totalBytes <= budget) {
+        enforceQueued = false;
+        return;
+    }
+
+    QList<int> candidates;
+    for (auto entry = entries.cbegin(); entry != entries.cend(); ++entry) {
+        if (entry->evictor && entry->bytes > 0) candidates << entry.key();
+    }
+    std::sort(candidates.begin(), candidates.end(), [](int a, int b) {
+        return entries.value(a).lastUse < entries.value(b).lastUse;
+    });
+
+    evicting = true;
+    for (int id : std::as_const(candidates)) {
+        if (totalBytes <= budget) break;
+        if (!entries.contains(id)) continue; // an earlier evictor removed it
+        qint64 before = entries.value(id).bytes;
+        Evictor evictor = entries.value(id).evictor; // the evictor may remove its entry
+        evictor();
+        qint64 freed = before - entries.value(id).bytes;
+        if (freed > 0) totalEvicted += freed;
+    }
+    evicting = false;
+    enforceQueued = false; // the setBytes() calls of the evictors did not queue another pass
+
+    if (totalBytes > budget) qWarning() << "Memory budget exceeded by data that cannot be evicted:" << (totalBytes - budget) / (1024 * 1024) << "MB";
+}
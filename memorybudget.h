@@ -0,0 +1,55 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QString>
+#include <functional>
+
+/*
+ * File: memorybudget.h
+ * Description:
+ *  This header file defines the 'MemoryBudget' class, the bookkeeping of the bytes every track holds: the waveform
+ *  samples, the decoded samples and spectrogram frames of the 'Spectrograph', the segments and the segment charts. Each
+ *  holder adds an entry and keeps its byte count up to date. Once the total is over the budget the least recently used
+ *  entries that can be rebuilt are evicted until it fits again, their owners reload or recompute them the next time
+ *  they are used.
+ *
+ * Public Methods:
+ *  - 'static int add(const QString &name, Evictor evictor = Evictor())': Adds an entry and returns its id. Entries
+ *    without an evictor are only counted
+ *  - 'static void remove(int id)': Forgets the entry, owners call it when they are destroyed
+ *  - 'static void setBytes(int id, qint64 bytes)': Bytes the entry holds now, also counts as a use
+ *  - 'static void touch(int id)': The entry was used, so it is the last to be evicted
+ *  - 'static qint64 usedBytes()', 'static qint64 evictedBytes()': Bytes held by all entries and bytes evicted so far
+ *  - 'static qint64 getBudget()', 'static void setBudget(qint64 bytes)': DEFAULT_BUDGET_MB unless changed
+ *  - 'static void setBudgetFromEnvironment()': Takes the budget from PHONETICS_MEMORY_BUDGET_MB if it is set
+ *
+ * Notes:
+ *  - Everything runs on the GUI thread. Eviction is queued to the event loop instead of running inside setBytes(), so
+ *    no caller loses data it is still working with.
+ *  - An evictor frees what it can and reports what it still holds with setBytes(). It may decline, e.g. while the data
+ *    is still needed by an analysis that has not finished.
+ *
+ * References:
+ *  - https://en.wikipedia.org/wiki/Cache_replacement_policies#Least_recently_used_(LRU)
+ */
+
+class MemoryBudget
+{
+public:
+    typedef std::function<void()> Evictor;
+
+    static int add(const QString &name, Evictor evictor = Evictor());
+    static void remove(int id);
+    static void setBytes(int id, qint64 bytes);
+    static void touch(int id);
+    static qint64 usedBytes();
+    static qint64 evictedBytes();
+    static qint64 getBudget();
+    static void setBudget(qint64 bytes);
+    static void setBudgetFromEnvironment();
+
+private:
+    static void enforce();
+};
+
+#endif // MEMORYBUDGET_H
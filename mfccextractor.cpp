@@ -0,0 +1,146 @@
+#include "mfccextractor.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+/*
+ * File: mfccextractor.cpp
+ * Description:
+ *  This source file implements the 'MfccExtractor'. The mel bands are triangles spaced evenly on the mel scale between
+ *  MEL_LOW_HZ and MEL_HIGH_HZ (or the Nyquist frequency if it is lower). For a block of frames the power spectra are
+ *  written next to each other, every band is a short dot product of its weights with one run of bins, the log of the
+ *  band energies is the log-mel spectrum and its DCT the cepstrum.
+ *
+ * Key Methods:
+ *  - 'MfccExtractor()': Builds the sparse filterbank and the DCT matrix
+ *  - 'extract()': Splits the frames into blocks of FRAMES_PER_TASK and runs them with QtConcurrent::blockingMap
+ *  - 'extractBlock()': Filterbank and DCT for one block, the inner loops are contiguous float multiply-adds the compiler
+ *    vectorizes
+ *
+ * Notes:
+ *  - About 26 * 10 multiply-adds for the filterbank and 13 * 26 for the DCT per frame, a 1024 sample frame is 23 ms of
+ *    audio at 44.1 kHz, so a minute of audio is a few million operations, far beyond hundreds of times real time.
+ *
+ * References:
+ *  - https://en.wikipedia.org/wiki/Mel_scale
+ *  - https://en.wikipedia.org/wiki/Discrete_cosine_transform#DCT-II
+ */
+
+#define MEL_LOW_HZ 20.0
+#define MEL_HIGH_HZ 8000.0
+#define LOG_FLOOR 1e-10f // keeps silent bands finite
+#define FRAMES_PER_TASK 256
+
+static double hzToMel(double hz) {
+    return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+static double melToHz(double mel) {
+    return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+}
+
+MfccExtractor::MfccExtractor(int _windowSize, int _sampleRate, int _melBandCount, int _coefficientCount)
+    : windowSize(std::max(_windowSize, 2)), sampleRate(std::max(_sampleRate, 1)),
+      melBandCount(std::max(_melBandCount, 1)), coefficientCount(std::clamp(_coefficientCount, 1, melBandCount))
+{
+    int bins = windowSize / 2;
+    double binHz = (double) sampleRate / windowSize;
+    double lowMel = hzToMel(MEL_LOW_HZ);
+    double highMel = hzToMel(std::min(MEL_HIGH_HZ, sampleRate / 2.0));
+
+    // melBandCount + 2 edges, band b rises from edge b to edge b + 1 and falls to edge b + 2
+    QVector<double> edges(melBandCount + 2);
+    for (int i = 0; i < edges.size(); ++i) {
+        edges[i] = melToHz(lowMel + (highMel - lowMel) * i / (melBandCount + 1));
+    }
+
+    bandFirstBin.resize(melBandCount);
+    bandOffset.resize(melBandCount + 1);
+    for (int band = 0; band < melBandCount; ++band) {
+        double low = edges[band];
+        double center = edges[band + 1];
+        double high = edges[band + 2];
+        int first = std::clamp((int) std::ceil(low / binHz), 1, bins - 1); // bin 0 is the DC offset
+        int last = std::clamp((int) std::floor(high / binHz), first, bins - 1);
+
+        bandFirstBin[band] = first;
+        bandOffset[band] = weights.size();
+        for (int bin = first; bin <= last; ++bin) {
+            double hz = bin * binHz;
+            double weight = hz <= center ? (hz - low) / (center - low) : (high - hz) / (high - center);
+            weights << (float) std::max(weight, 0.0);
+        }
+    }
+    bandOffset[melBandCount] = weights.size();
+
+    dctMatrix.resize(coefficientCount * melBandCount);
+    for (int c = 0; c < coefficientCount; ++c) {
+        double scale = std::sqrt((c == 0 ? 1.0 : 2.0) / melBandCount);
+        for (int band = 0; band < melBandCount; ++band) {
+            dctMatrix[c * melBandCount + band] = (float) (scale * std::cos(M_PI * c * (band + 0.5) / melBandCount));
+        }
+    }
+}
+
+bool MfccExtractor::matches(const SpectralFrames &frames) const {
+    return frames.windowSize == windowSize && frames.sampleRate == sampleRate;
+}
+
+MfccFeatures MfccExtractor::extract(const SpectralFrames &frames) const {
+    MfccFeatures features;
+    features.coefficientCount = coefficientCount;
+    features.melBandCount = melBandCount;
+    features.windowSize = frames.windowSize;
+    features.hopSize = frames.hopSize;
+    features.sampleRate = frames.sampleRate;
+    features.numSamples = frames.numSamples;
+    if (frames.isEmpty() || !matches(frames)) return features;
+
+    int numFrames = frames.magnitudes.size();
+    features.mfcc.resize((qsizetype) numFrames * coefficientCount);
+    features.logMel.resize((qsizetype) numFrames * melBandCount);
+    float *mfcc = features.mfcc.data();
+    float *logMel = features.logMel.data();
+
+    QVector<int> blocks;
+    for (int firstFrame = 0; firstFrame < numFrames; firstFrame += FRAMES_PER_TASK) blocks << firstFrame;
+    QtConcurrent::blockingMap(blocks, [&](int firstFrame) {
+        int count = std::min(FRAMES_PER_TASK, numFrames - firstFrame);
+        extractBlock(frames, firstFrame, count, mfcc + (qsizetype) firstFrame * coefficientCount,
+                     logMel + (qsizetype) firstFrame * melBandCount);
+    });
+    return features;
+}
+
+void MfccExtractor::extractBlock(const SpectralFrames &frames, int firstFrame, int frameCount, float *mfcc, float *logMel) const {
+    int bins = windowSize / 2;
+    QVector<float> power(bins);
+    float *powerData = power.data();
+    const float *weightData = weights.constData();
+    const float *dct = dctMatrix.constData();
+
+    for (int f = 0; f < frameCount; ++f) {
+        const double *magnitude = frames.magnitudes[firstFrame + f].constData();
+        for (int bin = 0; bin < bins; ++bin) {
+            powerData[bin] = (float) (magnitude[bin] * magnitude[bin]);
+        }
+
+        float *melRow = logMel + (qsizetype) f * melBandCount;
+        for (int band = 0; band < melBandCount; ++band) {
+            const float *bandWeights = weightData + bandOffset[band];
+            const float *bandPower = powerData + bandFirstBin[band];
+            int width = bandOffset[band + 1] - bandOffset[band];
+            float energy = 0.0f;
+            for (int i = 0; i < width; ++i) energy += bandWeights[i] * bandPower[i];
+            melRow[band] = std::log(std::max(energy, LOG_FLOOR));
+        }
+
+        float *cepstrum = mfcc + (qsizetype) f * coefficientCount;
+        for (int c = 0; c < coefficientCount; ++c) {
+            const float *row = dct + c * melBandCount;
+            float sum = 0.0f;
+            for (int band = 0; band < melBandCount; ++band) sum += row[band] * melRow[band];
+            cepstrum[c] = sum;
+        }
+    }
+}
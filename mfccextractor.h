@@ -0,0 +1,80 @@
+#ifndef MFCCEXTRACTOR_H
+#define MFCCEXTRACTOR_H
+
+#include <QVector>
+#include <QMetaType>
+#include "spectralframes.h"
+
+/*
+ * File: mfccextractor.h
+ * Description:
+ *  This header file defines the 'MfccExtractor' class, which turns the STFT frames of the 'Spectrograph' into log-mel
+ *  energies and mel frequency cepstral coefficients (MFCC), and the 'MfccFeatures' struct holding them for one track.
+ *
+ * Purpose:
+ *  - A feature layer the comparisons between speaker and user (alignment, distances) build on, computed once per track
+ *    from frames that already exist instead of from the raw samples
+ *
+ * Key Members:
+ *  - 'QVector<int> bandFirstBin, bandOffset': First FFT bin of every mel band and where its weights start in 'weights',
+ *    the filterbank is stored sparse since every triangle only covers a few bins
+ *  - 'QVector<float> weights': Non zero weights of all bands one after the other
+ *  - 'QVector<float> dctMatrix': coefficientCount x melBandCount orthonormal DCT-II, row-major
+ *
+ * Public Methods:
+ *  - 'MfccExtractor(int windowSize, int sampleRate, int melBandCount = 26, int coefficientCount = 13)': Builds the
+ *    filterbank for the frames of one window size and sample rate
+ *  - 'bool matches(const SpectralFrames &frames) const': True if the filterbank was built for these frames
+ *  - 'MfccFeatures extract(const SpectralFrames &frames) const': Features of every frame, frames are split into blocks
+ *    processed in parallel by the global thread pool
+ *
+ * Notes:
+ *  - Both arrays of 'MfccFeatures' are frame-major and contiguous, the features of one frame are next to each other so
+ *    distance computations between two frames read a single short run of memory.
+ *
+ * References:
+ *  - Davis, S., & Mermelstein, P. (1980). Comparison of parametric representations for monosyllabic word recognition
+ *    in continuously spoken sentences.
+ */
+
+struct MfccFeatures
+{
+    QVector<float> mfcc; // coefficientCount values per frame
+    QVector<float> logMel; // melBandCount values per frame
+    int coefficientCount = 0;
+    int melBandCount = 0;
+    int windowSize = 0;
+    int hopSize = 0;
+    int sampleRate = 0;
+    qint64 numSamples = 0;
+
+    int frameCount() const { return coefficientCount > 0 ? mfcc.size() / coefficientCount : 0; }
+    bool isEmpty() const { return mfcc.isEmpty() || numSamples == 0; }
+    const float *frame(int index) const { return mfcc.constData() + (qsizetype) index * coefficientCount; }
+    double frameToProportion(int frame) const { return (double) frame * hopSize / numSamples; }
+    int proportionToFrame(double proportion) const { return qRound(proportion * numSamples / hopSize); }
+};
+
+Q_DECLARE_METATYPE(MfccFeatures)
+
+class MfccExtractor
+{
+    int windowSize;
+    int sampleRate;
+    int melBandCount;
+    int coefficientCount;
+    QVector<int> bandFirstBin;
+    QVector<int> bandOffset; // melBandCount + 1 entries, band b owns weights[bandOffset[b] .. bandOffset[b + 1])
+    QVector<float> weights;
+    QVector<float> dctMatrix;
+
+    void extractBlock(const SpectralFrames &frames, int firstFrame, int frameCount, float *mfcc, float *logMel) const;
+
+public:
+    MfccExtractor(int windowSize, int sampleRate, int melBandCount = 26, int coefficientCount = 13);
+
+    bool matches(const SpectralFrames &frames) const;
+    MfccFeatures extract(const SpectralFrames &frames) const;
+};
+
+#endif // MFCCEXTRACTOR_H
@@ -0,0 +1,260 @@
+#include "multiresolutionstft.h"
+#include "stft.h"
+#include "tracer.h"
+#include <algorithm>
+#include <cmath>
+
+/*
+ * File: multiresolutionstft.cpp
+ * Description:
+ *  This source file implements the 'MultiResolutionStft'. Frames are processed in batches: one loop over the frame
+ *  centres of a batch cuts and windows the frame of every resolution around each centre, then each plan transforms its
+ *  whole batch with one fftw_execute. The centres start half the longest window into the signal, so frame k of every
+ *  resolution covers the same instant and no frame reaches past the samples.
+ *
+ *  For a range the samples are decimated by the largest factor that keeps ZOOM_RATE_MARGIN times the width of the
+ *  range, through a windowed sinc low pass of ZOOM_FILTER_TAPS_PER_DECIMATION taps per unit of decimation. The shift to
+ *  the centre of the range is folded into the filter taps, so only one complex rotation per decimated sample is left.
+ *  Amplitudes are scaled to match 2 * |X(k)| of the whole band 'Stft' for the same window length in time.
+ *
+ * References:
+ *  - https://www.fftw.org/fftw3_doc/Advanced-Complex-DFTs.html
+ *  - https://en.wikipedia.org/wiki/Sinc_filter
+ *  - https://en.wikipedia.org/wiki/Zoom_FFT
+ */
+
+#define WIDEBAND_MS 5.0
+#define NARROWBAND_MS 30.0
+#define FRAMES_PER_BATCH 64
+#define MAX_DISPLAY_FRAMES 4096
+#define ZOOM_RATE_MARGIN 1.25
+#define ZOOM_FILTER_TAPS_PER_DECIMATION 8
+#define ZOOM_PADDING 2
+
+MultiResolutionStft::MultiResolutionStft(int _sampleRate, double _lowHz, double _highHz)
+    : sampleRate(std::max(_sampleRate, 1))
+{
+    double nyquist = sampleRate / 2.0;
+    highHz = _highHz > 0.0 ? std::min(_highHz, nyquist) : nyquist;
+    lowHz = std::clamp(_lowHz, 0.0, highHz);
+    if (highHz - lowHz < 1.0) lowHz = 0.0; // no range at all, the whole band up to highHz
+
+    double bandwidth = highHz - lowHz;
+    decimation = std::max(1, int(sampleRate / (bandwidth * ZOOM_RATE_MARGIN)));
+    if (decimation > 1) {
+        centreHz = (lowHz + highHz) / 2.0;
+
+        // windowed sinc low pass at half the range, shifted up to the centre of the range
+        int taps = ZOOM_FILTER_TAPS_PER_DECIMATION * decimation + 1;
+        int middle = taps / 2;
+        double cutoff = bandwidth / 2.0 / sampleRate;
+        QVector<double> window;
+        Stft::hammingWindow(taps, window);
+        QVector<double> lowPass(taps);
+        double sum = 0.0;
+        for (int k = 0; k < taps; ++k) {
+            double x = 2.0 * cutoff * (k - middle);
+            lowPass[k] = 2.0 * cutoff * (x == 0.0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x)) * window[k];
+            sum += lowPass[k];
+        }
+        bandFilter.resize(taps);
+        double omega = 2.0 * M_PI * centreHz / sampleRate;
+        for (int k = 0; k < taps; ++k) bandFilter[k] = std::polar(lowPass[k] / sum, -omega * (k - middle));
+    }
+
+    windowSizes = {std::max(2, qRound(WIDEBAND_MS * sampleRate / 1000.0)), std::max(2, qRound(NARROWBAND_MS * sampleRate / 1000.0))};
+    windows.resize(ResolutionCount);
+    for (int resolution = 0; resolution < ResolutionCount; ++resolution) {
+        int frameSize = decimation > 1 ? std::max(2, qRound((double) windowSizes[resolution] / decimation)) : windowSizes[resolution];
+        frameSizes.append(frameSize);
+        fftSizes.append(decimation > 1 ? frameSize * ZOOM_PADDING : frameSize);
+        Stft::hammingWindow(frameSize, windows[resolution]);
+
+        int size = fftSizes[resolution];
+        realInput[resolution] = nullptr;
+        complexInput[resolution] = nullptr;
+        QMutexLocker locker(&Stft::plannerLock());
+        if (decimation > 1) {
+            // the padding after each frame stays zero, only the frames are written
+            complexInput[resolution] = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * size * FRAMES_PER_BATCH);
+            output[resolution] = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * size * FRAMES_PER_BATCH);
+            std::fill(&complexInput[resolution][0][0], &complexInput[resolution][0][0] + 2 * size * FRAMES_PER_BATCH, 0.0);
+            plan[resolution] = fftw_plan_many_dft(1, &size, FRAMES_PER_BATCH,
+                                                  complexInput[resolution], nullptr, 1, size,
+                                                  output[resolution], nullptr, 1, size, FFTW_FORWARD, FFTW_ESTIMATE);
+        } else {
+            int bins = size / 2 + 1;
+            realInput[resolution] = (double*) fftw_malloc(sizeof(double) * size * FRAMES_PER_BATCH);
+            output[resolution] = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * bins * FRAMES_PER_BATCH);
+            std::fill(realInput[resolution], realInput[resolution] + size * FRAMES_PER_BATCH, 0.0); // the tail of a short last batch
+            plan[resolution] = fftw_plan_many_dft_r2c(1, &size, FRAMES_PER_BATCH,
+                                                      realInput[resolution], nullptr, 1, size,
+                                                      output[resolution], nullptr, 1, bins, FFTW_ESTIMATE);
+        }
+    }
+}
+
+MultiResolutionStft::~MultiResolutionStft() {
+    for (int resolution = 0; resolution < ResolutionCount; ++resolution) {
+        {
+            QMutexLocker locker(&Stft::plannerLock());
+            fftw_destroy_plan(plan[resolution]);
+        }
+        if (realInput[resolution]) fftw_free(realInput[resolution]);
+        if (complexInput[resolution]) fftw_free(complexInput[resolution]);
+        fftw_free(output[resolution]);
+    }
+}
+
+QString MultiResolutionStft::name(Resolution resolution) {
+    if (resolution == Wideband) return QString("wideband (%1 ms)").arg(WIDEBAND_MS);
+    return QString("narrowband (%1 ms)").arg(NARROWBAND_MS);
+}
+
+QVector<SpectralFrames> MultiResolutionStft::compute(const QVector<double> &samples) {
+    TRACE_SCOPE("MultiResolutionStft::compute");
+    return decimation > 1 ? computeBand(samples) : computeWholeBand(samples);
+}
+
+int MultiResolutionStft::hopFor(qsizetype signalLength, int longest) const {
+    // a hop of half the short window at most, fewer frames for long files
+    return (int) std::max<qsizetype>(frameSizes[Wideband] / 2, (signalLength - longest) / MAX_DISPLAY_FRAMES + 1);
+}
+
+QVector<SpectralFrames> MultiResolutionStft::computeWholeBand(const QVector<double> &samples) {
+    int longest = *std::max_element(frameSizes.cbegin(), frameSizes.cend());
+    qsizetype signalLength = samples.size();
+
+    QVector<SpectralFrames> frames(ResolutionCount);
+    for (int resolution = 0; resolution < ResolutionCount; ++resolution) {
+        frames[resolution].windowSize = windowSizes[resolution];
+        frames[resolution].sampleRate = sampleRate;
+        frames[resolution].numSamples = signalLength;
+    }
+    if (signalLength < longest) return frames;
+
+    int hop = hopFor(signalLength, longest);
+    int frameCount = int((signalLength - longest) / hop + 1);
+    for (int resolution = 0; resolution < ResolutionCount; ++resolution) {
+        frames[resolution].hopSize = hop;
+        frames[resolution].magnitudes.resize(frameCount, QVector<double>(windowSizes[resolution] / 2));
+    }
+
+    const double *signal = samples.constData();
+    for (int first = 0; first < frameCount; first += FRAMES_PER_BATCH) {
+        int count = std::min(FRAMES_PER_BATCH, frameCount - first);
+
+        // framing: one pass over the centres of the batch fills the windowed input of every resolution
+        for (int frame = 0; frame < count; ++frame) {
+            const double *centre = signal + qsizetype(first + frame) * hop + longest / 2;
+            for (int resolution = 0; resolution < ResolutionCount; ++resolution) {
+                int size = frameSizes[resolution];
+                const double *start = centre - size / 2;
+                const double *window = windows[resolution].constData();
+                double *batchFrame = realInput[resolution] + frame * size;
+                for (int i = 0; i < size; ++i) batchFrame[i] = start[i] * window[i];
+            }
+        }
+
+        for (int resolution = 0; resolution < ResolutionCount; ++resolution) {
+            fftw_execute(plan[resolution]);
+
+            int size = frameSizes[resolution];
+            int bins = size / 2 + 1;
+            for (int frame = 0; frame < count; ++frame) {
+                const fftw_complex *spectrum = output[resolution] + frame * bins;
+                double *amplitudes = frames[resolution].magnitudes[first + frame].data();
+                for (int i = 0; i < size / 2; ++i) {
+                    amplitudes[i] = 2 * std::sqrt(spectrum[i][0] * spectrum[i][0] + spectrum[i][1] * spectrum[i][1]);
+                }
+            }
+        }
+    }
+    return frames;
+}
+
+QVector<std::complex<double>> MultiResolutionStft::shiftAndDecimate(const QVector<double> &samples) const {
+    TRACE_SCOPE("MultiResolutionStft::shiftAndDecimate");
+    qsizetype signalLength = samples.size();
+    int taps = bandFilter.size();
+    int middle = taps / 2;
+    QVector<std::complex<double>> decimated((signalLength + decimation - 1) / decimation);
+
+    const double *signal = samples.constData();
+    const std::complex<double> *filter = bandFilter.constData();
+    for (qsizetype m = 0; m < decimated.size(); ++m) {
+        qsizetype position = m * decimation;
+        int firstTap = (int) std::max<qsizetype>(0, middle - position);
+        int lastTap = (int) std::min<qsizetype>(taps, signalLength - position + middle);
+        std::complex<double> sum = 0.0;
+        const double *input = signal + position - middle;
+        for (int k = firstTap; k < lastTap; ++k) sum += filter[k] * input[k];
+
+        // the rest of the shift, the phase of the centre frequency at this sample (in cycles, so it stays exact)
+        double cycles = centreHz * position / sampleRate;
+        decimated[m] = sum * std::polar(1.0, -2.0 * M_PI * (cycles - std::floor(cycles)));
+    }
+    return decimated;
+}
+
+QVector<SpectralFrames> MultiResolutionStft::computeBand(const QVector<double> &samples) {
+    QVector<std::complex<double>> decimated = shiftAndDecimate(samples);
+    int longest = *std::max_element(frameSizes.cbegin(), frameSizes.cend());
+    qsizetype signalLength = decimated.size();
+    double decimatedRate = (double) sampleRate / decimation;
+
+    int hop = signalLength < longest ? 1 : hopFor(signalLength, longest);
+    int frameCount = signalLength < longest ? 0 : int((signalLength - longest) / hop + 1);
+
+    // FFT bins are offsets from the centre of the range, negative ones wrap around to the end of the output
+    QVector<int> firstOffsets(ResolutionCount);
+    QVector<SpectralFrames> frames(ResolutionCount);
+    for (int resolution = 0; resolution < ResolutionCount; ++resolution) {
+        double step = decimatedRate / fftSizes[resolution];
+        firstOffsets[resolution] = (int) std::ceil((lowHz - centreHz) / step);
+        int bins = (int) std::floor((highHz - centreHz) / step) - firstOffsets[resolution] + 1;
+        frames[resolution].windowSize = windowSizes[resolution];
+        frames[resolution].hopSize = hop * decimation;
+        frames[resolution].sampleRate = sampleRate;
+        frames[resolution].numSamples = samples.size();
+        frames[resolution].bandStart = centreHz + firstOffsets[resolution] * step;
+        frames[resolution].bandStep = step;
+        frames[resolution].magnitudes.resize(frameCount, QVector<double>(bins));
+    }
+
+    const std::complex<double> *signal = decimated.constData();
+    for (int first = 0; first < frameCount; first += FRAMES_PER_BATCH) {
+        int count = std::min(FRAMES_PER_BATCH, frameCount - first);
+
+        for (int frame = 0; frame < count; ++frame) {
+            const std::complex<double> *centre = signal + qsizetype(first + frame) * hop + longest / 2;
+            for (int resolution = 0; resolution < ResolutionCount; ++resolution) {
+                int size = frameSizes[resolution];
+                const std::complex<double> *start = centre - size / 2;
+                const double *window = windows[resolution].constData();
+                fftw_complex *batchFrame = complexInput[resolution] + frame * fftSizes[resolution];
+                for (int i = 0; i < size; ++i) {
+                    batchFrame[i][0] = start[i].real() * window[i];
+                    batchFrame[i][1] = start[i].imag() * window[i];
+                }
+            }
+        }
+
+        for (int resolution = 0; resolution < ResolutionCount; ++resolution) {
+            fftw_execute(plan[resolution]);
+
+            int size = fftSizes[resolution];
+            double scale = 2.0 * windowSizes[resolution] / frameSizes[resolution];
+            int bins = frames[resolution].magnitudes[first].size();
+            for (int frame = 0; frame < count; ++frame) {
+                const fftw_complex *spectrum = output[resolution] + frame * size;
+                double *amplitudes = frames[resolution].magnitudes[first + frame].data();
+                for (int bin = 0; bin < bins; ++bin) {
+                    int k = ((firstOffsets[resolution] + bin) % size + size) % size;
+                    amplitudes[bin] = scale * std::sqrt(spectrum[k][0] * spectrum[k][0] + spectrum[k][1] * spectrum[k][1]);
+                }
+            }
+        }
+    }
+    return frames;
+}
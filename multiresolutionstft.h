@@ -0,0 +1,96 @@
+#ifndef MULTIRESOLUTIONSTFT_H
+#define MULTIRESOLUTIONSTFT_H
+
+#include <QVector>
+#include <QString>
+#include <fftw3.h>
+#include <complex>
+#include "spectralframes.h"
+
+/*
+ * File: multiresolutionstft.h
+ * Description:
+ *  This header file defines the 'MultiResolutionStft' class, which computes the wideband (short window, sharp in time,
+ *  shows formants) and the narrowband (long window, sharp in frequency, shows harmonics) spectrograms of the
+ *  'Spectrograph' in one pass over the samples. Both share one grid of frame centres, so column k of either
+ *  spectrogram is the same instant and the display can flip between them without recomputing anything.
+ *
+ *  Only the frequency range that is displayed is computed. A range narrower than about half the sample rate is a zoom
+ *  FFT: the samples are shifted so the centre of the range is at 0 Hz, low pass filtered and decimated once, and the
+ *  frames are cut from that much shorter complex signal. The windows keep their length in time, so each FFT is about
+ *  'decimation' times smaller, and it is zero padded so the range gets finer bins than the full band FFT gave it.
+ *
+ * Key Members:
+ *  - 'Resolution' ('Wideband', 'Narrowband'): Index of a resolution in the frames returned by compute()
+ *  - 'double lowHz, highHz': The frequency range, 'int decimation': 1 if the range is (nearly) the whole band, which is
+ *    transformed as it is
+ *  - 'QVector<int> windowSizes': Samples per frame of each resolution at the sample rate, WIDEBAND_MS and NARROWBAND_MS
+ *  - 'QVector<int> frameSizes', 'QVector<int> fftSizes': Samples per frame after decimation and points of its FFT
+ *  - 'QVector<std::complex<double>> bandFilter': Low pass filter shifted to the range, applied while decimating
+ *  - 'double *realInput', 'fftw_complex *complexInput, *output', 'fftw_plan plan' (one each per resolution): Batched
+ *    plans that transform FRAMES_PER_BATCH frames per execution, real to complex for the whole band, complex otherwise
+ *
+ * Public Methods:
+ *  - 'MultiResolutionStft(int sampleRate, double lowHz = 0.0, double highHz = 0.0)': Creates the windows, the filter and
+ *    the plans of both resolutions. A highHz of 0 is the whole band
+ *  - 'QVector<SpectralFrames> compute(const QVector<double> &samples)': Frames of every resolution, indexed by
+ *    'Resolution'. Band limited frames only hold the bins of the range ('SpectralFrames::bandStart', 'bandStep')
+ *  - 'int getWindowSize(Resolution resolution) const', 'int getSampleRate() const', 'int getDecimation() const'
+ *  - 'static QString name(Resolution resolution)': For the resolution selector
+ *
+ * Notes:
+ *  - The hop is chosen per file so no file has more than MAX_DISPLAY_FRAMES frames: these frames are only drawn, and
+ *    the view has far fewer columns than that. The 'Stft' frames the analyses use are not affected.
+ *  - Plans are made under 'Stft::plannerLock()', so an object can be built on a worker thread. Like 'Stft' it is used
+ *    by one thread at a time.
+ *
+ * References:
+ *  - https://www.fftw.org/fftw3_doc/Advanced-Complex-DFTs.html
+ *  - https://www.fftw.org/fftw3_doc/Advanced-Real_002ddata-DFTs.html
+ *  - https://en.wikipedia.org/wiki/Spectrogram#Limitations_and_resynthesis
+ *  - Zoom FFT (shift, filter, decimate, transform): https://en.wikipedia.org/wiki/Zoom_FFT
+ */
+
+class MultiResolutionStft
+{
+public:
+    enum Resolution {
+        Wideband = 0,
+        Narrowband = 1,
+        ResolutionCount = 2
+    };
+
+    explicit MultiResolutionStft(int sampleRate, double lowHz = 0.0, double highHz = 0.0);
+    ~MultiResolutionStft();
+    MultiResolutionStft(const MultiResolutionStft &) = delete;
+    MultiResolutionStft &operator=(const MultiResolutionStft &) = delete;
+
+    QVector<SpectralFrames> compute(const QVector<double> &samples);
+    int getWindowSize(Resolution resolution) const { return windowSizes[resolution]; }
+    int getSampleRate() const { return sampleRate; }
+    int getDecimation() const { return decimation; }
+    static QString name(Resolution resolution);
+
+private:
+    int sampleRate;
+    double lowHz;
+    double highHz;
+    double centreHz = 0.0;
+    int decimation = 1;
+    QVector<int> windowSizes;
+    QVector<int> frameSizes;
+    QVector<int> fftSizes;
+    QVector<QVector<double>> windows;
+    QVector<std::complex<double>> bandFilter;
+    double *realInput[ResolutionCount];
+    fftw_complex *complexInput[ResolutionCount];
+    fftw_complex *output[ResolutionCount];
+    fftw_plan plan[ResolutionCount];
+
+    QVector<std::complex<double>> shiftAndDecimate(const QVector<double> &samples) const;
+    int hopFor(qsizetype signalLength, int longest) const;
+    QVector<SpectralFrames> computeWholeBand(const QVector<double> &samples);
+    QVector<SpectralFrames> computeBand(const QVector<double> &samples);
+};
+
+#endif // MULTIRESOLUTIONSTFT_H
@@ -0,0 +1,138 @@
+#include "offsetestimator.h"
+#include "stft.h"
+#include <algorithm>
+#include <cmath>
+
+/*
+ * File: offsetestimator.cpp
+ * Description:
+ *  This source file implements the 'OffsetEstimator'. Both tracks are reduced to a log energy envelope with one value
+ *  every ENVELOPE_HOP_SECONDS, so tracks of different sample rates are compared on the same time base and the FFT
+ *  stays small (a minute is 6000 values). The correlation r(k) = sum user[t + k] * speaker[t] is the inverse FFT of
+ *  conj(S) * U, negative lags end up at the back of the output.
+ *
+ * Notes:
+ *  - Log energy rather than amplitude so quiet onsets count as much as the loud vowels, the floor at
+ *    ENVELOPE_RANGE_DB below the loudest frame keeps silence (and its noise) flat.
+ *  - The plans are made and destroyed under 'Stft::plannerLock()'. An estimator replaced while an estimate still runs
+ *    is destroyed by that task on the worker, at the same time as the pipelines may be planning their STFTs.
+ *
+ * References:
+ *  - https://en.wikipedia.org/wiki/Cross-correlation#Efficient_computation
+ */
+
+#define ENVELOPE_HOP_SECONDS 0.01
+#define ENVELOPE_RANGE_DB 50.0
+#define MAX_OFFSET_SECONDS 10.0
+
+OffsetEstimator::OffsetEstimator(int _fftSize)
+    : fftSize(std::max(_fftSize, 2))
+{
+    double *buffer = (double*) fftw_malloc(sizeof(double) * fftSize);
+    fftw_complex *spectrum = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (fftSize / 2 + 1));
+    {
+        QMutexLocker locker(&Stft::plannerLock());
+        forwardPlan = fftw_plan_dft_r2c_1d(fftSize, buffer, spectrum, FFTW_ESTIMATE);
+        inversePlan = fftw_plan_dft_c2r_1d(fftSize, spectrum, buffer, FFTW_ESTIMATE);
+    }
+    fftw_free(buffer);
+    fftw_free(spectrum);
+}
+
+OffsetEstimator::~OffsetEstimator() {
+    QMutexLocker locker(&Stft::plannerLock());
+    fftw_destroy_plan(forwardPlan);
+    fftw_destroy_plan(inversePlan);
+}
+
+static int envelopeHop(int sampleRate) {
+    return std::max(1, (int) std::lround(sampleRate * ENVELOPE_HOP_SECONDS));
+}
+
+int OffsetEstimator::fftSizeFor(qint64 speakerSamples, int speakerRate, qint64 userSamples, int userRate) {
+    qint64 length = speakerSamples / envelopeHop(speakerRate) + userSamples / envelopeHop(userRate);
+    int size = 2;
+    while (size < length) size *= 2;
+    return size;
+}
+
+QVector<double> OffsetEstimator::energyEnvelope(const QVector<double> &samples, int sampleRate) {
+    int hop = envelopeHop(sampleRate);
+    QVector<double> envelope(samples.size() / hop);
+    const double *input = samples.constData();
+    for (int frame = 0; frame < envelope.size(); ++frame) {
+        double energy = 0.0;
+        for (int i = 0; i < hop; ++i) energy += input[frame * hop + i] * input[frame * hop + i];
+        envelope[frame] = 10.0 * std::log10(energy / hop + 1e-12);
+    }
+    if (envelope.isEmpty()) return envelope;
+
+    double floor = *std::max_element(envelope.begin(), envelope.end()) - ENVELOPE_RANGE_DB;
+    double mean = 0.0;
+    for (double &value : envelope) {
+        value = std::max(value, floor);
+        mean += value;
+    }
+    mean /= envelope.size();
+    for (double &value : envelope) value -= mean;
+    return envelope;
+}
+
+TrackOffset OffsetEstimator::estimate(const QVector<double> &speakerSamples, int speakerRate,
+                                      const QVector<double> &userSamples, int userRate) const {
+    TrackOffset offset;
+    if (speakerRate <= 0 || userRate <= 0) return offset;
+    offset.speakerSeconds = (double) speakerSamples.size() / speakerRate;
+    offset.userSeconds = (double) userSamples.size() / userRate;
+
+    QVector<double> speaker = energyEnvelope(speakerSamples, speakerRate);
+    QVector<double> user = energyEnvelope(userSamples, userRate);
+    if (speaker.isEmpty() || user.isEmpty() || speaker.size() + user.size() > fftSize) return offset;
+
+    double *buffer = (double*) fftw_malloc(sizeof(double) * fftSize);
+    fftw_complex *speakerSpectrum = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (fftSize / 2 + 1));
+    fftw_complex *userSpectrum = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (fftSize / 2 + 1));
+
+    std::fill(buffer, buffer + fftSize, 0.0);
+    std::copy(speaker.begin(), speaker.end(), buffer);
+    fftw_execute_dft_r2c(forwardPlan, buffer, speakerSpectrum);
+    std::fill(buffer, buffer + fftSize, 0.0);
+    std::copy(user.begin(), user.end(), buffer);
+    fftw_execute_dft_r2c(forwardPlan, buffer, userSpectrum);
+
+    for (int k = 0; k <= fftSize / 2; ++k) {
+        double sr = speakerSpectrum[k][0];
+        double si = speakerSpectrum[k][1];
+        double ur = userSpectrum[k][0];
+        double ui = userSpectrum[k][1];
+        userSpectrum[k][0] = sr * ur + si * ui;
+        userSpectrum[k][1] = sr * ui - si * ur;
+    }
+    fftw_execute_dft_c2r(inversePlan, userSpectrum, buffer);
+
+    auto correlation = [&](int lag) { return buffer[lag >= 0 ? lag : fftSize + lag]; };
+    int maxLag = (int) (MAX_OFFSET_SECONDS / ENVELOPE_HOP_SECONDS);
+    int lowestLag = -std::min(maxLag, (int) speaker.size() - 1);
+    int highestLag = std::min(maxLag, (int) user.size() - 1);
+    int bestLag = 0;
+    for (int lag = lowestLag; lag <= highestLag; ++lag) {
+        if (correlation(lag) > correlation(bestLag)) bestLag = lag;
+    }
+
+    double shift = 0.0;
+    if (bestLag > lowestLag && bestLag < highestLag) {
+        double before = correlation(bestLag - 1);
+        double peak = correlation(bestLag);
+        double after = correlation(bestLag + 1);
+        double denominator = before - 2.0 * peak + after;
+        if (std::abs(denominator) > 1e-12) shift = 0.5 * (before - after) / denominator;
+    }
+
+    fftw_free(buffer);
+    fftw_free(speakerSpectrum);
+    fftw_free(userSpectrum);
+
+    offset.offsetSeconds = (bestLag + shift) * ENVELOPE_HOP_SECONDS;
+    offset.valid = true;
+    return offset;
+}
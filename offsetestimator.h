@@ -0,0 +1,68 @@
+#ifndef OFFSETESTIMATOR_H
+#define OFFSETESTIMATOR_H
+
+#include <QVector>
+#include <fftw3.h>
+
+/*
+ * File: offsetestimator.h
+ * Description:
+ *  This header file defines the 'OffsetEstimator' class, which finds the time offset between the speaker and the user
+ *  recording from the cross-correlation of their energy envelopes, and the 'TrackOffset' struct holding the result.
+ *
+ * Purpose:
+ *  - The recordings usually start with different amounts of silence, the offset lets the aligned playback and scrubbers
+ *    start both tracks at the same point of the utterance without trimming the files first
+ *
+ * Key Members:
+ *  - 'int fftSize': Power of two at least as long as both envelopes together, so the correlation does not wrap around
+ *  - 'fftw_plan forwardPlan, inversePlan': Created once, executed on the worker with its own buffers
+ *
+ * Public Methods:
+ *  - 'OffsetEstimator(int fftSize)': Creates the plans, FFTW's planner is not thread safe so they are made (and
+ *    destroyed, possibly on a worker) under 'Stft::plannerLock()'
+ *  - 'static int fftSizeFor(qint64 speakerSamples, int speakerRate, qint64 userSamples, int userRate)': FFT size
+ *    needed for two tracks
+ *  - 'static QVector<double> energyEnvelope(const QVector<double> &samples, int sampleRate)': Log energy every
+ *    ENVELOPE_HOP_SECONDS, with the mean removed
+ *  - 'TrackOffset estimate(...) const': Cross-correlation through the FFT (O(n log n)), best lag within
+ *    MAX_OFFSET_SECONDS refined with a parabola
+ *
+ * TrackOffset:
+ *  - 'double offsetSeconds': User time = speaker time + offsetSeconds, positive if the user track has more leading silence
+ *  - 'double mapProportion(double proportion) const': Position in the user track (0 to 1) for a speaker position
+ */
+
+struct TrackOffset
+{
+    bool valid = false;
+    double offsetSeconds = 0.0;
+    double speakerSeconds = 0.0;
+    double userSeconds = 0.0;
+
+    double mapProportion(double proportion) const {
+        if (!valid || userSeconds <= 0.0) return proportion;
+        return (proportion * speakerSeconds + offsetSeconds) / userSeconds;
+    }
+};
+
+class OffsetEstimator
+{
+    int fftSize;
+    fftw_plan forwardPlan;
+    fftw_plan inversePlan;
+
+public:
+    explicit OffsetEstimator(int fftSize);
+    ~OffsetEstimator();
+    OffsetEstimator(const OffsetEstimator &) = delete;
+    OffsetEstimator &operator=(const OffsetEstimator &) = delete;
+
+    int getFftSize() const { return fftSize; }
+    static int fftSizeFor(qint64 speakerSamples, int speakerRate, qint64 userSamples, int userRate);
+    static QVector<double> energyEnvelope(const QVector<double> &samples, int sampleRate);
+    TrackOffset estimate(const QVector<double> &speakerSamples, int speakerRate,
+                         const QVector<double> &userSamples, int userRate) const;
+};
+
+#endif // OFFSETESTIMATOR_H
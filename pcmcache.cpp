@@ -0,0 +1,204 @@
+#include "pcmcache.h"
+#include <QtConcurrent>
+#include <QAudioDecoder>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+#include "tracer.h"
+
+/*
+ * File: pcmcache.cpp
+ * Description:
+ *  This source file implements the 'PcmCache'. 'prepare()' hashes the source with SHA-1, looks for
+ *  CacheLocation/pcm/<hash>.f32 and, if it is missing, runs 'decode()' on the decode pool: a QAudioDecoder in a local
+ *  event loop whose buffers are normalised with QAudioFormat::normalizedSampleValue and appended to the cache file as
+ *  they arrive, so the decoded audio is never held in memory as a whole.
+ */
+
+#define PCM_CACHE_VERSION 1
+#define PCM_HEADER_BYTES 32
+#define DECODE_THREADS 2
+
+struct HashEntry
+{
+    qint64 size;
+    QDateTime modified;
+    QString hash;
+};
+
+static QMutex cacheMutex; // guards the two tables below
+static QHash<QString, HashEntry> hashes;
+static QHash<QString, QFuture<QString>> runningDecodes;
+
+static QThreadPool *decodePool() {
+    static QThreadPool *pool = [] {
+        QThreadPool *threads = new QThreadPool;
+        threads->setMaxThreadCount(DECODE_THREADS);
+        return threads;
+    }();
+    return pool;
+}
+
+bool PcmCache::isCompressed(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QByteArray header = file.read(12);
+    return !(header.size() == 12 && header.startsWith("RIFF") && header.mid(8, 4) == "WAVE");
+}
+
+QString PcmCache::contentHash(const QString &path) {
+    QFileInfo info(path);
+    if (!info.exists()) return QString();
+    QString key = info.absoluteFilePath();
+    {
+        QMutexLocker locker(&cacheMutex);
+        auto known = hashes.constFind(key);
+        if (known != hashes.constEnd() && known->size == info.size() && known->modified == info.lastModified()) {
+            return known->hash;
+        }
+    }
+
+    TRACE_SCOPE("PcmCache::contentHash");
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) return QString();
+    QString hex = QString::fromLatin1(hash.result().toHex());
+    QMutexLocker locker(&cacheMutex);
+    hashes.insert(key, HashEntry{info.size(), info.lastModified(), hex});
+    return hex;
+}
+
+QString PcmCache::cacheFileFor(const QString &source) {
+    QString hash = contentHash(source);
+    if (hash.isEmpty()) return QString();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/pcm/" + hash + ".f32";
+}
+
+QString PcmCache::cachedFileFor(const QString &source) {
+    QString cacheFile = cacheFileFor(source);
+    PcmCacheFile cached;
+    return !cacheFile.isEmpty() && cached.open(cacheFile) ? cacheFile : QString();
+}
+
+QFuture<QString> PcmCache::prepare(const QString &source, int priority) {
+    QString key = QFileInfo(source).absoluteFilePath();
+    QMutexLocker locker(&cacheMutex);
+    auto running = runningDecodes.constFind(key);
+    if (running != runningDecodes.constEnd() && !running->isFinished()) return *running;
+
+    QFuture<QString> future = QtConcurrent::task([source]() {
+        QString cacheFile = cacheFileFor(source);
+        if (cacheFile.isEmpty()) return QString();
+        PcmCacheFile cached;
+        if (cached.open(cacheFile)) return cacheFile;
+        return decode(source, cacheFile);
+    }).onThreadPool(*decodePool()).withPriority(priority).spawn();
+    runningDecodes.insert(key, future);
+    return future;
+}
+
+QString PcmCache::decode(const QString &source, const QString &cacheFile) {
+    TRACE_SCOPE("PcmCache::decode");
+    QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+    QSaveFile output(cacheFile);
+    if (!output.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cache Error: could not write" << cacheFile;
+        return QString();
+    }
+    output.write(QByteArray(PCM_HEADER_BYTES, '\0')); // filled in once the frame count is known
+
+    QAudioDecoder decoder;
+    QEventLoop loop;
+    int rate = 0;
+    int channels = 0;
+    qint64 frames = 0;
+    bool failed = false;
+    QByteArray block;
+
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, &loop, [&]() {
+        QAudioBuffer buffer = decoder.read();
+        QAudioFormat format = buffer.format();
+        if (rate == 0) {
+            rate = format.sampleRate();
+            channels = std::max(format.channelCount(), 1);
+        } else if (format.sampleRate() != rate || format.channelCount() != channels) {
+            failed = true; // the format changed in the middle of the stream
+            loop.quit();
+            return;
+        }
+
+        qsizetype count = buffer.frameCount() * channels;
+        int bytesPerSample = format.bytesPerSample();
+        const char *data = buffer.constData<char>();
+        block.resize(count * sizeof(float));
+        uchar *out = reinterpret_cast<uchar*>(block.data());
+        for (qsizetype i = 0; i < count; ++i, out += sizeof(float)) {
+            qToLittleEndian<float>(format.normalizedSampleValue(data + i * bytesPerSample), out);
+        }
+        if (output.write(block) != block.size()) {
+            failed = true;
+            loop.quit();
+        }
+        frames += buffer.frameCount();
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, &loop, &QEventLoop::quit);
+    QObject::connect(&decoder, qOverload<QAudioDecoder::Error>(&QAudioDecoder::error), &loop, [&]() {
+        qWarning() << "Cache Error: could not decode" << source << decoder.errorString();
+        failed = true;
+        loop.quit();
+    });
+
+    decoder.setSource(QUrl::fromLocalFile(source));
+    decoder.start();
+    if (!failed) loop.exec();
+    decoder.stop();
+
+    if (failed || frames == 0) {
+        output.cancelWriting();
+        return QString();
+    }
+
+    uchar header[PCM_HEADER_BYTES] = {};
+    memcpy(header, "PCMF", 4);
+    qToLittleEndian<quint32>(PCM_CACHE_VERSION, header + 4);
+    qToLittleEndian<quint32>(rate, header + 8);
+    qToLittleEndian<quint32>(channels, header + 12);
+    qToLittleEndian<quint64>(frames, header + 16);
+    if (!output.seek(0) || output.write(reinterpret_cast<const char*>(header), PCM_HEADER_BYTES) != PCM_HEADER_BYTES
+        || !output.commit()) {
+        qWarning() << "Cache Error: could not write" << cacheFile;
+        return QString();
+    }
+    return cacheFile;
+}
+
+bool PcmCacheFile::open(const QString &cacheFile) {
+    file.setFileName(cacheFile);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < PCM_HEADER_BYTES) return false;
+    map = file.map(0, file.size());
+    if (!map || memcmp(map, "PCMF", 4) != 0 || qFromLittleEndian<quint32>(map + 4) != PCM_CACHE_VERSION) {
+        map = nullptr;
+        return false;
+    }
+    rate = (int) qFromLittleEndian<quint32>(map + 8);
+    channelCount = (int) qFromLittleEndian<quint32>(map + 12);
+    frameCount = (qint64) qFromLittleEndian<quint64>(map + 16);
+    // a corrupt count may be negative or overflow the product, so the frames are compared with what the file holds
+    if (rate <= 0 || channelCount <= 0 || frameCount < 0
+        || frameCount > (file.size() - PCM_HEADER_BYTES) / ((qint64) channelCount * (qint64) sizeof(float))) {
+        map = nullptr;
+        return false;
+    }
+    return true;
+}
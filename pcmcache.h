@@ -0,0 +1,73 @@
+#ifndef PCMCACHE_H
+#define PCMCACHE_H
+
+#include <QString>
+#include <QFile>
+#include <QFuture>
+
+/*
+ * File: pcmcache.h
+ * Description:
+ *  This header file defines the 'PcmCache' class, a disk cache of decoded audio for compressed files (MP3, M4A, FLAC,
+ *  ...). A compressed file is decoded once on a worker thread into a float32 file named after the hash of its content,
+ *  every later open maps that file instead of decoding again. 'WavFile' and 'Spectrograph' read it like a WAV file.
+ *
+ * Public Methods:
+ *  - 'static bool isCompressed(const QString &path)': True for anything that is not a RIFF/WAVE file
+ *  - 'static QString contentHash(const QString &path)': Hex SHA-1 of the file's content, also the key of the
+ *    'AnalysisCache'
+ *  - 'static QString cachedFileFor(const QString &source)': Cache file of a source that was decoded before, or empty
+ *  - 'static QFuture<QString> prepare(const QString &source, int priority = 0)': Decodes the source into the cache unless
+ *    it is there already and returns the cache file, empty if decoding failed. Requests for a source that is being
+ *    decoded share the running decode. Queued decodes start in order of their 'WorkerPool' priority
+ *
+ * PcmCacheFile Public Methods:
+ *  - 'bool open(const QString &cacheFile)': Maps the file and validates its header
+ *  - 'const float *samples() const': Interleaved samples, frames() * channels() of them
+ *  - 'int sampleRate() const', 'int channels() const', 'qint64 frames() const'
+ *
+ * Notes:
+ *  - Layout: "PCMF", version, sample rate, channels (quint32 each), frame count (quint64), 8 reserved bytes, then the
+ *    interleaved float32 samples, everything little-endian. The 32 byte header keeps the samples aligned in the map.
+ *  - A cache file is written with QSaveFile, so a crash or a failed decode never leaves a partial file under the final
+ *    name.
+ *  - The content hash of a path is remembered for as long as its size and modification time stay the same, so a lookup
+ *    does not read the whole source again.
+ *  - Decoding runs on its own small thread pool: each decode waits in an event loop for the decoder's buffers and must
+ *    not take threads from the global pool the analyses use.
+ *
+ * References:
+ *  - https://doc.qt.io/qt-6/qaudiodecoder.html
+ *  - https://doc.qt.io/qt-6/qfiledevice.html#map
+ */
+
+class PcmCache
+{
+public:
+    static bool isCompressed(const QString &path);
+    static QString contentHash(const QString &path);
+    static QString cachedFileFor(const QString &source);
+    static QFuture<QString> prepare(const QString &source, int priority = 0);
+
+private:
+    static QString cacheFileFor(const QString &source);
+    static QString decode(const QString &source, const QString &cacheFile);
+};
+
+class PcmCacheFile
+{
+    QFile file;
+    const uchar *map = nullptr;
+    int rate = 0;
+    int channelCount = 0;
+    qint64 frameCount = 0;
+
+public:
+    bool open(const QString &cacheFile);
+    const float *samples() const { return reinterpret_cast<const float*>(map + 32); }
+    int sampleRate() const { return rate; }
+    int channels() const { return channelCount; }
+    qint64 frames() const { return frameCount; }
+};
+
+#endif // PCMCACHE_H
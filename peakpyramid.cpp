@@ -0,0 +1,59 @@
+#include "peakpyramid.h"
+#include <algorithm>
+
+/*
+ * File: peakpyramid.cpp
+ * Description:
+ *  This source file implements the 'PeakPyramid'. A new level 0 peak is pushed up as soon as its level has an even
+ *  number of peaks, the pair it completes becomes one peak of the next level.
+ */
+
+PeakPyramid::PeakPyramid(int _baseSamples, int levelCount)
+    : baseSamples(std::max(_baseSamples, 1)), levels(std::max(levelCount, 1))
+{
+}
+
+void PeakPyramid::clear() {
+    for (Level &level : levels) {
+        level.mins.clear();
+        level.maxs.clear();
+    }
+    pendingCount = 0;
+    samples = 0;
+}
+
+void PeakPyramid::append(const float *input, qsizetype count) {
+    samples += count;
+    for (qsizetype i = 0; i < count; ++i) {
+        float sample = input[i];
+        if (pendingCount == 0) {
+            pendingMin = sample;
+            pendingMax = sample;
+        } else {
+            pendingMin = std::min(pendingMin, sample);
+            pendingMax = std::max(pendingMax, sample);
+        }
+        if (++pendingCount == baseSamples) {
+            push(0, pendingMin, pendingMax);
+            pendingCount = 0;
+        }
+    }
+}
+
+void PeakPyramid::push(int level, float min, float max) {
+    for (; level < levels.size(); ++level) {
+        Level &current = levels[level];
+        current.mins.append(min);
+        current.maxs.append(max);
+        qsizetype size = current.mins.size();
+        if (size % 2) return;
+        min = std::min(current.mins[size - 2], current.mins[size - 1]);
+        max = std::max(current.maxs[size - 2], current.maxs[size - 1]);
+    }
+}
+
+int PeakPyramid::levelFor(double samplesPerPixel) const {
+    int level = 0;
+    while (level + 1 < levels.size() && samplesPerPeak(level + 1) <= samplesPerPixel) ++level;
+    return level;
+}
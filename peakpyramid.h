@@ -0,0 +1,55 @@
+#ifndef PEAKPYRAMID_H
+#define PEAKPYRAMID_H
+
+#include <QVector>
+
+/*
+ * File: peakpyramid.h
+ * Description:
+ *  This header file defines the 'PeakPyramid' class, min/max peaks of a growing signal at several resolutions. Level 0
+ *  has one peak per baseSamples samples, every level above combines two peaks of the level below, so any zoom can be
+ *  drawn from the level closest to it without touching the samples again.
+ *
+ * Public Methods:
+ *  - 'PeakPyramid(int baseSamples = 64, int levelCount = 12)': Empty pyramid
+ *  - 'void append(const float *samples, qsizetype count)': Extends all levels, a partial block waits for the next call
+ *  - 'void clear()': Forgets everything
+ *  - 'int levelFor(double samplesPerPixel) const': Coarsest level whose peaks are not wider than a pixel
+ *  - 'int samplesPerPeak(int level) const', 'const QVector<float> &mins(int level) const', 'maxs(level)': The peaks
+ *  - 'qint64 sampleCount() const': Samples appended so far
+ *
+ * Notes:
+ *  - Appending is amortised O(1) per sample, the levels above 0 only grow by one peak per 2^level blocks.
+ */
+
+class PeakPyramid
+{
+    struct Level
+    {
+        QVector<float> mins;
+        QVector<float> maxs;
+    };
+
+    int baseSamples;
+    QVector<Level> levels;
+    float pendingMin;
+    float pendingMax;
+    int pendingCount = 0;
+    qint64 samples = 0;
+
+    void push(int level, float min, float max);
+
+public:
+    explicit PeakPyramid(int baseSamples = 64, int levelCount = 12);
+
+    void append(const float *samples, qsizetype count);
+    void clear();
+    int levelCount() const { return levels.size(); }
+    int levelFor(double samplesPerPixel) const;
+    int samplesPerPeak(int level) const { return baseSamples << level; }
+    const QVector<float> &mins(int level) const { return levels[level].mins; }
+    const QVector<float> &maxs(int level) const { return levels[level].maxs; }
+    qint64 sampleCount() const { return samples; }
+};
+
+#endif // PEAKPYRAMID_H
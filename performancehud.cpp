@@ -0,0 +1,160 @@
+#include "performancehud.h"
+#include <QEvent>
+#include <QFile>
+#include <QThreadPool>
+#include "memorybudget.h"
+#include <algorithm>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+/*
+ * File: performancehud.cpp
+ * Description:
+ *  This source file implements the 'PerformanceHud'. Nothing is measured while it is hidden, the only permanent cost
+ *  is the paint timing in 'WavForm::paintEvent' and one signal per player position update in 'Audio'.
+ */
+
+#define REFRESH_MS 250
+#define LAG_PROBE_MS 16
+#define HUD_MARGIN 10
+
+static QString megabytes(qint64 bytes) {
+    return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MB";
+}
+
+static qint64 residentBytes() {
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) return -1;
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2) return -1;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+PerformanceHud::PerformanceHud(QWidget *parent)
+    : QLabel(parent)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setStyleSheet("background: rgba(0, 0, 0, 170); color: white; padding: 6px; font-family: monospace;");
+    setTextFormat(Qt::PlainText);
+    hide();
+
+    refreshTimer.setInterval(REFRESH_MS);
+    connect(&refreshTimer, &QTimer::timeout, this, &PerformanceHud::refresh);
+    lagTimer.setInterval(LAG_PROBE_MS);
+    lagTimer.setTimerType(Qt::PreciseTimer);
+    connect(&lagTimer, &QTimer::timeout, this, &PerformanceHud::measureLag);
+
+    if (parent) parent->installEventFilter(this);
+}
+
+void PerformanceHud::addTrack(const QString &name, Audio *audio, Spectrograph *spectrograph) {
+    Track track;
+    track.name = name;
+    track.audio = audio;
+    track.spectrograph = spectrograph;
+    tracks.append(track);
+
+    int index = tracks.size() - 1;
+    connect(audio, &Audio::scrubberLeadMeasured, this, [this, index](qint64 lead) {
+        if (!isVisible()) return;
+        Track &track = tracks[index];
+        track.leadMin = track.leadCount ? std::min(track.leadMin, lead) : lead;
+        track.leadMax = track.leadCount ? std::max(track.leadMax, lead) : lead;
+        track.leadSum += lead;
+        ++track.leadCount;
+        track.lastLead = lead;
+        track.hasLead = true;
+    });
+}
+
+void PerformanceHud::setActive(bool active) {
+    if (active) {
+        for (Track &track : tracks) track.lastPaintCount = track.audio->wavChart->getPaintCount();
+        maxLagMilliseconds = 0.0;
+        lagClock.start();
+        refreshClock.start();
+        lagTimer.start();
+        refreshTimer.start();
+        refresh();
+        show();
+        raise();
+    } else {
+        lagTimer.stop();
+        refreshTimer.stop();
+        hide();
+    }
+}
+
+void PerformanceHud::measureLag() {
+    double elapsed = lagClock.nsecsElapsed() / 1.0e6;
+    lagClock.restart();
+    maxLagMilliseconds = std::max(maxLagMilliseconds, elapsed - LAG_PROBE_MS);
+}
+
+void PerformanceHud::refresh() {
+    double seconds = std::max(refreshClock.nsecsElapsed() / 1.0e9, 1e-3);
+    refreshClock.restart();
+
+    QStringList lines;
+    lines << QString("event loop lag %1 ms   busy workers %2/%3")
+                 .arg(maxLagMilliseconds, 0, 'f', 1)
+                 .arg(QThreadPool::globalInstance()->activeThreadCount())
+                 .arg(QThreadPool::globalInstance()->maxThreadCount());
+    maxLagMilliseconds = 0.0;
+
+    for (Track &track : tracks) {
+        WavForm *wavForm = track.audio->wavChart;
+        int paints = wavForm->getPaintCount();
+        lines << QString("%1: items %2   paint %3 ms   %4 fps")
+                     .arg(track.name)
+                     .arg(wavForm->sceneItemCount())
+                     .arg(wavForm->getLastPaintMilliseconds(), 0, 'f', 2)
+                     .arg((paints - track.lastPaintCount) / seconds, 0, 'f', 0);
+        track.lastPaintCount = paints;
+
+        lines << QString("  samples %1   spectrogram %2   segments %3")
+                     .arg(megabytes(wavForm->sampleBytes()))
+                     .arg(megabytes(track.spectrograph->bufferBytes()))
+                     .arg(megabytes(track.audio->segmentBufferBytes()));
+
+        if (track.leadCount) {
+            lines << QString("  scrubber ahead of sound %1 ms (avg %2, %3..%4, n=%5)")
+                         .arg(track.lastLead)
+                         .arg(track.leadSum / track.leadCount, 0, 'f', 1)
+                         .arg(track.leadMin)
+                         .arg(track.leadMax)
+                         .arg(track.leadCount);
+        } else {
+            lines << QString("  scrubber ahead of sound %1").arg(track.hasLead ? QString("%1 ms (paused)").arg(track.lastLead) : QString("-"));
+        }
+        track.leadCount = 0;
+        track.leadSum = 0.0;
+    }
+
+    qint64 resident = residentBytes();
+    if (resident >= 0) lines << "process memory " + megabytes(resident);
+    lines << QString("memory budget %1 of %2   evicted %3")
+                 .arg(megabytes(MemoryBudget::usedBytes()))
+                 .arg(megabytes(MemoryBudget::getBudget()))
+                 .arg(megabytes(MemoryBudget::evictedBytes()));
+
+    setText(lines.join('\n'));
+    adjustSize();
+    reposition();
+}
+
+void PerformanceHud::reposition() {
+    QWidget *window = parentWidget();
+    if (!window) return;
+    move(window->width() - width() - HUD_MARGIN, window->height() - height() - HUD_MARGIN);
+}
+
+bool PerformanceHud::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == parentWidget() && event->type() == QEvent::Resize && isVisible()) reposition();
+    return QLabel::eventFilter(watched, event);
+}
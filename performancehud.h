@@ -0,0 +1,86 @@
+#ifndef PERFORMANCEHUD_H
+#define PERFORMANCEHUD_H
+
+#include <QLabel>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include "audio.h"
+#include "spectrograph.h"
+
+/*
+ * File: performancehud.h
+ * Description:
+ *  This header file defines the 'PerformanceHud' class, an optional overlay in the corner of the main window that shows
+ *  how the app is doing while it is used.
+ *
+ * Shows (refreshed 4 times a second):
+ *  - Event loop lag: how late a 16 ms timer fired at worst, the time input and paints waited in the queue, and how
+ *    many worker threads of the global pool are busy
+ *  - Per track: scene items of the 'WavForm', how long its last paint took and its paints per second
+ *  - Per track: bytes held by the samples ('WavForm'), the spectrogram and analyses ('Spectrograph') and the segments
+ *    of the segment graph
+ *  - Per track: how far the drawn scrubber is ahead of the player's clock (last, average and range since the last
+ *    refresh), measured by 'Audio' every time the player reports a new position
+ *  - The resident memory of the process (Linux)
+ *  - The bytes counted by the 'MemoryBudget', its budget and how much it evicted
+ *
+ * Public Methods:
+ *  - 'PerformanceHud(QWidget *parent)': Hidden until activated, keeps itself in the bottom right corner of the parent
+ *  - 'void addTrack(const QString &name, Audio *audio, Spectrograph *spectrograph)': Adds a track to watch
+ *
+ * Public Slots:
+ *  - 'void setActive(bool active)': Shows the overlay and starts measuring, or hides it and stops all timers
+ *
+ * Private Slots:
+ *  - 'void refresh()': Collects the numbers and redraws the text
+ *  - 'void measureLag()': Lateness of the 16 ms timer
+ *
+ * Notes:
+ *  - The player's position comes from the media backend, the latency of the audio device after it is not included, so
+ *    a lead of a few ms is expected. Leads that grow while playing mean the scrubber extrapolation drifts.
+ */
+
+class PerformanceHud : public QLabel
+{
+    Q_OBJECT
+
+    struct Track
+    {
+        QString name;
+        Audio *audio = nullptr;
+        Spectrograph *spectrograph = nullptr;
+        int lastPaintCount = 0;
+        qint64 lastLead = 0;
+        bool hasLead = false;
+        int leadCount = 0;
+        double leadSum = 0.0;
+        qint64 leadMin = 0;
+        qint64 leadMax = 0;
+    };
+
+    QList<Track> tracks;
+    QTimer refreshTimer;
+    QTimer lagTimer;
+    QElapsedTimer lagClock;
+    QElapsedTimer refreshClock;
+    double maxLagMilliseconds = 0.0;
+
+    void reposition();
+
+public:
+    explicit PerformanceHud(QWidget *parent);
+    void addTrack(const QString &name, Audio *audio, Spectrograph *spectrograph);
+
+public slots:
+    void setActive(bool active);
+
+private slots:
+    void refresh();
+    void measureLag();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+};
+
+#endif // PERFORMANCEHUD_H
@@ -0,0 +1,160 @@
+#include "pitchtracker.h"
+#include "stft.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+/*
+ * File: pitchtracker.cpp
+ * Description:
+ *  This source file implements the 'PitchTracker'. For every frame YIN compares the first integrationWindow samples with
+ *  the same samples shifted by each lag up to maxLag:
+ *      d(tau) = E(0) + E(tau) - 2 * r(tau)
+ *  where E(tau) is the energy of the window starting at tau (prefix sums of squares) and r(tau) is the cross-correlation
+ *  of the first window with the whole frame. r is computed as the inverse FFT of conj(A) * B, A being the spectrum of the
+ *  first window and B the spectrum of the frame, both zero padded to fftSize. The difference is normalized by its running
+ *  mean, the first lag under YIN_THRESHOLD (followed down to its local minimum) is the period, refined with a parabola.
+ *
+ * Key Methods:
+ *  - 'PitchTracker()': Computes the frame sizes from the F0 range and creates the FFTW plans
+ *  - 'track()': Splits the frames into blocks of FRAMES_PER_TASK, each block gets its own FFT buffers and runs on the
+ *    global thread pool with QtConcurrent::blockingMap
+ *  - 'frameF0()': YIN for a single frame
+ *
+ * Notes:
+ *  - Three FFTs of 2048 points per 10 ms frame at 44.1 kHz, a minute of audio is 6000 frames which the thread pool
+ *    finishes well within the time the spectrogram takes to show up.
+ *  - fftw_execute_dft_r2c/c2r (new-array execution) is thread safe, planning is not, see the FFTW manual on thread safety.
+ *    The plans are made and destroyed under 'Stft::plannerLock()', the pipeline of another track may be planning on a
+ *    worker at the same time.
+ *
+ * References:
+ *  - https://www.fftw.org/fftw3_doc/New_002darray-Execute-Functions.html
+ *  - https://www.fftw.org/fftw3_doc/Thread-safety.html
+ */
+
+#define PITCH_HOP_SECONDS 0.01
+#define YIN_THRESHOLD 0.15
+#define SILENCE_POWER 1e-7 // mean square of about -70 dBFS, quieter frames are never voiced
+#define FRAMES_PER_TASK 64
+
+PitchTracker::PitchTracker(int _sampleRate, double minF0, double maxF0)
+    : sampleRate(std::max(_sampleRate, 1))
+{
+    maxLag = (int) std::ceil(sampleRate / minF0);
+    minLag = std::max(2, (int) std::floor(sampleRate / maxF0));
+    integrationWindow = maxLag;
+    frameLength = integrationWindow + maxLag;
+    fftSize = 1;
+    while (fftSize < frameLength) fftSize *= 2;
+    hopSize = std::max(1, qRound(sampleRate * PITCH_HOP_SECONDS));
+
+    // the arrays only give the plans their size and alignment, every call executes on its own buffers
+    double *buffer = (double*) fftw_malloc(sizeof(double) * fftSize);
+    fftw_complex *spectrum = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (fftSize / 2 + 1));
+    {
+        QMutexLocker locker(&Stft::plannerLock());
+        forwardPlan = fftw_plan_dft_r2c_1d(fftSize, buffer, spectrum, FFTW_ESTIMATE);
+        inversePlan = fftw_plan_dft_c2r_1d(fftSize, spectrum, buffer, FFTW_ESTIMATE);
+    }
+    fftw_free(buffer);
+    fftw_free(spectrum);
+}
+
+PitchTracker::~PitchTracker() {
+    QMutexLocker locker(&Stft::plannerLock());
+    fftw_destroy_plan(forwardPlan);
+    fftw_destroy_plan(inversePlan);
+}
+
+int PitchTracker::getSampleRate() const {
+    return sampleRate;
+}
+
+PitchContour PitchTracker::track(const QVector<double> &samples) const {
+    PitchContour contour;
+    contour.hopSize = hopSize;
+    contour.frameLength = frameLength;
+    contour.sampleRate = sampleRate;
+    contour.numSamples = samples.size();
+
+    int numFrames = samples.size() >= frameLength ? (samples.size() - frameLength) / hopSize + 1 : 0;
+    contour.f0.resize(numFrames);
+    double *f0 = contour.f0.data();
+    const double *signal = samples.constData();
+
+    QVector<int> blocks;
+    for (int firstFrame = 0; firstFrame < numFrames; firstFrame += FRAMES_PER_TASK) blocks << firstFrame;
+
+    QtConcurrent::blockingMap(blocks, [&](int firstFrame) {
+        double *buffer = (double*) fftw_malloc(sizeof(double) * fftSize);
+        fftw_complex *spectrumA = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (fftSize / 2 + 1));
+        fftw_complex *spectrumB = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (fftSize / 2 + 1));
+        QVector<double> differences(maxLag + 1);
+        QVector<double> energies(frameLength + 1);
+
+        int lastFrame = std::min(firstFrame + FRAMES_PER_TASK, numFrames);
+        for (int frame = firstFrame; frame < lastFrame; ++frame) {
+            f0[frame] = frameF0(signal + (qint64) frame * hopSize, buffer, spectrumA, spectrumB,
+                                differences.data(), energies.data());
+        }
+
+        fftw_free(buffer);
+        fftw_free(spectrumA);
+        fftw_free(spectrumB);
+    });
+    return contour;
+}
+
+double PitchTracker::frameF0(const double *frame, double *buffer, fftw_complex *spectrumA, fftw_complex *spectrumB,
+                             double *differences, double *energies) const {
+    // energies[j] is the sum of squares of the first j samples
+    energies[0] = 0.0;
+    for (int j = 0; j < frameLength; ++j) energies[j + 1] = energies[j] + frame[j] * frame[j];
+
+    double windowEnergy = energies[integrationWindow];
+    if (windowEnergy / integrationWindow < SILENCE_POWER) return 0.0;
+
+    std::copy(frame, frame + integrationWindow, buffer);
+    std::fill(buffer + integrationWindow, buffer + fftSize, 0.0);
+    fftw_execute_dft_r2c(forwardPlan, buffer, spectrumA);
+
+    std::copy(frame, frame + frameLength, buffer);
+    std::fill(buffer + frameLength, buffer + fftSize, 0.0);
+    fftw_execute_dft_r2c(forwardPlan, buffer, spectrumB);
+
+    // conj(A) * B, the inverse is the cross-correlation (fftSize >= frameLength so no lag wraps around)
+    for (int k = 0; k <= fftSize / 2; ++k) {
+        double ar = spectrumA[k][0];
+        double ai = spectrumA[k][1];
+        double br = spectrumB[k][0];
+        double bi = spectrumB[k][1];
+        spectrumB[k][0] = ar * br + ai * bi;
+        spectrumB[k][1] = ar * bi - ai * br;
+    }
+    fftw_execute_dft_c2r(inversePlan, spectrumB, buffer); // unnormalized, scaled by fftSize
+
+    // cumulative mean normalized difference
+    differences[0] = 1.0;
+    double runningSum = 0.0;
+    for (int tau = 1; tau <= maxLag; ++tau) {
+        double correlation = buffer[tau] / fftSize;
+        double difference = windowEnergy + (energies[tau + integrationWindow] - energies[tau]) - 2.0 * correlation;
+        runningSum += difference;
+        differences[tau] = runningSum > 0.0 ? difference * tau / runningSum : 1.0;
+    }
+
+    int period = -1;
+    for (int tau = minLag; tau < maxLag; ++tau) {
+        if (differences[tau] < YIN_THRESHOLD) {
+            while (tau + 1 < maxLag && differences[tau + 1] < differences[tau]) ++tau;
+            period = tau;
+            break;
+        }
+    }
+    if (period < 0) return 0.0;
+
+    double denominator = differences[period - 1] - 2.0 * differences[period] + differences[period + 1];
+    double shift = std::abs(denominator) > 1e-12 ? 0.5 * (differences[period - 1] - differences[period + 1]) / denominator : 0.0;
+    return sampleRate / (period + shift);
+}
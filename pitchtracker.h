@@ -0,0 +1,78 @@
+#ifndef PITCHTRACKER_H
+#define PITCHTRACKER_H
+
+#include <QVector>
+#include <fftw3.h>
+
+/*
+ * File: pitchtracker.h
+ * Description:
+ *  This header file defines the 'PitchTracker' class, which estimates the fundamental frequency (F0) of speech with the
+ *  YIN algorithm, and the 'PitchContour' struct holding the result for one track. The difference function of YIN is
+ *  computed from a cross-correlation done with FFTW, the same library the 'Spectrograph' uses for its STFT.
+ *
+ * Purpose:
+ *  - Gives learners a pitch track to compare, which matters most for Japanese pitch accent
+ *
+ * Key Members:
+ *  - 'int sampleRate': Sample rate of the samples to track
+ *  - 'int minLag, maxLag': Periods (in samples) of the highest and lowest F0 searched
+ *  - 'int integrationWindow': Samples compared per lag, one period of the lowest F0
+ *  - 'int frameLength': Samples read per frame (integrationWindow + maxLag)
+ *  - 'int fftSize': Power of two FFT size, at least frameLength so the correlation does not wrap around
+ *  - 'fftw_plan forwardPlan, inversePlan': Real to complex and complex to real plans, created once and executed with
+ *    the new-array FFTW functions so every worker thread can use them with its own buffers
+ *
+ * Public Methods:
+ *  - 'PitchTracker(int sampleRate, double minF0 = 60.0, double maxF0 = 500.0)': Sizes the frames and creates the plans,
+ *    FFTW's planner is not thread safe so they are made (and destroyed) under 'Stft::plannerLock()'
+ *  - 'int getSampleRate() const': Sample rate the frames were sized for
+ *  - 'PitchContour track(const QVector<double> &samples) const': F0 of every frame (10 ms hop), frames are split into
+ *    blocks processed in parallel by the global thread pool, 0 Hz marks unvoiced frames
+ *
+ * Notes:
+ *  - 60 to 500 Hz covers low male to high female and child voices.
+ *
+ * References:
+ *  - de Cheveigné, A., & Kawahara, H. (2002). YIN, a fundamental frequency estimator for speech and music.
+ */
+
+struct PitchContour
+{
+    QVector<double> f0; // Hz per frame, 0 if unvoiced
+    int hopSize = 0;
+    int frameLength = 0;
+    int sampleRate = 0;
+    qint64 numSamples = 0;
+
+    bool isEmpty() const { return f0.isEmpty() || numSamples == 0; }
+    // frames are placed at their center
+    double frameToProportion(int frame) const { return ((double) frame * hopSize + frameLength / 2.0) / numSamples; }
+};
+
+class PitchTracker
+{
+    int sampleRate;
+    int minLag;
+    int maxLag;
+    int integrationWindow;
+    int frameLength;
+    int fftSize;
+    int hopSize;
+    fftw_plan forwardPlan;
+    fftw_plan inversePlan;
+
+    double frameF0(const double *frame, double *buffer, fftw_complex *spectrumA, fftw_complex *spectrumB,
+                   double *differences, double *energies) const;
+
+public:
+    PitchTracker(int sampleRate, double minF0 = 60.0, double maxF0 = 500.0);
+    ~PitchTracker();
+    PitchTracker(const PitchTracker &) = delete;
+    PitchTracker &operator=(const PitchTracker &) = delete;
+
+    int getSampleRate() const;
+    PitchContour track(const QVector<double> &samples) const;
+};
+
+#endif // PITCHTRACKER_H
@@ -0,0 +1,143 @@
+#include "resampler.h"
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include "tracer.h"
+
+/*
+ * File: resampler.cpp
+ * Description:
+ *  This source file implements the 'Resampler'. Output n sits at n * downFactor / upFactor input samples. Its integer
+ *  part picks the input samples, its fraction (outputPhase / upFactor) picks the row of taps, so only the taps that
+ *  meet a non zero input sample are ever multiplied. Position and phase advance by adding downFactor to the phase and
+ *  carrying into the position, nothing grows with the length of the stream.
+ *
+ * Key Methods:
+ *  - 'Resampler()': Tap k of phase p is the windowed sinc at (k - halfLength + 1) - p / upFactor, each phase is scaled
+ *    to a gain of 1 at DC
+ *  - 'produce()': Computes outputs while the input they need is in the history (or up to lastOutput when flushing),
+ *    then drops the history before the next output's first tap
+ */
+
+#define ZERO_CROSSINGS 16
+#define CUTOFF 0.92 // of the lower Nyquist frequency
+#define KAISER_BETA 8.0
+#define MAX_PHASES 1024
+
+static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50 && term > 1e-12 * sum; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+Resampler::Resampler(int _inputRate, int _outputRate)
+    : inputRate(std::max(_inputRate, 1)), outputRate(std::max(_outputRate, 1))
+{
+    int common = std::gcd(inputRate, outputRate);
+    upFactor = outputRate / common;
+    downFactor = inputRate / common;
+    phases = std::min(upFactor, MAX_PHASES);
+
+    // cutoff in cycles per input sample, the filter widens by the same factor it narrows when downsampling
+    double scale = std::min(1.0, (double) upFactor / downFactor);
+    double cutoff = 0.5 * CUTOFF * scale;
+    halfLength = (int) std::ceil(ZERO_CROSSINGS / scale);
+    taps = (2 * halfLength + 3) / 4 * 4;
+
+    // one row more than phases: fraction 1 is where a phase past the last tabulated one rounds to
+    filters.resize((phases + 1) * taps);
+    double windowNorm = besselI0(KAISER_BETA);
+    for (int phase = 0; phase <= phases; ++phase) {
+        double *row = filters.data() + phase * taps;
+        double fraction = (double) phase / phases;
+        double sum = 0.0;
+        for (int k = 0; k < 2 * halfLength; ++k) {
+            double t = (k - halfLength + 1) - fraction; // input sample relative to the output, in samples
+            double x = t / (halfLength + 1);
+            double window = std::abs(x) < 1.0 ? besselI0(KAISER_BETA * std::sqrt(1.0 - x * x)) / windowNorm : 0.0;
+            double sinc = t == 0.0 ? 1.0 : std::sin(2.0 * M_PI * cutoff * t) / (2.0 * M_PI * cutoff * t);
+            row[k] = sinc * window;
+            sum += row[k];
+        }
+        for (int k = 0; k < 2 * halfLength; ++k) row[k] /= sum;
+    }
+    reset();
+}
+
+void Resampler::reset() {
+    history.fill(0.0, halfLength - 1); // silence before the first sample
+    historyStart = -(halfLength - 1);
+    inputCount = 0;
+    outputBase = 0;
+    outputPhase = 0;
+    outputCount = 0;
+}
+
+QVector<double> Resampler::process(const double *input, qsizetype count) {
+    TRACE_SCOPE("Resampler::process");
+    history.reserve(history.size() + count);
+    for (qsizetype i = 0; i < count; ++i) history.append(input[i]);
+    inputCount += count;
+
+    QVector<double> output;
+    produce(output, -1);
+    return output;
+}
+
+QVector<double> Resampler::flush() {
+    // outputs up to the end of the input, every tap after it reads silence
+    qint64 total = (inputCount * upFactor + downFactor - 1) / downFactor;
+    for (int i = 0; i < taps; ++i) history.append(0.0);
+    QVector<double> output;
+    produce(output, total);
+    reset();
+    return output;
+}
+
+void Resampler::produce(QVector<double> &output, qint64 lastOutput) {
+    qint64 available = historyStart + history.size(); // stream index after the last sample in the history
+    qint64 last = outputBase + taps - halfLength; // index after the last tap the next output reads
+    if (lastOutput < 0) {
+        qint64 estimate = (available - last) * upFactor / downFactor + 1;
+        output.reserve(std::max<qint64>(estimate, 0));
+    }
+
+    const double *samples = history.constData();
+    while (outputBase + taps - halfLength + 1 <= available && (lastOutput < 0 || outputCount < lastOutput)) {
+        const double *x = samples + (outputBase - halfLength + 1 - historyStart);
+        int phase = phases == upFactor ? outputPhase : (int) (((qint64) outputPhase * phases + upFactor / 2) / upFactor);
+        const double *h = filters.constData() + phase * taps;
+
+        double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+        for (int k = 0; k < taps; k += 4) {
+            sum0 += h[k] * x[k];
+            sum1 += h[k + 1] * x[k + 1];
+            sum2 += h[k + 2] * x[k + 2];
+            sum3 += h[k + 3] * x[k + 3];
+        }
+        output.append((sum0 + sum1) + (sum2 + sum3));
+        ++outputCount;
+
+        outputPhase += downFactor;
+        outputBase += outputPhase / upFactor;
+        outputPhase %= upFactor;
+    }
+
+    // keep only what the next output reads
+    qint64 keepFrom = std::min(outputBase - halfLength + 1, available);
+    if (keepFrom > historyStart) {
+        history.remove(0, keepFrom - historyStart);
+        historyStart = keepFrom;
+    }
+}
+
+QVector<double> Resampler::resample(const QVector<double> &samples, int inputRate, int outputRate) {
+    if (inputRate == outputRate) return samples;
+    Resampler resampler(inputRate, outputRate);
+    QVector<double> output = resampler.process(samples);
+    output.append(resampler.flush());
+    return output;
+}
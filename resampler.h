@@ -0,0 +1,77 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QVector>
+
+/*
+ * File: resampler.h
+ * Description:
+ *  This header file defines the 'Resampler' class, a polyphase windowed sinc sample rate converter. Tracks are converted
+ *  to one common analysis rate when they are decoded so the spectrogram bins, pitch and formant frames of the speaker
+ *  and the user track mean the same frequencies and durations even if the files were recorded at 48 kHz and 44.1 kHz.
+ *
+ * Key Members:
+ *  - 'static const int analysisRate': The common rate every track is analysed at
+ *  - 'int upFactor, downFactor': outputRate / inputRate reduced to lowest terms (44.1 -> 48 kHz is 160 / 147)
+ *  - 'QVector<double> filters': One row of taps per phase and one for the fraction 1, every row padded to a multiple
+ *    of 4 taps
+ *  - 'QVector<double> history': Input samples the next outputs still need, the stream is zero before its first sample
+ *
+ * Public Methods:
+ *  - 'Resampler(int inputRate, int outputRate)': Designs the filter bank
+ *  - 'QVector<double> process(const double *input, qsizetype count)': Streams a block in, returns every output sample
+ *    whose filter has now seen all of its input
+ *  - 'QVector<double> flush()': Returns the remaining outputs as if the stream continued with silence, then resets
+ *  - 'static QVector<double> resample(const QVector<double> &samples, int inputRate, int outputRate)': Whole signal
+ *
+ * Notes:
+ *  - The low pass cuts at CUTOFF of the lower Nyquist frequency, so downsampling does not alias and upsampling does not
+ *    image. The filter spans ZERO_CROSSINGS zero crossings of the sinc on each side and is Kaiser windowed.
+ *  - An output of 'process' plus 'flush' has exactly ceil(inputCount * outputRate / inputRate) samples, the first one
+ *    at the time of the first input sample, so proportions of the track stay the same.
+ *  - The dot product of a phase runs over 4 independent sums, the compiler keeps them in one SIMD register instead of
+ *    waiting on one long chain of additions.
+ *  - With more than MAX_PHASES phases (rates that share no common factor) the phase is rounded to the nearest of the
+ *    MAX_PHASES + 1 tabulated fractions 0, 1/MAX_PHASES, ..., 1, the timing error is at most 1/(2 * MAX_PHASES) of a
+ *    sample.
+ *
+ * References:
+ *  - Smith, J. O. Digital Audio Resampling Home Page, https://ccrma.stanford.edu/~jos/resample/
+ *  - https://en.wikipedia.org/wiki/Kaiser_window
+ */
+
+class Resampler
+{
+    int inputRate;
+    int outputRate;
+    int upFactor;
+    int downFactor;
+    int halfLength; // input samples on each side of an output
+    int taps; // per phase, padded to a multiple of 4
+    int phases; // tabulated phases, upFactor unless that is more than MAX_PHASES
+    QVector<double> filters;
+
+    QVector<double> history;
+    qint64 historyStart; // stream index of history[0]
+    qint64 inputCount = 0;
+    qint64 outputBase = 0; // input index at or before the next output
+    int outputPhase = 0; // the next output is at outputBase + outputPhase / upFactor
+    qint64 outputCount = 0;
+
+    void produce(QVector<double> &output, qint64 lastOutput);
+    void reset();
+
+public:
+    static const int analysisRate = 44100;
+
+    Resampler(int inputRate, int outputRate);
+
+    int getInputRate() const { return inputRate; }
+    int getOutputRate() const { return outputRate; }
+    QVector<double> process(const double *input, qsizetype count);
+    QVector<double> process(const QVector<double> &input) { return process(input.constData(), input.size()); }
+    QVector<double> flush();
+    static QVector<double> resample(const QVector<double> &samples, int inputRate, int outputRate);
+};
+
+#endif // RESAMPLER_H
@@ -2,6 +2,13 @@
 #include "QBoxLayout"
 #include <QtCharts/QLineSeries>
 #include <QValueAxis>
+#include "memorybudget.h"
+#include <cmath>
+
+#define CHART_CACHE_SIZE 5
+#define LTAS_VIEW_WIDTH 300
+#define LTAS_DISPLAY_MAX_HZ 8000.0
+#define LTAS_DISPLAY_RANGE_DB 80.0
 
 /*
  * File: segmentgraph.cpp
@@ -15,21 +22,31 @@
  *  - 'void SegmentGraph::slideSegments(int position)': Given a integer of the slider position, the QChartView will
  *    change its QChart to the corresponding value by index
  *  - 'void SegmentGraph::exitView()': Upon pressing the exit button, the widget will be set to be invisible
- *  - 'void SegmentGraph::updateGraphs(QList<QList<float>> segments)': The widget is set as visible, the chart values
- *    are cleared, and then refilled with new charts based on the values of segments. Using this new charts value, the
- *    slider is reset to fid it's values.
+ *  - 'void SegmentGraph::updateGraphs(QList<QList<float>> segments)': The widget is set as visible, the cached charts
+ *    are deleted and the new segments are stored. The slider is reset to fit the number of segments and only the first
+ *    chart is built.
+ *
+ * Private Methods:
+ *  - 'QChart *SegmentGraph::chartForSegment(int position)': Looks the chart up in the LRU cache, otherwise builds it with a
+ *    single QLineSeries::replace() of the decimated points and evicts the least recently shown chart if the cache is full
+ *  - 'void SegmentGraph::updateChartBytes()': Reports the points of the cached charts to the 'MemoryBudget', whose
+ *    evictor empties the cache except for the chart on screen
+ *  - 'QList<QPointF> SegmentGraph::decimateSegment(const QList<float> &segment, int columns)': Splits the segment into one
+ *    bucket per pixel column and keeps the min and max sample of each bucket in time order, so peaks are never lost
+ *  - 'void SegmentGraph::showStatistics(int position)': Replaces the points of both LTAS lines (bins up to
+ *    LTAS_DISPLAY_MAX_HZ) and scales the level axis to the LTAS_DISPLAY_RANGE_DB below the loudest of them
  *
  * Notes:
  *  - Default values for the width and height are 400 and 200 respectively.
  *  - This widget is only set to be visible when the updateGraphs slot is called.
+ *  - Auto segmentation can produce up to 100 segments, building a chart for each of them up front took seconds, so charts
+ *    are only made when the slider reaches them and at most CHART_CACHE_SIZE of them are kept in memory.
  *
  * References:
  *  - ...
  */
 
 SegmentGraph::SegmentGraph(int width, int height) {
-    charts = new QList<QChart *>();
-
     segGraphLayout = new QVBoxLayout();
     setLayout(segGraphLayout);
 
@@ -58,13 +75,180 @@ SegmentGraph::SegmentGraph(int width, int height) {
 
     graph = new QChartView();
     graph->resize(width, height);
-    segGraphLayout->addWidget(graph);
+    graphsLayout = new QHBoxLayout();
+    graphsLayout->addWidget(graph);
+    segGraphLayout->addLayout(graphsLayout);
+
+    // long-term average spectra of the segment and the file, one chart whose lines are replaced
+    QChart *ltasChart = new QChart();
+    ltasChart->setTitle("long-term average spectrum");
+    fileLtasLine = new QLineSeries();
+    fileLtasLine->setName("file");
+    segmentLtasLine = new QLineSeries();
+    segmentLtasLine->setName("segment");
+    ltasChart->addSeries(fileLtasLine);
+    ltasChart->addSeries(segmentLtasLine);
+    QValueAxis *frequencyAxis = new QValueAxis();
+    frequencyAxis->setRange(0.0, LTAS_DISPLAY_MAX_HZ);
+    frequencyAxis->setTitleText("Hz");
+    levelAxis = new QValueAxis();
+    levelAxis->setRange(-LTAS_DISPLAY_RANGE_DB, 0.0);
+    levelAxis->setTitleText("dB");
+    ltasChart->addAxis(frequencyAxis, Qt::AlignBottom);
+    ltasChart->addAxis(levelAxis, Qt::AlignLeft);
+    for (QLineSeries *line : {fileLtasLine, segmentLtasLine}) {
+        line->attachAxis(frequencyAxis);
+        line->attachAxis(levelAxis);
+    }
+    ltasGraph = new QChartView(ltasChart);
+    ltasGraph->setFixedWidth(LTAS_VIEW_WIDTH);
+    statisticsLabel = new QLabel();
+    statisticsLabel->setFixedWidth(LTAS_VIEW_WIDTH);
+    statisticsLabel->setWordWrap(true);
+    QVBoxLayout *statisticsLayout = new QVBoxLayout();
+    statisticsLayout->addWidget(ltasGraph);
+    statisticsLayout->addWidget(statisticsLabel);
+    graphsLayout->addLayout(statisticsLayout);
+
+    // charts are rebuilt from the segment samples when the slider reaches them again
+    budgetEntry = MemoryBudget::add("segment charts", [this]() { clearChartCache(); });
+}
+
+SegmentGraph::~SegmentGraph() {
+    MemoryBudget::remove(budgetEntry);
 }
 
 void SegmentGraph::slideSegments(int position) {
-    if (position >= charts->length()) return;
-    graph->setChart(charts->at(position));
+    if (position < 0 || position >= segmentSamples.length()) return;
+
+    QChart *previous = graph->chart();
+    QChart *chart = chartForSegment(position);
+    graph->setChart(chart);
+
+    // the view gives up ownership of the chart it was showing, anything not in the cache has to go
+    if (previous && previous != chart && !chartCache.values().contains(previous)) delete previous;
     getSegmentAudioToPlay(position);
+    showStatistics(position);
+}
+
+void SegmentGraph::setStatistics(LtasStatistics _fileStatistics, QList<LtasStatistics> _segmentStatistics) {
+    fileStatistics = _fileStatistics;
+    segmentStatistics = _segmentStatistics;
+    showStatistics(segmentSlider->sliderPosition());
+}
+
+static QList<QPointF> ltasPoints(const LtasStatistics &statistics) {
+    QList<QPointF> points;
+    for (int bin = 0; bin < statistics.ltasDb.size() && bin * statistics.binHz <= LTAS_DISPLAY_MAX_HZ; ++bin) {
+        points.append(QPointF(bin * statistics.binHz, statistics.ltasDb[bin]));
+    }
+    return points;
+}
+
+static QString describeStatistics(const QString &name, const LtasStatistics &statistics) {
+    QStringList bands;
+    for (int band = 0; band < Ltas::bandCount(); ++band) {
+        bands << QString("%1: %2 dB").arg(Ltas::bandName(band)).arg(statistics.bandEnergiesDb[band], 0, 'f', 1);
+    }
+    return QString("%1: centroid %2 Hz, tilt %3 dB/octave\n%4").arg(name).arg(statistics.centroidHz, 0, 'f', 0)
+        .arg(statistics.tiltDbPerOctave, 0, 'f', 1).arg(bands.join(", "));
+}
+
+void SegmentGraph::showStatistics(int position) {
+    const LtasStatistics *segment = nullptr;
+    if (position >= 0 && position < segmentStatistics.length()) segment = &segmentStatistics[position];
+    bool showSegment = segment && !segment->isEmpty();
+    fileLtasLine->replace(ltasPoints(fileStatistics));
+    segmentLtasLine->replace(showSegment ? ltasPoints(*segment) : QList<QPointF>());
+
+    double loudest = -LTAS_DISPLAY_RANGE_DB;
+    for (QLineSeries *line : {fileLtasLine, segmentLtasLine}) {
+        for (const QPointF &point : line->points()) loudest = std::max(loudest, point.y());
+    }
+    double top = std::ceil(loudest / 10.0) * 10.0;
+    levelAxis->setRange(top - LTAS_DISPLAY_RANGE_DB, top);
+
+    QStringList descriptions;
+    if (showSegment) descriptions << describeStatistics(QString("segment %1").arg(position + 1), *segment);
+    if (!fileStatistics.isEmpty()) descriptions << describeStatistics("file", fileStatistics);
+    statisticsLabel->setText(descriptions.join("\n"));
+}
+
+QChart *SegmentGraph::chartForSegment(int position) {
+    if (chartCache.contains(position)) {
+        chartCacheOrder.removeOne(position);
+        chartCacheOrder.append(position);
+        return chartCache.value(position);
+    }
+
+    QLineSeries *segmentLine = new QLineSeries();
+    segmentLine->replace(decimateSegment(segmentSamples[position], std::max(graph->width(), 100)));
+
+    QChart *tempChart = new QChart();
+    tempChart->addSeries(segmentLine);
+    tempChart->legend()->hide();
+    tempChart->createDefaultAxes();
+
+    chartCache.insert(position, tempChart);
+    chartCacheOrder.append(position);
+
+    if (chartCacheOrder.length() > CHART_CACHE_SIZE) {
+        QChart *evicted = chartCache.take(chartCacheOrder.takeFirst());
+        // the chart on screen is deleted by slideSegments once it has been swapped out
+        if (evicted != graph->chart()) delete evicted;
+    }
+    updateChartBytes();
+    return tempChart;
+}
+
+QList<QPointF> SegmentGraph::decimateSegment(const QList<float> &segment, int columns) {
+    QList<QPointF> points;
+    int length = segment.length();
+
+    // few enough samples to draw every one of them
+    if (length <= 2 * columns) {
+        points.reserve(length);
+        for (int j = 0; j < length; ++j) points.append(QPointF(j + 1, segment[j]));
+        return points;
+    }
+
+    points.reserve(2 * columns);
+    for (int c = 0; c < columns; ++c) {
+        int start = (qint64) c * length / columns;
+        int end = (qint64) (c + 1) * length / columns;
+        int minIndex = start;
+        int maxIndex = start;
+        for (int j = start + 1; j < end; ++j) {
+            if (segment[j] < segment[minIndex]) minIndex = j;
+            if (segment[j] > segment[maxIndex]) maxIndex = j;
+        }
+        // keep the pair in time order so the line does not double back
+        int first = std::min(minIndex, maxIndex);
+        int second = std::max(minIndex, maxIndex);
+        points.append(QPointF(first + 1, segment[first]));
+        if (second != first) points.append(QPointF(second + 1, segment[second]));
+    }
+    return points;
+}
+
+void SegmentGraph::clearChartCache() {
+    QChart *shown = graph->chart();
+    for (QChart *chart : std::as_const(chartCache)) {
+        if (chart != shown) delete chart;
+    }
+    chartCache.clear();
+    chartCacheOrder.clear();
+    updateChartBytes();
+}
+
+void SegmentGraph::updateChartBytes() {
+    qint64 bytes = 0;
+    for (QChart *chart : std::as_const(chartCache)) {
+        for (QAbstractSeries *series : chart->series()) {
+            if (QXYSeries *line = qobject_cast<QXYSeries *>(series)) bytes += line->count() * (qint64) sizeof(QPointF);
+        }
+    }
+    MemoryBudget::setBytes(budgetEntry, bytes);
 }
 
 void SegmentGraph::exitView() {
@@ -76,22 +260,12 @@ void SegmentGraph::updateGraphs(QList<QList<float>> segments) {
     audioPlaying = false;
     setVisible(true);
 
-    charts->clear();
-
-    for(int i = 0; i < segments.length(); ++i) {
-        QLineSeries *segmentLine = new QLineSeries();
-        for(int j = 0; j < segments[i].length(); ++j) {
-            segmentLine->append(j + 1, segments[i][j]);
-        }
-        QChart *tempChart = new QChart();
-        tempChart->addSeries(segmentLine);
-        tempChart->legend()->hide();
-        tempChart->createDefaultAxes();
-        charts->append(tempChart);
-    }
+    clearChartCache();
+    segmentSamples = segments;
+    segmentStatistics.clear(); // computed for the new segments after they are drawn
 
     segmentSlider->setMinimum(0);
-    segmentSlider->setMaximum(charts->length() - 1);
+    segmentSlider->setMaximum(segmentSamples.length() - 1);
     slideSegments(0);
     segmentSlider->setSliderPosition(0);
     emit clearSegmentsEnable(true);
@@ -100,13 +274,15 @@ void SegmentGraph::clearView(){
     if (segmentSlider) segmentSlider->setSliderPosition(0);
     int w = graph->width();
     int h = graph->height();
-    delete graph;
+    clearChartCache();
+    segmentSamples.clear();
+    delete graph; // also deletes the chart it is showing
     graph = new QChartView();
     graph->resize(w, h);
-    segGraphLayout->addWidget(graph);
-     if (!charts->isEmpty()){
-        charts->clear();
-     }
+    graphsLayout->insertWidget(0, graph);
+    fileStatistics = LtasStatistics();
+    segmentStatistics.clear();
+    showStatistics(-1);
      playSegmentButton->setEnabled(false);
     exitView();
      emit clearSegmentsEnable(false);
@@ -8,6 +8,11 @@
 #include <QChartView>
 #include <QBoxLayout>
 #include <QToolButton>
+#include <QHash>
+#include <QLabel>
+#include <QLineSeries>
+#include <QValueAxis>
+#include "ltas.h"
 
 
 /*
@@ -20,12 +25,21 @@
  * Purpose:
  *  - The segment graph will appear upon the selection of different segments, this widget will show the raw data of
  *    a given segment as a QChart. An exit button and slider are included for controls of this widget.
+ *  - Next to the samples it shows the long-term average spectrum of the segment over that of the whole file, with the
+ *    centroid, tilt and band energies of both ('Ltas', computed by 'WaveFormSegments')
  *
  * Key Members:
  *  - 'QSlider *segmentSlider': A slider to select which chart out of the list to show
  *  - 'QPushButton *exitButton': A button that controls the visibility of the widget to make it invisible
  *  - 'QChartView *graph': The main widget of which to view the graphs
- *  - 'QList<QChart *> *charts': Data of preloaded charts to easily switch between on the chartView
+ *  - 'QList<QList<float>> segmentSamples': Raw samples of every segment, charts are only built from these when shown
+ *  - 'QHash<int, QChart *> chartCache': Small LRU cache of the most recently shown charts, keyed by segment index
+ *  - 'QList<int> chartCacheOrder': Segment indices in the cache ordered from least to most recently shown
+ *  - 'QChartView *ltasGraph', 'QLineSeries *fileLtasLine, *segmentLtasLine': One chart for the spectra, its lines are
+ *    replaced when the slider moves
+ *  - 'QLabel *statisticsLabel': Centroid, tilt and band energies of the file and the segment shown
+ *  - 'LtasStatistics fileStatistics', 'QList<LtasStatistics> segmentStatistics': The statistics of the file and of every
+ *    segment, empty until they are computed
  *
  * Public Methods:
  *  - 'SegmentGraph(int width, int height)': Constructor initializing the exit button, slider, and charts. Parameters
@@ -34,11 +48,21 @@
  * Slots:
  *  - 'void slideSegments(int position)': changes the chart to show the graph according to the slider position
  *  - 'void exitView()': makes the SegmentGraph invisible until the next updateGraph
- *  - 'void updateGraphs(QList<QList<float>> segments)': visualizes the segments as a list of QCharts
+ *  - 'void updateGraphs(QList<QList<float>> segments)': stores the segments, the chart of a segment is built when the slider reaches it
  *  - 'void clearView()': Clears the charts and resets the widget
+ *  - 'void setStatistics(LtasStatistics fileStatistics, QList<LtasStatistics> segmentStatistics)': stores the spectra
+ *    and statistics and shows those of the segment on screen
+ *
+ * Private Methods:
+ *  - 'QChart *chartForSegment(int position)': returns the cached chart of a segment or builds it, evicting the least recently shown chart
+ *  - 'QList<QPointF> decimateSegment(const QList<float> &segment, int columns)': reduces a segment to its min and max point per pixel column
+ *  - 'void clearChartCache()': deletes every cached chart that is not owned by the chart view, also the 'MemoryBudget' evictor
+ *  - 'void updateChartBytes()': reports the bytes of the points in the cached charts to the 'MemoryBudget'
+ *  - 'void showStatistics(int position)': puts the spectra and statistics of a segment and of the file on screen
  *
  * Notes:
  *  - This widget is completely invisible until a signal with a QList<QList<float>> is emitted.
+ *  - QChartView::setChart releases ownership of the previous chart, so charts that leave the cache are deleted here.
  *
  * References:
  *  - ...
@@ -51,14 +75,32 @@ class SegmentGraph: public QWidget
     QSlider *segmentSlider;
     QPushButton *exitButton;
     QChartView *graph;
-    QList<QChart *> *charts;
+    QHBoxLayout *graphsLayout;
+    QChartView *ltasGraph;
+    QLineSeries *fileLtasLine;
+    QLineSeries *segmentLtasLine;
+    QValueAxis *levelAxis;
+    QLabel *statisticsLabel;
+    LtasStatistics fileStatistics;
+    QList<LtasStatistics> segmentStatistics;
+    QList<QList<float>> segmentSamples;
+    QHash<int, QChart *> chartCache;
+    QList<int> chartCacheOrder;
+    int budgetEntry;
     QToolButton *playSegmentButton;
     QPair<double,double> startEndOfSelectedSegment;
     QList<QPair<double, double>> startEndSegmentAudioValues;
     bool audioPlaying;
 
+    QChart *chartForSegment(int position);
+    QList<QPointF> decimateSegment(const QList<float> &segment, int columns);
+    void clearChartCache();
+    void updateChartBytes();
+    void showStatistics(int position);
+
 public:
     SegmentGraph(int width, int height);
+    ~SegmentGraph();
 
 public slots:
     void slideSegments(int position);
@@ -69,6 +111,7 @@ public slots:
     void getSegmentAudioToPlay(int segmentPosition);
     void playSegmentAudio();
     void changePlayPauseButton(bool segAudioNotPlaying);
+    void setStatistics(LtasStatistics _fileStatistics, QList<LtasStatistics> _segmentStatistics);
 signals:
     void sendPlaySegmentAudio(QPair<double, double>);
     void clearSegmentsEnable(bool);
@@ -0,0 +1,53 @@
+#ifndef SPECTRALFRAMES_H
+#define SPECTRALFRAMES_H
+
+#include <QVector>
+#include <QMetaType>
+
+/*
+ * File: spectralframes.h
+ * Description:
+ *  This header file defines the 'SpectralFrames' struct, the STFT frames computed by 'Spectrograph' together with the
+ *  parameters needed to place them in time. It is passed from the spectrograph to the analyses that reuse the frames
+ *  instead of decoding and transforming the audio again.
+ *
+ * Key Members:
+ *  - 'QVector<QVector<double>> magnitudes': One row per frame with the windowSize/2 FFT amplitudes of that frame
+ *  - 'int windowSize': Number of samples in each frame
+ *  - 'int hopSize': Number of samples between the starts of two frames
+ *  - 'int sampleRate': Sample rate of the decoded audio the frames were computed from
+ *  - 'qint64 numSamples': Number of decoded (mono) samples, used to turn frames into proportions of the track
+ *  - 'double bandStart', 'double bandStep': Frequency of the first bin and between two bins of band limited frames
+ *    ('MultiResolutionStft' with a frequency range), 0 for frames of the whole band
+ *
+ * Public Methods:
+ *  - 'bool isEmpty() const': True if no frames have been computed
+ *  - 'double binFrequency(int bin) const': Frequency in Hz of an FFT bin, or of a bin of the band
+ *  - 'double frameToProportion(int frame) const': Start of a frame as a proportion of the track (0 to 1)
+ *  - 'int proportionToFrame(double proportion) const': Frame that starts closest to a proportion of the track
+ *
+ * Notes:
+ *  - The rest of the app places everything as proportions of the track (scrubber, segments), so frames are converted
+ *    the same way rather than to sample indices of a specific decoder.
+ *  - QVector is implicitly shared, copying this struct through signals does not copy the frames.
+ */
+
+struct SpectralFrames
+{
+    QVector<QVector<double>> magnitudes;
+    int windowSize = 0;
+    int hopSize = 0;
+    int sampleRate = 0;
+    qint64 numSamples = 0;
+    double bandStart = 0.0;
+    double bandStep = 0.0;
+
+    bool isEmpty() const { return magnitudes.isEmpty() || numSamples == 0; }
+    double binFrequency(int bin) const { return bandStep > 0.0 ? bandStart + bin * bandStep : (double) bin * sampleRate / windowSize; }
+    double frameToProportion(int frame) const { return (double) frame * hopSize / numSamples; }
+    int proportionToFrame(double proportion) const { return qRound(proportion * numSamples / hopSize); }
+};
+
+Q_DECLARE_METATYPE(SpectralFrames)
+
+#endif // SPECTRALFRAMES_H
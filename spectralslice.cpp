@@ -0,0 +1,153 @@
+#include "spectralslice.h"
+#include "formanttracker.h"
+#include "tracer.h"
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+/*
+ * File: spectralslice.cpp
+ * Description:
+ *  This source file implements the 'SpectralSlice'. The frame of the spectrogram's window size centred at the position
+ *  is transformed with the 'Stft' of the 'Spectrograph'. The LPC envelope is the model spectrum error / |A(w)|^2 of the
+ *  same hamming windowed frame; by Parseval it is on the scale of |X(k)|^2, so both curves share one dB axis.
+ *
+ * Key Methods:
+ *  - 'computeEnvelope()': Autocorrelation of the windowed frame, Levinson-Durbin of 'FormantTracker' and the polynomial
+ *    evaluated at every bin by Horner's scheme with the precomputed e^-iw (order multiply-adds per bin, no FFT needed)
+ *  - 'fillPoints()': Maps the bins inside the frequency range onto the widget, the polylines are drawn straight from it
+ */
+
+#define SLICE_REFRESH_MS 16 // about 60 slices per second at most
+#define SLICE_DB_RANGE 90.0 // from 0 dB (a full scale sine) down
+#define SLICE_MIN_AMPLITUDE 1e-10
+#define MAX_LPC_ORDER 62 // the coefficient buffers of 'FormantTracker::lpcCoefficients()' stay on the stack
+
+SpectralSlice::SpectralSlice(Stft *_stft, int _sampleRate, QWidget *parent)
+    : QWidget(parent), stft(_stft), sampleRate(std::max(_sampleRate, 1))
+{
+    windowSize = stft->getWindowSize();
+    binCount = windowSize / 2;
+    order = std::min(2 + sampleRate / 1000, MAX_LPC_ORDER); // two poles per kHz plus two, as for the formants
+
+    Stft::hammingWindow(windowSize, window);
+    windowSum = 0.0;
+    for (double w : window) windowSum += w;
+
+    amplitudes.resize(binCount);
+    envelope.resize(binCount);
+    windowed.resize(windowSize);
+    autocorrelation.resize(order + 1);
+    coefficients.resize(order + 1);
+    binRotations.resize(binCount);
+    for (int k = 0; k < binCount; ++k) binRotations[k] = std::polar(1.0, -2.0 * M_PI * k / windowSize);
+    spectrumPoints.resize(binCount);
+    envelopePoints.resize(binCount);
+
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(SLICE_REFRESH_MS);
+    connect(refreshTimer, &QTimer::timeout, this, [this]() {
+        hasSlice = computeSlice(pendingPosition);
+        update();
+    });
+
+    setFixedSize(200, 200); // as high as the spectrogram next to it
+}
+
+void SpectralSlice::setSamples(const QVector<double> &_samples, int _sampleRate) {
+    samples = _samples;
+    if (_sampleRate > 0) sampleRate = _sampleRate;
+    hasSlice = false;
+    update();
+}
+
+void SpectralSlice::setFrequencyRange(double _lowHz, double _highHz) {
+    lowHz = _lowHz;
+    highHz = _highHz;
+    update();
+}
+
+void SpectralSlice::setShowEnvelope(bool show) {
+    showEnvelope = show;
+    if (hasSlice) hasSlice = computeSlice(pendingPosition);
+    update();
+}
+
+void SpectralSlice::showAt(double position) {
+    pendingPosition = position;
+    if (!refreshTimer->isActive()) refreshTimer->start();
+}
+
+bool SpectralSlice::computeSlice(double position) {
+    TRACE_SCOPE("SpectralSlice::computeSlice");
+    if (samples.size() < windowSize) return false;
+
+    qint64 start = qRound64(std::clamp(position, 0.0, 1.0) * samples.size()) - windowSize / 2;
+    start = std::clamp<qint64>(start, 0, samples.size() - windowSize);
+    const double *frame = samples.constData() + start;
+
+    stft->computeFrame(frame, amplitudes.data());
+    for (double &amplitude : amplitudes) {
+        amplitude = 20.0 * std::log10(std::max(amplitude / windowSum, SLICE_MIN_AMPLITUDE));
+    }
+    if (showEnvelope) computeEnvelope(frame);
+    return true;
+}
+
+void SpectralSlice::computeEnvelope(const double *frame) {
+    for (int i = 0; i < windowSize; ++i) windowed[i] = frame[i] * window[i];
+    for (int lag = 0; lag <= order; ++lag) {
+        double acc = 0.0;
+        for (int i = lag; i < windowSize; ++i) acc += windowed[i] * windowed[i - lag];
+        autocorrelation[lag] = acc;
+    }
+    if (autocorrelation[0] <= 0.0) {
+        envelope.fill(20.0 * std::log10(SLICE_MIN_AMPLITUDE));
+        return;
+    }
+
+    double error = std::max(FormantTracker::lpcCoefficients(autocorrelation.constData(), order, coefficients.data()), 0.0);
+    double gain = 2.0 * std::sqrt(error) / windowSum; // amplitude scale of 'Stft::computeFrame()'
+    for (int k = 0; k < binCount; ++k) {
+        std::complex<double> value(coefficients[order], 0.0);
+        for (int j = order - 1; j >= 0; --j) value = value * binRotations[k] + coefficients[j];
+        envelope[k] = 20.0 * std::log10(std::max(gain / std::max(std::abs(value), SLICE_MIN_AMPLITUDE), SLICE_MIN_AMPLITUDE));
+    }
+}
+
+int SpectralSlice::fillPoints(const QVector<double> &decibels, QVector<QPointF> &points) const {
+    double high = highHz > 0.0 ? highHz : sampleRate / 2.0;
+    double binHz = (double) sampleRate / windowSize;
+    int count = 0;
+    for (int k = 0; k < binCount; ++k) {
+        double frequency = k * binHz;
+        if (frequency < lowHz || frequency > high) continue;
+        double x = (frequency - lowHz) / (high - lowHz) * width();
+        double y = std::clamp(-decibels[k] / SLICE_DB_RANGE, 0.0, 1.0) * height();
+        points[count++] = QPointF(x, y);
+    }
+    return count;
+}
+
+void SpectralSlice::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+    painter.setPen(Qt::darkGray);
+    painter.drawRect(rect().adjusted(0, 0, -1, -1));
+    if (!hasSlice) return;
+
+    double high = highHz > 0.0 ? highHz : sampleRate / 2.0;
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignTop | Qt::AlignLeft, "0 dB");
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignBottom | Qt::AlignLeft, QString("%1 Hz").arg(lowHz));
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignBottom | Qt::AlignRight, QString("%1 Hz").arg(high));
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(Qt::lightGray, 1));
+    int count = fillPoints(amplitudes, spectrumPoints);
+    painter.drawPolyline(spectrumPoints.constData(), count);
+    if (!showEnvelope) return;
+    painter.setPen(QPen(QColor(255, 80, 200), 2)); // the colour of the formant dots
+    count = fillPoints(envelope, envelopePoints);
+    painter.drawPolyline(envelopePoints.constData(), count);
+}
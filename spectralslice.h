@@ -0,0 +1,100 @@
+#ifndef SPECTRALSLICE_H
+#define SPECTRALSLICE_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QVector>
+#include <QPointF>
+#include <complex>
+#include "stft.h"
+
+/*
+ * File: spectralslice.h
+ * Description:
+ *  This header file defines the 'SpectralSlice' widget, the magnitude spectrum of one frame of the track at the
+ *  position under the mouse or at the playback cursor (a spectral slice as in Praat), with the LPC envelope of the
+ *  same frame on top if it is enabled. It sits next to the spectrogram of the 'Spectrograph'.
+ *
+ * Purpose:
+ *  - Lets the vowel spectra of two precise instants (or of the speaker and the learner) be compared directly
+ *
+ * Key Members:
+ *  - 'Stft *stft': The FFT setup of the 'Spectrograph' (plan, buffers and hamming window), not owned
+ *  - 'QVector<double> samples', 'int sampleRate': Samples of the loaded track, shared with the 'Spectrograph'
+ *  - 'QVector<double> amplitudes, envelope': dB of the bins of the frame shown, 'QVector<QPointF> spectrumPoints,
+ *    envelopePoints': the same as polylines in widget coordinates
+ *  - 'QVector<double> windowed, autocorrelation, coefficients', 'QVector<std::complex<double>> binRotations': LPC
+ *    buffers and e^-iw of every bin, for evaluating the prediction polynomial
+ *  - 'QTimer *refreshTimer': Coalesces position updates to one slice per SLICE_REFRESH_MS
+ *
+ * Public Methods:
+ *  - 'SpectralSlice(Stft *stft, int sampleRate, QWidget *parent)': Allocates every buffer for the window size of stft
+ *  - 'void setSamples(const QVector<double> &samples, int sampleRate)': Track to slice, an empty vector clears it
+ *  - 'void setFrequencyRange(double lowHz, double highHz)': Range of the x axis, 0 for highHz is the whole band
+ *  - 'void setShowEnvelope(bool show)': Draws the LPC envelope or not
+ *  - 'bool computeSlice(double position)': Transforms the frame centred at position (proportion of the track) into
+ *    'amplitudes' and 'envelope', false if there are no samples
+ *
+ * Slots:
+ *  - 'void showAt(double position)': Slices at position at the next refresh, called for every mouse move and cursor
+ *    update
+ *
+ * Notes:
+ *  - Nothing is allocated once the widget is created: the frame goes through 'Stft::computeFrame()', the LPC through
+ *    'FormantTracker::lpcCoefficients()' with buffers of the fixed order, and the polylines overwrite their points.
+ *  - Amplitudes are dB relative to a full scale sine (the window sum is divided out), so slices of different instants
+ *    and tracks are on the same scale.
+ *
+ * References:
+ *  - Praat, "Sound: To Spectrum (slice)" and "Spectrum: LPC smoothing"
+ *  - Markel, J. D., & Gray, A. H. (1976). Linear Prediction of Speech.
+ */
+
+class SpectralSlice : public QWidget
+{
+    Q_OBJECT
+
+public:
+    SpectralSlice(Stft *stft, int sampleRate, QWidget *parent = nullptr);
+
+    void setSamples(const QVector<double> &_samples, int _sampleRate);
+    void setFrequencyRange(double _lowHz, double _highHz);
+    void setShowEnvelope(bool show);
+    bool computeSlice(double position);
+
+public slots:
+    void showAt(double position);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    Stft *stft;
+    QVector<double> samples;
+    int sampleRate;
+    int windowSize;
+    int binCount;
+    int order;
+    double windowSum = 1.0;
+    double lowHz = 0.0;
+    double highHz = 0.0;
+    bool showEnvelope = true;
+    bool hasSlice = false;
+    double pendingPosition = 0.0;
+    QTimer *refreshTimer;
+
+    QVector<double> amplitudes;
+    QVector<double> envelope;
+    QVector<double> windowed;
+    QVector<double> window;
+    QVector<double> autocorrelation;
+    QVector<double> coefficients;
+    QVector<std::complex<double>> binRotations;
+    QVector<QPointF> spectrumPoints;
+    QVector<QPointF> envelopePoints;
+
+    void computeEnvelope(const double *frame);
+    int fillPoints(const QVector<double> &decibels, QVector<QPointF> &points) const;
+};
+
+#endif // SPECTRALSLICE_H
@@ -0,0 +1,72 @@
+#include "spectrogramrenderer.h"
+#include "tracer.h"
+#include <algorithm>
+
+/*
+ * File: spectrogramrenderer.cpp
+ * Description:
+ *  This source file implements the 'SpectrogramRenderer'. Amplitudes are normalized by the loudest one in the range and
+ *  coloured from black (quiet) over red to yellow (loud). Each pixel is written once with the frame and bin under it,
+ *  instead of filling a rectangle per frame and bin (most of which used to be outside the image).
+ */
+
+QImage SpectrogramRenderer::render(const SpectralFrames &frames, double lowHz, double highHz, int width, int height) {
+    TRACE_SCOPE("SpectrogramRenderer::render");
+    const QVector<QVector<double>> &spectrogram = frames.magnitudes;
+    if (spectrogram.isEmpty() || width <= 0 || height <= 0) return QImage();
+
+    // the bins inside the displayed range
+    int binCount = spectrogram.first().size();
+    if (highHz <= 0.0) highHz = frames.binFrequency(binCount);
+    int firstBin = 0;
+    while (firstBin < binCount && frames.binFrequency(firstBin) < lowHz) ++firstBin;
+    int lastBin = binCount - 1;
+    while (lastBin >= firstBin && frames.binFrequency(lastBin) > highHz) --lastBin;
+    if (lastBin < firstBin) return QImage();
+    int shownBins = lastBin - firstBin + 1;
+    int numChunks = spectrogram.size();
+
+    // Find the maximum amplitude for normalization
+    double maxAmp = 0.0;
+    for (const auto &row : spectrogram) {
+        for (int bin = firstBin; bin <= lastBin; ++bin) {
+            maxAmp = std::max(maxAmp, row[bin]);
+        }
+    }
+
+    if (maxAmp == 0.0) return QImage();
+
+    // every pixel takes the frame and bin under it, lowest bin at the bottom
+    QVector<int> pixelBins(height);
+    for (int y = 0; y < height; ++y) pixelBins[y] = firstBin + std::min(shownBins - 1, (height - 1 - y) * shownBins / height);
+    QVector<QRgb> colors(256);
+    for (int intensity = 0; intensity < 256; ++intensity) colors[intensity] = intensityColor(intensity).rgb();
+
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; ++y) {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        int bin = pixelBins[y];
+        for (int x = 0; x < width; ++x) {
+            double amplitude = spectrogram[std::min(numChunks - 1, x * numChunks / width)][bin];
+            line[x] = colors[std::clamp(static_cast<int>((amplitude / maxAmp) * 255.0), 0, 255)];
+        }
+    }
+    return image;
+}
+
+QColor SpectrogramRenderer::intensityColor(int intensity) {
+    // ensure intensity stays within 255
+    intensity = std::clamp(intensity, 0, 255);
+
+    QColor color;
+    if (intensity <= 127) {
+        // map from black (quietest amp) to red (middle amp)
+        int red = std::clamp(intensity * 2, 0, 255);
+        color.setRgb(red, 0, 0); // Only red increases
+    } else {
+        // map from red (middle) to yellow (loudest amp)
+        int green = std::clamp((intensity - 127) * 2, 0, 255);
+        color.setRgb(255, green, 0); // Red stays max, green increases, blue stays 0
+    }
+    return color;
+}
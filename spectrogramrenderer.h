@@ -0,0 +1,29 @@
+#ifndef SPECTROGRAMRENDERER_H
+#define SPECTROGRAMRENDERER_H
+
+#include <QImage>
+#include <QColor>
+#include "spectralframes.h"
+
+/*
+ * File: spectrogramrenderer.h
+ * Description:
+ *  This header file defines the 'SpectrogramRenderer' class, which paints STFT frames into an image with the black to
+ *  red to yellow colour map of the 'Spectrograph'. It only needs QtGui so the batch tool can write the same images.
+ *
+ * Public Methods:
+ *  - 'static QImage render(const SpectralFrames &frames, double lowHz, double highHz, int width, int height)':
+ *    Returns a width x height image of the bins from lowHz to highHz (0 for the whole band), a null image if there is
+ *    nothing to draw. The frames may already be limited to the range, see 'MultiResolutionStft'
+ *  - 'static QColor intensityColor(int intensity)': The colour map, 0 (black) to 255 (yellow), also used by the live
+ *    recording view
+ */
+
+class SpectrogramRenderer
+{
+public:
+    static QImage render(const SpectralFrames &frames, double lowHz, double highHz, int width, int height);
+    static QColor intensityColor(int intensity);
+};
+
+#endif // SPECTROGRAMRENDERER_H
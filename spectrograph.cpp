@@ -2,8 +2,27 @@
 #include <fftw3.h>
 #include <QGraphicsScene>
 #include <QGraphicsView>
-#include <QAudioDecoder>
 #include "spectrograph.h"
+#include "spectrogramrenderer.h"
+#include "tracer.h"
+#include "pcmcache.h"
+#include "analysispipeline.h"
+#include "analysiscache.h"
+#include "spectralslice.h"
+#include "workerpool.h"
+#include "memorybudget.h"
+
+#define PITCH_DISPLAY_MIN_HZ 50.0
+#define PITCH_DISPLAY_MAX_HZ 500.0
+#define CURSOR_Z_VALUE 1.0 // above the pixmap and the analysis overlays
+
+// frequency ranges of the range selector, the first is the default
+static const struct { const char *name; double lowHz; double highHz; } displayRanges[] = {
+    {"0-5 kHz", 0.0, 5000.0},
+    {"0-8 kHz", 0.0, 8000.0},
+    {"0-11 kHz", 0.0, 11025.0},
+    {"whole band", 0.0, 0.0},
+};
 
 /*
  * File: spectograph.cpp
@@ -14,14 +33,33 @@
  *
  * Key Methods:
  *  - 'Spectograph(QWidget *parent)': Constructor initializes FFT setup, UI layout, and defines default parameters.
- *  - 'void loadAudioFile(const QString &fileName)': Loads audio file and initializes decoder (processAudioFile).
- *  - 'void processAudioFile(const QUrl &fileUrl)': Sets up 'QAudioDecoder' for decoding audio buffers.
- *  - 'void bufferReady()': reads from the decoder and normalizes samples
- *  - 'decodingFinished()': once QAudioDecoder is done window samples should be displayed
- *  - 'void setupSpectograph(QVector<double> &accumulatedSamples)': Applies FFT to audia data chunks and updates spectogram.
- *  - 'void hammingWindow(int windowLength, QVector<double> &window)': Generates hamming window vector for FFT
- *  - 'void renderToPixmap()': renders spectrogram based on amplitude calculated in setup to a QPixmap
+ *  - 'void loadAudioFile(const QString &fileName)': Cancels the pipeline of the file before and starts one for the new
+ *    file. Its stages arrive one by one: the analyses of the 'AnalysisCache' if the file was analysed before (shown
+ *    right away, only the samples are still decoded), the decoded samples, then the spectrogram, pitch, formants and
+ *    features as each of them is done
+ *  - 'void setupSpectograph(QVector<double> &accumulatedSamples)': Runs the 'Stft' over the samples and updates spectogram
+ *    on the GUI thread, for the benchmarks that measure it.
+ *  - 'void hammingWindow(int windowLength, QVector<double> &window)': Generates hamming window vector, see 'Stft'
+ *  - 'void renderToPixmap()': renders spectrogram with 'SpectrogramRenderer' and caches it as a QPixmap, one per display
+ *    resolution, so switching the resolution back and forth only swaps pixmaps
  *  - 'void reset()': Clears spectogram and samples data and resets the spectogram.
+ *  - 'SpectralFrames getSpectralFrames()': Packs the spectrogram with its window, hop and sample rate for reuse by other analyses
+ *  - 'void pitchReady()', 'void formantsReady()', 'void featuresReady()': Cache the analyses for the loaded track, they
+ *    are only recomputed when a new file is loaded
+ *  - 'void evictSamples()', 'void evictSpectrogram()': Free the decoded samples and the frames for the 'MemoryBudget'. The
+ *    pixmap stays, so the track looks the same, 'ensureSamples()' and 'ensureSpectrogram()' queue their rebuild on the
+ *    pipeline the next time they are asked for and the results come back like those of the first run
+ *  - 'void drawOverlays()': Draws the voiced parts of the pitch contour as a path over the spectrogram, on its own
+ *    PITCH_DISPLAY_MIN_HZ to PITCH_DISPLAY_MAX_HZ scale, and the formants as dots on the frequency scale of the
+ *    spectrogram, so they sit on the formant bands they were tracked from
+ *  - 'void setDisplayRange(int index)': Takes a range of displayRanges. The display frames only hold the bins of their
+ *    range, so they are computed again for it; until they arrive the analysis frames are drawn cropped to it
+ *  - 'void setCursorPosition(double position)', 'void setSelection(double startProportion, double endProportion)': Move
+ *    the cursor and selection items that 'drawCursor()' put on top of the cached pixmap. Nothing is rendered again, the
+ *    view only repaints the strips the items left and entered, so the cursor can follow playback every timer tick
+ *  - 'bool eventFilter(QObject *watched, QEvent *event)': Mouse moves over the spectrogram slice it at the mouse, leaving
+ *    it returns the slice to the playback cursor. The slice is computed with the 'Stft' of the spectrogram on the GUI
+ *    thread, one frame per refresh, so it has nothing to wait for
  *
  * References:
  *  - This blog explains how to perform Short-Time Fourier Transform using FFTW.
@@ -43,15 +81,21 @@ Spectrograph::Spectrograph(QWidget *parent)
      * */
     hopSize = windowSize;
 
-    // Allocate memory for FFT input and output arrays
-    data = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * windowSize);
-    fft_result = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * windowSize);
-
-    // Create an FFTW plan for 1D transformation
-    plan = fftw_plan_dft_1d(windowSize, data, fft_result, FFTW_FORWARD, FFTW_ESTIMATE);
-
-    // calc hamming window for smoothing (FFT processing)
-    hammingWindow(windowSize, hammingWindowValues);
+    // FFT buffers, plan and hamming window
+    stft = std::make_unique<Stft>(windowSize, hopSize);
+    slice = new SpectralSlice(stft.get(), Resampler::analysisRate, this);
+    pipeline = new AnalysisPipeline(windowSize, hopSize, this);
+    connect(pipeline, &AnalysisPipeline::cacheChecked, this, &Spectrograph::analysisCacheChecked);
+    connect(pipeline, &AnalysisPipeline::analysesRestored, this, &Spectrograph::restoreAnalyses);
+    connect(pipeline, &AnalysisPipeline::samplesDecoded, this, &Spectrograph::samplesReady);
+    connect(pipeline, &AnalysisPipeline::decodeFailed, this, []() { qWarning() << "No audio samples to process!"; });
+    connect(pipeline, &AnalysisPipeline::displayFramesReady, this, &Spectrograph::displayFramesReady);
+    connect(pipeline, &AnalysisPipeline::samplesRestored, this, &Spectrograph::samplesRestored);
+    connect(pipeline, &AnalysisPipeline::framesRestored, this, &Spectrograph::framesRestored);
+    connect(pipeline, &AnalysisPipeline::framesReady, this, &Spectrograph::framesReady);
+    connect(pipeline, &AnalysisPipeline::pitchReady, this, &Spectrograph::pitchReady);
+    connect(pipeline, &AnalysisPipeline::formantsReady, this, &Spectrograph::formantsReady);
+    connect(pipeline, &AnalysisPipeline::featuresReady, this, &Spectrograph::featuresReady);
 
     graphicsView->setFixedSize(650, 200);
     graphicsScene->setSceneRect(0, 0, 650, 200); // match the scene size to the view
@@ -60,190 +104,480 @@ Spectrograph::Spectrograph(QWidget *parent)
     graphicsView->setScene(graphicsScene);
     graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    mainLayout->addWidget(graphicsView);
+    graphicsView->viewport()->setMouseTracking(true); // the slice follows the mouse
+    graphicsView->viewport()->installEventFilter(this);
+    QHBoxLayout *viewRow = new QHBoxLayout();
+    viewRow->addWidget(graphicsView);
+    viewRow->addWidget(slice);
+    mainLayout->addLayout(viewRow);
+
+    // overlay controls
+    QHBoxLayout *overlayControls = new QHBoxLayout();
+    showPitchCheckbox = new QCheckBox(QString("pitch (%1-%2 Hz)").arg(PITCH_DISPLAY_MIN_HZ).arg(PITCH_DISPLAY_MAX_HZ));
+    showPitchCheckbox->setChecked(true);
+    connect(showPitchCheckbox, &QCheckBox::toggled, this, &Spectrograph::drawOverlays);
+    overlayControls->addWidget(showPitchCheckbox, 0, Qt::AlignLeft);
+    showFormantsCheckbox = new QCheckBox("formants");
+    showFormantsCheckbox->setChecked(true);
+    connect(showFormantsCheckbox, &QCheckBox::toggled, this, &Spectrograph::drawOverlays);
+    overlayControls->addWidget(showFormantsCheckbox, 0, Qt::AlignLeft);
+    showEnvelopeCheckbox = new QCheckBox("LPC envelope");
+    showEnvelopeCheckbox->setChecked(true);
+    connect(showEnvelopeCheckbox, &QCheckBox::toggled, slice, &SpectralSlice::setShowEnvelope);
+    overlayControls->addWidget(showEnvelopeCheckbox, 0, Qt::AlignLeft);
+    overlayControls->addStretch();
+    resolutionSelector = new QComboBox();
+    resolutionSelector->addItem(MultiResolutionStft::name(MultiResolutionStft::Wideband));
+    resolutionSelector->addItem(MultiResolutionStft::name(MultiResolutionStft::Narrowband));
+    connect(resolutionSelector, &QComboBox::currentIndexChanged, this, &Spectrograph::renderToPixmap);
+    overlayControls->addWidget(resolutionSelector, 0, Qt::AlignRight);
+    resolutionPixmaps.resize(MultiResolutionStft::ResolutionCount);
+    rangeSelector = new QComboBox();
+    for (const auto &range : displayRanges) rangeSelector->addItem(range.name);
+    connect(rangeSelector, &QComboBox::currentIndexChanged, this, &Spectrograph::setDisplayRange);
+    overlayControls->addWidget(rangeSelector, 0, Qt::AlignRight);
+    displayLowHz = displayRanges[0].lowHz;
+    displayHighHz = displayRanges[0].highHz;
+    pipeline->setDisplayBand(displayLowHz, displayHighHz);
+    slice->setFrequencyRange(displayLowHz, displayHighHz);
+    mainLayout->addLayout(overlayControls);
+
     setLayout(mainLayout);
+
+    samplesBudgetEntry = MemoryBudget::add("decoded samples", [this]() { evictSamples(); });
+    spectrogramBudgetEntry = MemoryBudget::add("spectrogram", [this]() { evictSpectrogram(); });
 }
 
 
 void Spectrograph::loadAudioFile(const QString &fileName) {
     reset(); // Clear curr spect data
     currentAudioFile = fileName; // Set the new audio file
-    processAudioFile(QUrl::fromLocalFile(fileName)); // start processing
+    pipeline->start(fileName, priority); // start processing
+}
+
+void Spectrograph::analysisCacheChecked(const QString &key, bool hit) {
+    // analysed before with the same parameters: restoreAnalyses() follows, nothing needs to be stored
+    analysisKey = hit ? QString() : key;
+    cachedAnalysisKey = hit ? key : QString();
 }
 
+void Spectrograph::samplesReady(const DecodedAudio &audio) {
+    decodedSamples = audio.samples;
+    sourceSampleRate = audio.sourceSampleRate;
+    sampleRate = Resampler::analysisRate;
+    updateSampleBytes();
+    slice->setSamples(decodedSamples, sampleRate);
+    slice->showAt(cursorPosition);
+    emit samplesDecoded();
+}
 
-void Spectrograph::processAudioFile(const QUrl &fileUrl) {
+void Spectrograph::framesReady(const SpectralFrames &frames) {
+    spectrogram = frames.magnitudes;
+    analysedSamples = frames.numSamples;
+    updateSpectrogramBytes();
+    renderToPixmap();
+    emit spectralFramesReady(getSpectralFrames());
+    storeAnalyses();
+}
 
-    if (!decoder) {
-        // init QAudioDecoder for decoding audio buffers
-        decoder = new QAudioDecoder(this);
-        connect(decoder, &QAudioDecoder::bufferReady, this, &Spectrograph::bufferReady);
-        connect(decoder, &QAudioDecoder::finished, this, &Spectrograph::decodingFinished);
-    }
+void Spectrograph::displayFramesReady(const QVector<SpectralFrames> &frames) {
+    bool restored = displayRestoring;
+    displayRestoring = false;
+    if (restored && frames.isEmpty()) return; // still evicted, asked for again by the next render
+    displayFrames = frames;
+    displayFramesEvicted = false;
+    resolutionPixmaps.fill(QPixmap());
+    updateSpectrogramBytes();
+    renderToPixmap();
+}
+
+void Spectrograph::setDisplayRange(int index) {
+    if (index < 0) return;
+    displayLowHz = displayRanges[index].lowHz;
+    displayHighHz = displayRanges[index].highHz;
+    pipeline->setDisplayBand(displayLowHz, displayHighHz);
+    slice->setFrequencyRange(displayLowHz, displayHighHz);
+
+    // the frames of the old range are of no use, the new ones follow from the samples
+    displayFrames.clear();
+    displayFramesEvicted = false;
+    displayRestoring = false;
+    resolutionPixmaps.fill(QPixmap());
+    updateSpectrogramBytes();
+    // evicted samples are decoded inside the display stage, not here
+    if (!decodedSamples.isEmpty() || samplesEvicted) pipeline->updateDisplay(currentAudioFile, decodedSamples);
+    renderToPixmap();
+}
 
-    accumulatedSamples.clear(); // clear any prev samples
-    decoder->setSource(fileUrl); // set decoder src to the new file
-    decoder->start();
+void Spectrograph::pitchReady(const PitchContour &contour) {
+    pitchContour = contour;
+    drawOverlays();
+    storeAnalyses();
 }
 
+void Spectrograph::formantsReady(const FormantTracks &tracks) {
+    formantTracks = tracks;
+    drawOverlays();
+    storeAnalyses();
+}
 
-// once buffer gets going, read data and normalize
-void Spectrograph::bufferReady() {
+void Spectrograph::featuresReady(const MfccFeatures &features) {
+    mfccFeatures = features;
+    emit mfccFeaturesReady(mfccFeatures);
+    storeAnalyses();
+}
 
-    QAudioBuffer buffer = decoder->read();
-    const qint16 *data = buffer.constData<qint16>();
-    int sampleCount = buffer.sampleCount();
 
-    for (int i = 0; i < sampleCount; ++i) {
-        accumulatedSamples.append(static_cast<double>(data[i]) / 32768.0); // Normalize to 16-bit signed integer
-    }
+PitchContour Spectrograph::getPitchContour() const {
+    return pitchContour;
 }
 
+FormantTracks Spectrograph::getFormantTracks() const {
+    return formantTracks;
+}
 
-void Spectrograph::decodingFinished() {
+void Spectrograph::restoreAnalyses(const AnalysisResults &results) {
+    spectrogram = results.frames.magnitudes;
+    analysedSamples = results.frames.numSamples;
+    sampleRate = results.frames.sampleRate;
+    pitchContour = results.pitch;
+    formantTracks = results.formants;
+    mfccFeatures = results.features;
+    analysesFromCache = true;
+    updateSpectrogramBytes();
 
-    // ensure there are samples to process
-    if (accumulatedSamples.isEmpty()) {
-        qWarning() << "No audio samples to process!";
-        return;
+    renderToPixmap();
+    emit spectralFramesReady(getSpectralFrames());
+    emit mfccFeaturesReady(mfccFeatures);
+}
+
+void Spectrograph::storeAnalyses() {
+    // once all analyses of the file are in, written on a worker thread
+    if (analysesFromCache || analysisKey.isEmpty()) return;
+    if (spectrogram.isEmpty() || pitchContour.isEmpty() || formantTracks.isEmpty() || mfccFeatures.isEmpty()) return;
+
+    AnalysisResults results;
+    results.frames = getSpectralFrames();
+    results.pitch = pitchContour;
+    results.formants = formantTracks;
+    results.features = mfccFeatures;
+    QString key = analysisKey;
+    cachedAnalysisKey = key;
+    analysisKey.clear(); // stored once
+    WorkerPool::instance()->start([key, results]() { AnalysisCache::store(key, results); }, WorkerPool::Background);
+}
+
+void Spectrograph::evictSamples() {
+    if (decodedSamples.isEmpty() || pipeline->isRunning() || currentAudioFile.isEmpty()) return;
+    // a compressed file can only be read again through its decoded copy
+    if (PcmCache::isCompressed(currentAudioFile) && PcmCache::cachedFileFor(currentAudioFile).isEmpty()) return;
+
+    decodedSamples = QVector<double>();
+    slice->setSamples(QVector<double>(), 0); // it shares them
+    samplesEvicted = true;
+    updateSampleBytes();
+}
+
+void Spectrograph::ensureSamples() {
+    if (!samplesEvicted || samplesRestoring) return;
+    samplesRestoring = true;
+    pipeline->restoreSamples(currentAudioFile); // the 'PcmCache' copy of a compressed file
+}
+
+void Spectrograph::samplesRestored(const DecodedAudio &audio) {
+    samplesRestoring = false;
+    if (!samplesEvicted || audio.isEmpty()) return; // asked for again the next time they are needed
+    samplesEvicted = false;
+    decodedSamples = audio.samples;
+    slice->setSamples(decodedSamples, sampleRate);
+    updateSampleBytes();
+    emit samplesDecoded(); // the callers of getDecodedSamples() that got nothing ask again
+}
+
+void Spectrograph::evictSpectrogram() {
+    if (!displayFrames.isEmpty()) {
+        // the pixmaps of the drawn resolutions stay
+        displayFrames = QVector<SpectralFrames>();
+        displayFramesEvicted = true;
+        updateSpectrogramBytes();
     }
 
-    // process the accumulated samples into spectrogram chunks
-    QVector<double> windowSamples = accumulatedSamples; // copy all samples
-    setupSpectrograph(windowSamples);
-    accumulatedSamples.clear();
+    if (spectrogram.isEmpty()) return;
+    if (!analysesFromCache && !analysisKey.isEmpty()) return; // storeAnalyses still needs the frames
+
+    spectrogram = QVector<QVector<double>>();
+    spectrogramEvicted = true;
+    updateSpectrogramBytes();
+    emit spectralFramesEvicted();
 }
 
+void Spectrograph::ensureSpectrogram() {
+    if (!spectrogramEvicted || spectrogramRestoring) return;
+    spectrogramRestoring = true;
+    pipeline->restoreFrames(currentAudioFile, cachedAnalysisKey, decodedSamples);
+}
 
-// free mem and destroy plan
-Spectrograph::~Spectrograph() {
-    fftw_destroy_plan(plan);
-    fftw_free(data);
-    fftw_free(fft_result);
-    if (decoder) delete decoder;
+void Spectrograph::framesRestored(const SpectralFrames &frames) {
+    spectrogramRestoring = false;
+    if (!spectrogramEvicted || frames.isEmpty()) return;
+    spectrogramEvicted = false;
+    spectrogram = frames.magnitudes;
+    updateSpectrogramBytes();
+    renderToPixmap();
+    emit spectralFramesReady(getSpectralFrames());
 }
 
+void Spectrograph::ensureDisplayFrames() {
+    if (!displayFramesEvicted || displayRestoring) return;
+    displayRestoring = true;
+    pipeline->updateDisplay(currentAudioFile, decodedSamples); // displayFramesReady() takes them
+}
 
-void Spectrograph::hammingWindow(int windowLength, QVector<double> &window) {
+void Spectrograph::updateSampleBytes() {
+    MemoryBudget::setBytes(samplesBudgetEntry, decodedSamples.size() * (qint64) sizeof(double));
+}
 
-    window.resize(windowLength);  // make sure the vector is the correct size
-    for (int i = 0; i < windowLength; i++) {
-        window[i] = 0.54 - 0.46 * cos(2 * M_PI * i / (windowLength - 1));
+void Spectrograph::updateSpectrogramBytes() {
+    qint64 bytes = 0;
+    for (const QVector<double> &frame : std::as_const(spectrogram)) bytes += frame.size() * (qint64) sizeof(double);
+    for (const SpectralFrames &frames : std::as_const(displayFrames)) {
+        for (const QVector<double> &frame : frames.magnitudes) bytes += frame.size() * (qint64) sizeof(double);
     }
+    MemoryBudget::setBytes(spectrogramBudgetEntry, bytes);
 }
 
+QVector<double> Spectrograph::getDecodedSamples() {
+    ensureSamples(); // evicted ones arrive later, samplesDecoded is emitted again
+    MemoryBudget::touch(samplesBudgetEntry);
+    return decodedSamples;
+}
 
-void Spectrograph::setupSpectrograph(QVector<double> &accumulatedSamples) {
-    graphicsScene->clear();
+void Spectrograph::provideSpectralFrames() {
+    if (spectrogram.isEmpty() && !spectrogramEvicted) return; // nothing computed yet, spectralFramesReady will come
+    if (spectrogramEvicted) {
+        ensureSpectrogram(); // framesRestored() emits spectralFramesReady
+        return;
+    }
+    emit spectralFramesReady(getSpectralFrames());
+}
 
-    // signal length and number of chunks based on hopSize and window size
-    int signalLength = accumulatedSamples.size();
-    int numChunks = (signalLength - windowSize) / hopSize + 1;
+MfccFeatures Spectrograph::getMfccFeatures() const {
+    return mfccFeatures;
+}
 
-    if (numChunks > 0) {
+qint64 Spectrograph::bufferBytes() const {
+    qint64 bytes = decodedSamples.size() * (qint64) sizeof(double);
+    for (const QVector<double> &frame : spectrogram) bytes += frame.size() * (qint64) sizeof(double);
+    for (const SpectralFrames &frames : displayFrames) {
+        for (const QVector<double> &frame : frames.magnitudes) bytes += frame.size() * (qint64) sizeof(double);
+    }
+    bytes += pitchContour.f0.size() * (qint64) sizeof(double);
+    bytes += formantTracks.frequencies.size() * (qint64) sizeof(float);
+    bytes += (mfccFeatures.mfcc.size() + mfccFeatures.logMel.size()) * (qint64) sizeof(float);
+    return bytes;
+}
 
-        // resize spectrogram to accommodate new chunks
-        spectrogram.resize(spectrogram.size() + numChunks, QVector<double>(windowSize/ 2));
 
-        // process each chunk
-        for (int chunk = 0; chunk < numChunks; ++chunk) {
-            int chunkPosition = chunk * hopSize;
+Spectrograph::~Spectrograph() {
+    pipeline->cancel();
+    MemoryBudget::remove(samplesBudgetEntry);
+    MemoryBudget::remove(spectrogramBudgetEntry);
+}
 
-            // apply the hamming window and prepare data for FFT
-            for (int i = 0; i < windowSize; ++i) {
-                int readIndex = chunkPosition + i;
 
-                // ensure we dont go out of bounds for accum samples
-                data[i][0] = (readIndex < accumulatedSamples.size()) ? accumulatedSamples[readIndex] * hammingWindowValues[i] : 0.0;
-                data[i][1] = 0.0;  // imaginary part is zero
-            }
+void Spectrograph::hammingWindow(int windowLength, QVector<double> &window) {
+    Stft::hammingWindow(windowLength, window);
+}
 
-            // execute FFT
-            fftw_execute(plan);
 
-            // store amplitudes in spectrograph
-            for (int i=0; i < windowSize/2; ++i) {
-                //what is displayed from fft
-                double real = fft_result[i][0];
-                double imag = fft_result[i][1];
+void Spectrograph::setupSpectrograph(QVector<double> &accumulatedSamples) {
+    TRACE_SCOPE("Spectrograph::setupSpectrograph");
+    clearScene();
 
-                // used this https://cplusplus.com/forum/beginner/251061/ and adjusted a tiny bit
-                double amplitude = 2 * std::sqrt(real * real + imag * imag);
-                // store amp to represent intensity for visualizing the spectrogram
-                spectrogram[spectrogram.size() - numChunks + chunk][i] = amplitude;
-            }
-        }
-    }
+    // the transform itself lives in 'Stft' so it can run without widgets
+    spectrogram += stft->compute(accumulatedSamples, sampleRate).magnitudes;
+    analysedSamples += accumulatedSamples.size();
+    updateSpectrogramBytes();
     renderToPixmap();
+    emit spectralFramesReady(getSpectralFrames());
+}
+
+SpectralFrames Spectrograph::getSpectralFrames() {
+    ensureSpectrogram(); // empty until evicted frames are back, spectralFramesReady follows
+    MemoryBudget::touch(spectrogramBudgetEntry);
+    SpectralFrames frames;
+    frames.magnitudes = spectrogram;
+    frames.windowSize = windowSize;
+    frames.hopSize = hopSize;
+    frames.sampleRate = sampleRate;
+    frames.numSamples = analysedSamples;
+    return frames;
 }
 
 
 void Spectrograph::renderToPixmap() {
-    if (spectrogram.isEmpty())
-        return;
+    TRACE_SCOPE("Spectrograph::renderToPixmap");
+    int resolution = resolutionSelector->currentIndex();
+    QPixmap &drawn = resolutionPixmaps[resolution];
+    QSize view = graphicsView->size(); // not the widget's, the slice and the controls share it
+    if (!drawn.isNull() && drawn.size() == view) {
+        cachedSpect = drawn; // flipped back to a resolution that was drawn already
+    } else {
+        ensureDisplayFrames(); // only queued, nothing is decoded or transformed here
+        bool display = resolution < displayFrames.size() && !displayFrames[resolution].isEmpty();
+        QImage image;
+        if (display) {
+            image = SpectrogramRenderer::render(displayFrames[resolution], displayLowHz, displayHighHz, view.width(), view.height());
+        } else if (!spectrogram.isEmpty() || spectrogramEvicted) {
+            // the display frames are not in yet (or never computed, as in the benchmarks)
+            SpectralFrames frames = getSpectralFrames();
+            if (!frames.isEmpty()) image = SpectrogramRenderer::render(frames, displayLowHz, displayHighHz, view.width(), view.height());
+        }
+        if (image.isNull())
+            return; // the last pixmap stays until the frames arrive, they render again
 
-    QImage image(width(), height(), QImage::Format_RGB32);
-    image.fill(Qt::black); // base color
+        // cache the rendered image as a pixmap
+        cachedSpect = QPixmap::fromImage(image);
+        if (display) drawn = cachedSpect;
+    }
+    clearScene();
+    graphicsScene->addPixmap(cachedSpect);
+    drawOverlays();
+    drawCursor();
+}
+
+void Spectrograph::clearScene() {
+    graphicsScene->clear(); // deletes the overlay items too
+    pitchItem = nullptr;
+    formantItem = nullptr;
+    cursorItem = nullptr;
+    selectionItem = nullptr;
+}
 
-    QPainter painter(&image);
-    painter.setRenderHint(QPainter::Antialiasing, true);
+void Spectrograph::drawCursor() {
+    if (cachedSpect.isNull()) return;
+    if (!selectionItem) {
+        selectionItem = graphicsScene->addRect(QRectF(), Qt::NoPen, QBrush(QColor(255, 255, 255, 60)));
+        selectionItem->setZValue(CURSOR_Z_VALUE);
+    }
+    if (!cursorItem) {
+        cursorItem = graphicsScene->addLine(QLineF(0, 0, 0, cachedSpect.height() - 1), QPen(Qt::white, 1));
+        cursorItem->setZValue(CURSOR_Z_VALUE);
+    }
+    setSelection(selectionStart, selectionEnd);
+    setCursorPosition(cursorPosition);
+}
 
-    // determine dimensions for each chunk and frequency
-    int numChunks = spectrogram.size();
-    int numFrequencies = windowSize / 2;
-    double chunkWidth = static_cast<double>(width()) / (numChunks);
-    double freqHeight = static_cast<double>(height()) / (numFrequencies/105); // cut in half again bc fftw is mirrored
+void Spectrograph::setCursorPosition(double position) {
+    cursorPosition = std::clamp(position, 0.0, 1.0);
+    if (cursorItem) cursorItem->setPos(cursorPosition * cachedSpect.width(), 0); // moved, not drawn again
+    if (!hovering) slice->showAt(cursorPosition);
+}
 
-    // Find the maximum amplitude for normalization
-    double maxAmp = 0.0;
-    for (const auto &row : spectrogram) {
-        for (double amplitude : row) {
-            maxAmp = std::max(maxAmp, amplitude);
+bool Spectrograph::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == graphicsView->viewport() && !cachedSpect.isNull()) {
+        if (event->type() == QEvent::MouseMove) {
+            hovering = true;
+            QPointF scenePosition = graphicsView->mapToScene(static_cast<QMouseEvent *>(event)->position().toPoint());
+            slice->showAt(scenePosition.x() / cachedSpect.width());
+        } else if (event->type() == QEvent::Leave) {
+            hovering = false;
+            slice->showAt(cursorPosition); // back to the playback cursor
         }
     }
+    return QWidget::eventFilter(watched, event);
+}
 
-    if (maxAmp == 0.0) return;
-
-    // render the spectrogram data
-    for (int chunk = 0; chunk < numChunks; ++chunk) {
-        for (int freq = 0; freq < numFrequencies; ++freq) {
-            double amplitude = spectrogram[chunk][freq];
-            int intensity = static_cast<int>((amplitude / maxAmp) * 255.0);
-
-            // ensure intensity stays within 255
-            intensity = std::clamp(intensity, 0, 255);
-
-            QColor color;
-            if (intensity <= 127) {
-                // map from black (quietest amp) to red (middle amp)
-                int red = std::clamp(intensity * 2, 0, 255);
-                color.setRgb(red, 0, 0); // Only red increases
-            } else {
-                // map from red (middle) to yellow (loudest amp)
-                int green = std::clamp((intensity - 127) * 2, 0, 255);
-                color.setRgb(255, green, 0); // Red stays max, green increases, blue stays 0
-            }
+void Spectrograph::setSelection(double startProportion, double endProportion) {
+    selectionStart = startProportion;
+    selectionEnd = endProportion;
+    if (!selectionItem) return;
+
+    double w = cachedSpect.width();
+    double h = cachedSpect.height();
+    selectionItem->setVisible(selectionStart >= 0.0);
+    if (selectionStart < 0.0) return;
+    if (selectionEnd < 0.0) selectionItem->setRect(selectionStart * w - 1, 0, 2, h); // only the start line is placed
+    else selectionItem->setRect(selectionStart * w, 0, (selectionEnd - selectionStart) * w, h);
+}
 
-            QRectF rect(chunk * chunkWidth, height() - (freq + 1) * freqHeight, chunkWidth, freqHeight);
-            painter.fillRect(rect, color);
+void Spectrograph::drawOverlays() {
+    if (pitchItem) {
+        graphicsScene->removeItem(pitchItem);
+        delete pitchItem;
+        pitchItem = nullptr;
+    }
+    if (formantItem) {
+        graphicsScene->removeItem(formantItem);
+        delete formantItem;
+        formantItem = nullptr;
+    }
+    if (cachedSpect.isNull()) return;
+
+    double w = cachedSpect.width();
+    double h = cachedSpect.height();
+    double lowHz = displayLowHz;
+    double highHz = displayHighHz > 0.0 ? displayHighHz : sampleRate / 2.0;
+
+    // formants first so the pitch contour stays on top, all dots are one path so it is a single item
+    if (showFormantsCheckbox->isChecked() && !formantTracks.isEmpty()) {
+        QPainterPath dots;
+        for (int frame = 0; frame < formantTracks.frameCount(); ++frame) {
+            double x = formantTracks.frameToProportion(frame) * w;
+            for (int formant = 0; formant < FormantTracks::formantCount; ++formant) {
+                double frequency = formantTracks.formant(frame, formant);
+                if (frequency <= 0.0 || frequency < lowHz || frequency > highHz) continue;
+                dots.addRect(x - 1, h - (frequency - lowHz) / (highHz - lowHz) * h - 1, 2, 2);
+            }
         }
+        formantItem = graphicsScene->addPath(dots, Qt::NoPen, QBrush(QColor(255, 80, 200)));
     }
-    painter.end();
 
-    // cache the rendered image as a pixmap
-    cachedSpect = QPixmap::fromImage(image);
-    graphicsScene->clear();
-    graphicsScene->addPixmap(cachedSpect);
+    if (!showPitchCheckbox->isChecked() || pitchContour.isEmpty()) return;
+
+    QPainterPath path;
+    bool voiced = false; // unvoiced frames break the line
+    for (int frame = 0; frame < pitchContour.f0.size(); ++frame) {
+        double f0 = pitchContour.f0[frame];
+        if (f0 <= 0.0) {
+            voiced = false;
+            continue;
+        }
+        double scaled = (std::clamp(f0, PITCH_DISPLAY_MIN_HZ, PITCH_DISPLAY_MAX_HZ) - PITCH_DISPLAY_MIN_HZ) / (PITCH_DISPLAY_MAX_HZ - PITCH_DISPLAY_MIN_HZ);
+        QPointF point(pitchContour.frameToProportion(frame) * w, h - scaled * h);
+        if (voiced) path.lineTo(point);
+        else path.moveTo(point);
+        voiced = true;
+    }
+    pitchItem = graphicsScene->addPath(path, QPen(Qt::cyan, 2));
 }
 
 void Spectrograph::reset() {
-    if (decoder) {
-        decoder->stop();
-        delete decoder;
-        decoder = nullptr;
-    }
+    pipeline->cancel(); // nothing of the file before is delivered any more
 
     spectrogram.clear();
-    accumulatedSamples.clear();
+    displayFrames.clear();
+    displayFramesEvicted = false;
+    resolutionPixmaps.fill(QPixmap());
+    decodedSamples.clear();
+    slice->setSamples(QVector<double>(), 0);
+    analysisKey.clear();
+    cachedAnalysisKey.clear();
+    analysesFromCache = false;
+    samplesEvicted = false;
+    spectrogramEvicted = false;
+    samplesRestoring = false;
+    spectrogramRestoring = false;
+    displayRestoring = false;
+    sourceSampleRate = 0;
+    analysedSamples = 0;
+    pitchContour = PitchContour();
+    formantTracks = FormantTracks();
+    mfccFeatures = MfccFeatures();
+    updateSampleBytes();
+    updateSpectrogramBytes();
+    drawOverlays();
+    setCursorPosition(0.0);
+    setSelection(-1.0, -1.0);
     update();
 }
@@ -1,17 +1,25 @@
 #ifndef SPECTROGRAPH_H
 #define SPECTROGRAPH_H
 
-#include <QtMultimedia/qaudiobuffer.h>
-#include <QtMultimedia/qaudiooutput.h>
-#include <QtMultimedia/qmediaplayer.h>
 #include <QtWidgets>
-#include <QAudioSource>
 #include <QIODevice>
 #include <QImage>
 #include <fftw3.h>
 #include <QGraphicsScene>
 #include <QGraphicsView>
-#include <QAudioDecoder>
+#include <memory>
+#include "spectralframes.h"
+#include "pitchtracker.h"
+#include "formanttracker.h"
+#include "mfccextractor.h"
+#include "stft.h"
+#include "resampler.h"
+#include "analysiscache.h"
+#include "workerpool.h"
+#include "memorybudget.h"
+#include "analysispipeline.h"
+#include "multiresolutionstft.h"
+#include "spectralslice.h"
 
 
 /* File: spectrograph.h
@@ -22,19 +30,78 @@
  *  - Creates a visual representation (spectrogram) from audio data
  *
  * Key Features:
- *  - Displays a spectrogram of audio data
+ *  - Displays a spectrogram of audio data, wideband (5 ms window) or narrowband (30 ms window), both computed in one pass
+ *    by 'MultiResolutionStft' so the selector flips between them without recomputing
  *  - Provides functionality for enabling / disabling peak amplitude visualization
- *  - Includes audio decoding and FFT transformation using FFTW library
+ *  - Decodes and analyses the file with an 'AnalysisPipeline', a task graph on the 'WorkerPool' that is cancelled when
+ *    the next file is loaded, so nothing of it runs on the GUI thread
+ *  - Tracks the pitch (F0) of the decoded audio with 'PitchTracker' and draws the contour over the spectrogram
+ *  - Tracks the formants (F1-F3) with 'FormantTracker' and draws them as dots over the spectrogram
+ *  - Shows the playback cursor and the segment selected on the waveform over the spectrogram, moving items over the
+ *    cached pixmap instead of rendering it again
+ *  - Shows the spectrum (and the LPC envelope) of the instant under the mouse, or at the playback cursor, in a
+ *    'SpectralSlice' next to the spectrogram. Evicted samples are not decoded again for it, the slice stays empty
+ *  - Shows a selectable frequency range, only that range is computed ('MultiResolutionStft' zoom FFT)
+ *  - Extracts MFCC and log-mel features from the STFT frames with 'MfccExtractor' and keeps them for the loaded track
+ *  - Resamples every file to 'Resampler::analysisRate' when it is decoded, so the bins and frames of both tracks mean the
+ *    same frequencies and durations
  *
  * Key Methods:
  *  - 'void setupSpectograph(QVector<double> &accumulatedSamples)': Prepares the spectogram using FFT for an audio segment
- *  - 'void renderToPixmap': Creates spectogram visualization using QPixmap
- *  - 'void hammingWindow(int windowLength, QVector<double> &window)': Applies hamming window to smooth audio data
+ *  - 'void renderToPixmap': Creates spectogram visualization using QPixmap, of the selected display resolution once its
+ *    frames are in and of the analysis frames until then
+ *  - 'static void hammingWindow(int windowLength, QVector<double> &window)': Computes the hamming window used to smooth audio data,
+ *    also used for the frames of the 'FormantTracker'
+ *  - 'SpectralFrames getSpectralFrames()': Returns the STFT frames with the window, hop and sample rate used. If the
+ *    'MemoryBudget' evicted them they are empty, their restore is queued and spectralFramesReady follows
+ *  - 'PitchContour getPitchContour() const': Returns the cached pitch contour of the loaded track
+ *  - 'FormantTracks getFormantTracks() const': Returns the cached formant tracks of the loaded track
+ *  - 'QVector<double> getDecodedSamples()', 'int getSampleRate() const': The decoded mono samples at the analysis rate
+ *    and that rate. Evicted samples are empty, they are decoded again on the pool and samplesDecoded is emitted again
+ *  - 'int getSourceSampleRate() const': Sample rate of the file itself
+ *  - 'void setSampleRate(int rate)': Rate of samples passed to setupSpectrograph without the pipeline (benchmarks)
+ *  - 'MfccFeatures getMfccFeatures() const': Returns the cached MFCC features of the loaded track
+ *  - 'qint64 bufferBytes() const': Bytes held by the samples, the spectrogram and the analyses, for the performance HUD
+ *  - 'void clearScene()': Clears the scene and forgets the overlay items it deleted
+ *  - 'void drawCursor()': Adds the playback cursor and the selection band on top of the pixmap and the overlays, they
+ *    are only moved afterwards
+ *  - 'void restoreAnalyses(const AnalysisResults &results)': Shows the spectrogram and analyses read from the cache
+ *  - 'void storeAnalyses()': Writes the analyses to the 'AnalysisCache' once the last of them finished
+ *  - 'void evictSamples()', 'void evictSpectrogram()': 'MemoryBudget' evictors, they decline while the data cannot be
+ *    rebuilt (analyses that are still running or not in the 'AnalysisCache' yet)
+ *  - 'void ensureSamples()', 'void ensureSpectrogram()', 'void ensureDisplayFrames()': Queue the rebuild of evicted
+ *    data as a stage of the 'AnalysisPipeline' and return at once, the evicted flag stays set until the result is in.
+ *    The spectrogram comes from the 'AnalysisCache' or the STFT, the display frames are only needed for a resolution
+ *    that was never drawn (drawn ones keep their pixmap). Nothing is decoded or transformed on the GUI thread, a paint
+ *    shows the last pixmap until the data arrives
+ *  - 'void setPriority(int priority)', 'int getPriority() const': 'WorkerPool' priority of the pipeline of this track,
+ *    set by the 'Workspace' as the track scrolls in and out of view. Stages that are queued already keep theirs
  *
  * Slots:
- *  - 'void bufferReady()': Processes ready audio buffers by decoding into sample data
- *  - 'void loadAudioFile(const QString &fileName)': initilizes processing
- *  - 'void processAudioFile(const QUrl &fileUrl)' : takes in fileUrl to sample values and prepares them for FFT by calling bufferReady and finish signals on QAudioDecoder
+ *  - 'void loadAudioFile(const QString &fileName)': initilizes processing, starts the pipeline of the file
+ *  - 'void drawOverlays()': draws the pitch contour and formants over the cached spectrogram pixmap if they are enabled
+ *  - 'void displayFramesReady(const QVector<SpectralFrames> &frames)': keeps the frames of both display resolutions and
+ *    draws the selected one
+ *  - 'void setDisplayRange(int index)': computes the display frames of another frequency range and draws them
+ *  - 'void setCursorPosition(double position)': moves the playback cursor, a proportion of the track like the scrubber
+ *    of the 'WavForm' it follows
+ *  - 'void setSelection(double startProportion, double endProportion)': shows the segment selected on the waveform as
+ *    a band, -1 for a segment line that is not placed
+ *  - 'void analysisCacheChecked(const QString &key, bool hit)', 'void samplesReady(const DecodedAudio &audio)',
+ *    'void framesReady(const SpectralFrames &frames)', 'void pitchReady(const PitchContour &contour)',
+ *    'void formantsReady(const FormantTracks &tracks)', 'void featuresReady(const MfccFeatures &features)': keep what a
+ *    stage of the pipeline delivered, show or announce it and store the analyses once the last of them is in
+ *  - 'void samplesRestored(const DecodedAudio &audio)', 'void framesRestored(const SpectralFrames &frames)': take evicted
+ *    data back from the pipeline, render again and announce it like the first time
+ *  - 'void provideSpectralFrames()': emits spectralFramesReady again, once the frames are restored if they were evicted
+ *
+ * Signals:
+ *  - 'void spectralFramesReady(SpectralFrames frames)': emitted once the spectrogram of a file is computed so other analyses can reuse the frames
+ *  - 'void mfccFeaturesReady(MfccFeatures features)': emitted once the features of a file are extracted
+ *  - 'void samplesDecoded()': emitted once the whole file is decoded, before the analyses of it are done, and again
+ *    when evicted samples were decoded back
+ *  - 'void spectralFramesEvicted()': the frames were evicted, holders of the frames of spectralFramesReady should drop
+ *    them too so the memory is actually freed
  *
  * */
 
@@ -49,9 +116,24 @@ public:
     // configures the spectrogram visualization
     void setupSpectrograph(QVector<double> &accumulatedSamples);
     int getWindowSize() const { return windowSize; }
+    SpectralFrames getSpectralFrames();
+    PitchContour getPitchContour() const;
+    FormantTracks getFormantTracks() const;
+    MfccFeatures getMfccFeatures() const;
+    qint64 bufferBytes() const;
+    QVector<double> getDecodedSamples();
+    int getSampleRate() const { return sampleRate; }
+    int getSourceSampleRate() const { return sourceSampleRate; }
+    void setSampleRate(int rate) { sampleRate = rate; }
+    void setPriority(int _priority) { priority = _priority; }
+    int getPriority() const { return priority; }
     void reset();
+    static void hammingWindow(int windowLength, QVector<double> &window);
     QPixmap cachedSpect;
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private:
     QGraphicsView *graphicsView; // display the scene
     QGraphicsScene *graphicsScene;
@@ -59,36 +141,103 @@ private:
     QString currentAudioFile; // storing file
 
     // audio processing
-    QAudioDecoder *decoder = nullptr;
-    QVector<double> accumulatedSamples;
-
-    QMediaPlayer *player;
-    QAudioOutput *audioOutput;
+    AnalysisPipeline *pipeline;
+    QVector<double> decodedSamples; // mono samples of the loaded file at the analysis rate, kept for the analyses
 
     // FFT and spectrogram
-    fftw_complex *in;
-    fftw_complex *out;
-    fftw_plan plan;
-    fftw_complex *data, *fft_result;
+    std::unique_ptr<Stft> stft;
     QVector<QVector<double>> spectrogram; // 2D matrix for spectrogram
-    QVector<double> hammingWindowValues;
+    QVector<SpectralFrames> displayFrames; // indexed by MultiResolutionStft::Resolution
+    QVector<QPixmap> resolutionPixmaps; // drawn display resolutions, flipping back to one shows it as it is
+    bool displayFramesEvicted = false;
 
     // parameters
-    double maxAmp = 0.0;
     int hopSize;
     int windowSize = 1024;
+    int sampleRate = 0;
+    int sourceSampleRate = 0;
+    qint64 analysedSamples = 0;
+    int priority = WorkerPool::Visible;
+
+    // analysis cache
+    QString analysisKey; // of the loaded file, cleared once its analyses are stored
+    QString cachedAnalysisKey; // entry holding the analyses of the loaded file, once there is one
+    bool analysesFromCache = false;
+
+    // memory budget
+    int samplesBudgetEntry;
+    int spectrogramBudgetEntry;
+    bool samplesEvicted = false;
+    bool spectrogramEvicted = false;
+    bool samplesRestoring = false; // a rebuild is queued, not asked for twice
+    bool spectrogramRestoring = false;
+    bool displayRestoring = false;
+
+    // analyses
+    PitchContour pitchContour;
+    FormantTracks formantTracks;
+    MfccFeatures mfccFeatures;
+
+    // overlays
+    QCheckBox *showPitchCheckbox;
+    QCheckBox *showFormantsCheckbox;
+    QComboBox *resolutionSelector;
+    QComboBox *rangeSelector;
+    double displayLowHz = 0.0;
+    double displayHighHz = 0.0; // 0 is the whole band
+    QGraphicsPathItem *pitchItem = nullptr;
+    QGraphicsPathItem *formantItem = nullptr;
+
+    // playback cursor and selection, proportions of the track
+    double cursorPosition = 0.0;
+    double selectionStart = -1.0;
+    double selectionEnd = -1.0;
+    QGraphicsLineItem *cursorItem = nullptr;
+    QGraphicsRectItem *selectionItem = nullptr;
+
+    // spectral slice, at the mouse while it is over the spectrogram
+    SpectralSlice *slice;
+    QCheckBox *showEnvelopeCheckbox;
+    bool hovering = false;
 
     // helper method
-    void hammingWindow(int windowLength, QVector<double> &window);
+    void clearScene();
+    void drawCursor();
+    void restoreAnalyses(const AnalysisResults &results);
+    void storeAnalyses();
+    void evictSamples();
+    void evictSpectrogram();
+    void ensureSamples();
+    void ensureSpectrogram();
+    void ensureDisplayFrames();
+    void updateSampleBytes();
+    void updateSpectrogramBytes();
 
 public slots:
-    void bufferReady();
-    void processAudioFile(const QUrl &fileUrl);
     void loadAudioFile(const QString &fileName);
     void renderToPixmap();
+    void drawOverlays();
+    void provideSpectralFrames();
+    void setCursorPosition(double position);
+    void setSelection(double startProportion, double endProportion);
 
 private slots:
-    void decodingFinished();
+    void analysisCacheChecked(const QString &key, bool hit);
+    void samplesReady(const DecodedAudio &audio);
+    void framesReady(const SpectralFrames &frames);
+    void displayFramesReady(const QVector<SpectralFrames> &frames);
+    void setDisplayRange(int index);
+    void pitchReady(const PitchContour &contour);
+    void formantsReady(const FormantTracks &tracks);
+    void featuresReady(const MfccFeatures &features);
+    void samplesRestored(const DecodedAudio &audio);
+    void framesRestored(const SpectralFrames &frames);
+
+signals:
+    void spectralFramesReady(SpectralFrames frames);
+    void mfccFeaturesReady(MfccFeatures features);
+    void samplesDecoded();
+    void spectralFramesEvicted();
 };
 
 
@@ -0,0 +1,82 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <QtGlobal>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+/*
+ * File: spscringbuffer.h
+ * Description:
+ *  This header file defines the 'SpscRingBuffer' template, a lock-free ring buffer for exactly one producer thread and
+ *  one consumer thread. The live recording uses it to hand the microphone samples from the capture thread to the
+ *  analysis thread, the capture thread never waits for anyone.
+ *
+ * Public Methods:
+ *  - 'SpscRingBuffer(qsizetype minimumCapacity)': Capacity is rounded up to a power of two
+ *  - 'qsizetype write(const T *data, qsizetype count)': Producer only, copies what fits and returns how much that was
+ *  - 'qsizetype read(T *data, qsizetype count)': Consumer only, copies up to count items out and returns how many
+ *  - 'qsizetype readAvailable() const': Items waiting, exact for the consumer, a lower bound for anybody else
+ *
+ * Notes:
+ *  - The indices only grow, the slot is index & mask. The producer publishes its index with release after copying,
+ *    the consumer reads it with acquire before copying (and the same the other way round), so no item is read before
+ *    it is written or overwritten before it is read.
+ *  - The two indices sit on their own cache lines so the threads do not invalidate each other's line on every item.
+ */
+
+template<typename T>
+class SpscRingBuffer
+{
+    qsizetype capacityMask;
+    std::unique_ptr<T[]> items;
+    alignas(64) std::atomic<qint64> writeIndex{0};
+    alignas(64) std::atomic<qint64> readIndex{0};
+
+public:
+    explicit SpscRingBuffer(qsizetype minimumCapacity) {
+        qsizetype capacity = 1;
+        while (capacity < minimumCapacity) capacity <<= 1;
+        capacityMask = capacity - 1;
+        items.reset(new T[capacity]);
+    }
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    qsizetype capacity() const { return capacityMask + 1; }
+
+    qsizetype readAvailable() const {
+        return (qsizetype) (writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_relaxed));
+    }
+
+    qsizetype write(const T *data, qsizetype count) {
+        qint64 write = writeIndex.load(std::memory_order_relaxed);
+        qint64 read = readIndex.load(std::memory_order_acquire);
+        count = std::min<qsizetype>(count, capacity() - (qsizetype) (write - read));
+        if (count <= 0) return 0;
+
+        qsizetype start = (qsizetype) (write & capacityMask);
+        qsizetype first = std::min(count, capacity() - start); // up to the end of the array, the rest wraps around
+        std::copy(data, data + first, items.get() + start);
+        std::copy(data + first, data + count, items.get());
+        writeIndex.store(write + count, std::memory_order_release);
+        return count;
+    }
+
+    qsizetype read(T *data, qsizetype count) {
+        qint64 read = readIndex.load(std::memory_order_relaxed);
+        qint64 write = writeIndex.load(std::memory_order_acquire);
+        count = std::min<qsizetype>(count, (qsizetype) (write - read));
+        if (count <= 0) return 0;
+
+        qsizetype start = (qsizetype) (read & capacityMask);
+        qsizetype first = std::min(count, capacity() - start);
+        std::copy(items.get() + start, items.get() + start + first, data);
+        std::copy(items.get(), items.get() + (count - first), data + first);
+        readIndex.store(read + count, std::memory_order_release);
+        return count;
+    }
+};
+
+#endif // SPSCRINGBUFFER_H
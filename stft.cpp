@@ -0,0 +1,86 @@
+#include "stft.h"
+#include "tracer.h"
+#include <cmath>
+
+/*
+ * File: stft.cpp
+ * Description:
+ *  This source file implements the 'Stft'. Every frame is multiplied by the hamming window, transformed with FFTW and
+ *  the amplitude 2 * |X(k)| of the lower windowSize / 2 bins is kept (the upper half mirrors it for real input).
+ *
+ * References:
+ *  - https://ofdsp.blogspot.com/2011/08/short-time-fourier-transform-with-fftw3.html
+ *  - https://cplusplus.com/forum/beginner/251061/
+ *  - https://www.fftw.org/fftw3_doc/Thread-safety.html
+ */
+
+QMutex &Stft::plannerLock() {
+    static QMutex plannerMutex;
+    return plannerMutex;
+}
+
+Stft::Stft(int _windowSize, int _hopSize)
+    : windowSize(std::max(_windowSize, 2)), hopSize(std::max(_hopSize, 1))
+{
+    data = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * windowSize);
+    fftResult = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * windowSize);
+    {
+        QMutexLocker locker(&plannerLock());
+        plan = fftw_plan_dft_1d(windowSize, data, fftResult, FFTW_FORWARD, FFTW_ESTIMATE);
+    }
+    hammingWindow(windowSize, window);
+}
+
+Stft::~Stft() {
+    {
+        QMutexLocker locker(&plannerLock());
+        fftw_destroy_plan(plan);
+    }
+    fftw_free(data);
+    fftw_free(fftResult);
+}
+
+void Stft::hammingWindow(int windowLength, QVector<double> &window) {
+    window.resize(windowLength);  // make sure the vector is the correct size
+    for (int i = 0; i < windowLength; i++) {
+        window[i] = 0.54 - 0.46 * cos(2 * M_PI * i / (windowLength - 1));
+    }
+}
+
+SpectralFrames Stft::compute(const QVector<double> &samples, int sampleRate) {
+    TRACE_SCOPE("Stft::compute");
+    SpectralFrames frames;
+    frames.windowSize = windowSize;
+    frames.hopSize = hopSize;
+    frames.sampleRate = sampleRate;
+    frames.numSamples = samples.size();
+
+    // signal length and number of chunks based on hopSize and window size
+    int signalLength = samples.size();
+    int numChunks = (signalLength - windowSize) / hopSize + 1;
+    if (signalLength < windowSize || numChunks <= 0) return frames;
+
+    frames.magnitudes.resize(numChunks, QVector<double>(windowSize / 2));
+    const double *input = samples.constData();
+    for (int chunk = 0; chunk < numChunks; ++chunk) {
+        computeFrame(input + chunk * hopSize, frames.magnitudes[chunk].data());
+    }
+    return frames;
+}
+
+void Stft::computeFrame(const double *frame, double *amplitudes) {
+    // apply the hamming window and prepare data for FFT
+    for (int i = 0; i < windowSize; ++i) {
+        data[i][0] = frame[i] * window[i];
+        data[i][1] = 0.0;  // imaginary part is zero
+    }
+
+    fftw_execute(plan);
+
+    // store amplitudes, the intensity of the spectrogram
+    for (int i = 0; i < windowSize / 2; ++i) {
+        double real = fftResult[i][0];
+        double imag = fftResult[i][1];
+        amplitudes[i] = 2 * std::sqrt(real * real + imag * imag);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef STFT_H
+#define STFT_H
+
+#include <QVector>
+#include <QMutex>
+#include <fftw3.h>
+#include "spectralframes.h"
+
+/*
+ * File: stft.h
+ * Description:
+ *  This header file defines the 'Stft' class, the short-time Fourier transform behind the 'Spectrograph'. It has no
+ *  widget dependencies so the same transform can run in the batch tool and the benchmarks.
+ *
+ * Key Members:
+ *  - 'int windowSize, hopSize': Samples per frame and between the starts of two frames
+ *  - 'fftw_complex *data, *fftResult', 'fftw_plan plan': FFT buffers and plan, owned by one object so an 'Stft' is used
+ *    by one thread at a time
+ *  - 'QVector<double> window': Hamming window of windowSize samples
+ *
+ * Public Methods:
+ *  - 'Stft(int windowSize, int hopSize)': Creates the plan and the window
+ *  - 'SpectralFrames compute(const QVector<double> &samples, int sampleRate)': Amplitudes of every frame
+ *  - 'void computeFrame(const double *frame, double *amplitudes)': Amplitudes of the windowSize samples at frame, written
+ *    to windowSize / 2 values. Allocates nothing, for the 'SpectralSlice' that transforms one frame per repaint
+ *  - 'static void hammingWindow(int windowLength, QVector<double> &window)': Computes a hamming window
+ *  - 'static QMutex &plannerLock()': The lock around FFTW's planner, for other classes that make plans off the GUI thread
+ *
+ * Notes:
+ *  - FFTW's planner is not thread safe, plans are created and destroyed under a lock shared by all 'Stft' objects so
+ *    several of them can be built on worker threads at once.
+ */
+
+class Stft
+{
+    int windowSize;
+    int hopSize;
+    fftw_complex *data;
+    fftw_complex *fftResult;
+    fftw_plan plan;
+    QVector<double> window;
+
+public:
+    Stft(int windowSize, int hopSize);
+    ~Stft();
+    Stft(const Stft &) = delete;
+    Stft &operator=(const Stft &) = delete;
+
+    int getWindowSize() const { return windowSize; }
+    int getHopSize() const { return hopSize; }
+    SpectralFrames compute(const QVector<double> &samples, int sampleRate);
+    void computeFrame(const double *frame, double *amplitudes);
+    static void hammingWindow(int windowLength, QVector<double> &window);
+    static QMutex &plannerLock();
+};
+
+#endif // STFT_H
@@ -0,0 +1,193 @@
+#include "syllablesegmenter.h"
+#include <QtConcurrent>
+#include "tracer.h"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+/*
+ * File: syllablesegmenter.cpp
+ * Description:
+ *  This source file implements the 'SyllableSegmenter'. Every frame of the selection gets three features computed from
+ *  its FFT amplitudes: short-time energy, spectral flux (how much the spectrum rose since the previous frame) and voicing
+ *  (share of the energy between VOICING_LOW_HZ and VOICING_HIGH_HZ, where voiced speech has most of its energy).
+ *
+ * Key Methods:
+ *  - 'frameFeatures()': Computes the features with QtConcurrent::blockingMap, frames are independent so each one is a task
+ *  - 'findBoundaries()':
+ *      1. smooths the energy over 3 frames and finds the silence threshold from the loudest frame and the noise floor
+ *         (10th percentile of the energy)
+ *      2. finds nuclei: voiced, non silent local maxima of the energy, two nuclei closer than MIN_SYLLABLE_SECONDS or
+ *         without a dip of NUCLEUS_DIP_DB between them are merged into the louder one
+ *      3. between two nuclei the boundary is put at the edges of a silence if there is one, otherwise at the lowest
+ *         energy frame, moved forward to the strongest onset (spectral flux) within ONSET_SEARCH_SECONDS
+ *      4. silence before the first and after the last nucleus is split off as its own segment
+ *
+ * Notes:
+ *  - Works on the spectrogram's frames (1024 samples, no overlap), around 23 ms at 44.1 kHz, which is fine grained
+ *    enough for syllables that last 100 ms and more.
+ *
+ * References:
+ *  - Mermelstein, P. (1975). Automatic segmentation of speech into syllabic units.
+ */
+
+#define VOICING_LOW_HZ 80.0
+#define VOICING_HIGH_HZ 1000.0
+#define VOICED_THRESHOLD 0.4
+#define SILENCE_RANGE_DB 35.0
+#define SILENCE_FLOOR_MARGIN_DB 6.0
+#define NUCLEUS_DIP_DB 3.0
+#define MIN_SYLLABLE_SECONDS 0.08
+#define ONSET_SEARCH_SECONDS 0.05
+
+QVector<SyllableSegmenter::FrameFeatures> SyllableSegmenter::frameFeatures(const SpectralFrames &frames, int firstFrame, int lastFrame) {
+    int count = lastFrame - firstFrame;
+    QVector<FrameFeatures> features(std::max(count, 0));
+    if (count <= 0 || frames.sampleRate <= 0) return features;
+
+    int bins = frames.windowSize / 2;
+    int lowBin = std::clamp(int(VOICING_LOW_HZ * frames.windowSize / frames.sampleRate), 1, bins);
+    int highBin = std::clamp(int(VOICING_HIGH_HZ * frames.windowSize / frames.sampleRate), lowBin, bins);
+    FrameFeatures *output = features.data();
+
+    QVector<int> frameIndices(count);
+    std::iota(frameIndices.begin(), frameIndices.end(), firstFrame);
+    QtConcurrent::blockingMap(frameIndices, [&](int frame) {
+        const double *magnitude = frames.magnitudes[frame].constData();
+        const double *previous = frame > 0 ? frames.magnitudes[frame - 1].constData() : nullptr;
+        double total = 0.0;
+        double voiced = 0.0;
+        double rise = 0.0;
+        double sum = 0.0;
+
+        for (int k = 1; k < bins; ++k) { // bin 0 is the DC offset
+            double power = magnitude[k] * magnitude[k];
+            total += power;
+            sum += magnitude[k];
+            if (k >= lowBin && k < highBin) voiced += power;
+            if (previous) rise += std::max(magnitude[k] - previous[k], 0.0);
+        }
+
+        FrameFeatures &f = output[frame - firstFrame];
+        f.energyDb = 10.0 * std::log10(total + 1e-12);
+        f.flux = sum > 0.0 ? rise / sum : 0.0;
+        f.voicing = total > 0.0 ? voiced / total : 0.0;
+    });
+    return features;
+}
+
+QList<double> SyllableSegmenter::findBoundaries(const SpectralFrames &frames, double startProportion, double endProportion) {
+    TRACE_SCOPE("SyllableSegmenter::findBoundaries");
+    QList<double> boundaryProportions;
+    if (frames.isEmpty() || frames.sampleRate <= 0) return boundaryProportions;
+
+    int totalFrames = frames.magnitudes.size();
+    int firstFrame = std::clamp(frames.proportionToFrame(startProportion), 0, totalFrames);
+    int lastFrame = std::clamp(frames.proportionToFrame(endProportion), firstFrame, totalFrames);
+    int count = lastFrame - firstFrame;
+    if (count < 3) return boundaryProportions;
+
+    QVector<FrameFeatures> features = frameFeatures(frames, firstFrame, lastFrame);
+
+    // smooth the energy so a single noisy frame does not become a nucleus
+    QVector<double> energy(count);
+    for (int i = 0; i < count; ++i) {
+        int from = std::max(i - 1, 0);
+        int to = std::min(i + 1, count - 1);
+        double sum = 0.0;
+        for (int j = from; j <= to; ++j) sum += features[j].energyDb;
+        energy[i] = sum / (to - from + 1);
+    }
+
+    QVector<double> sortedEnergy = energy;
+    std::nth_element(sortedEnergy.begin(), sortedEnergy.begin() + count / 10, sortedEnergy.end());
+    double floorDb = sortedEnergy[count / 10];
+    double maxDb = *std::max_element(energy.begin(), energy.end());
+    double silenceDb = std::max(maxDb - SILENCE_RANGE_DB, floorDb + SILENCE_FLOOR_MARGIN_DB);
+    silenceDb = std::min(silenceDb, maxDb - NUCLEUS_DIP_DB); // a recording without pauses still has nuclei
+    auto isSilent = [&](int i) { return energy[i] < silenceDb; };
+
+    double framesPerSecond = (double) frames.sampleRate / frames.hopSize;
+    int minSyllableFrames = std::max(1, qRound(MIN_SYLLABLE_SECONDS * framesPerSecond));
+    int onsetFrames = std::max(1, qRound(ONSET_SEARCH_SECONDS * framesPerSecond));
+
+    // nuclei, valley is the lowest energy since the last nucleus
+    QList<int> nuclei;
+    double valley = 0.0;
+    for (int i = 0; i < count; ++i) {
+        if (!nuclei.isEmpty()) valley = std::min(valley, energy[i]);
+        if (isSilent(i) || features[i].voicing < VOICED_THRESHOLD) continue;
+
+        bool rising = i == 0 || energy[i] >= energy[i - 1];
+        bool falling = i == count - 1 || energy[i] > energy[i + 1];
+        if (!rising || !falling) continue;
+
+        if (!nuclei.isEmpty()) {
+            int previous = nuclei.last();
+            bool separated = i - previous >= minSyllableFrames
+                             && std::min(energy[previous], energy[i]) - valley >= NUCLEUS_DIP_DB;
+            if (!separated) {
+                if (energy[i] > energy[previous]) {
+                    nuclei.last() = i;
+                    valley = energy[i];
+                }
+                continue;
+            }
+        }
+        nuclei << i;
+        valley = energy[i];
+    }
+    if (nuclei.isEmpty()) return boundaryProportions;
+
+    QList<int> boundaries;
+    auto addBoundary = [&](int frame) {
+        if (frame > 0 && frame < count && (boundaries.isEmpty() || boundaries.last() < frame)) boundaries << frame;
+    };
+
+    for (int j = nuclei.first() - 1; j >= 0; --j) {
+        if (isSilent(j)) {
+            addBoundary(j + 1);
+            break;
+        }
+    }
+
+    for (int n = 1; n < nuclei.length(); ++n) {
+        int previous = nuclei[n - 1];
+        int next = nuclei[n];
+        int silenceStart = -1;
+        int silenceEnd = -1;
+        int valleyFrame = previous;
+        for (int j = previous + 1; j < next; ++j) {
+            if (isSilent(j)) {
+                if (silenceStart < 0) silenceStart = j;
+                silenceEnd = j + 1;
+            }
+            if (energy[j] < energy[valleyFrame]) valleyFrame = j;
+        }
+
+        if (silenceStart >= 0) {
+            addBoundary(silenceStart);
+            addBoundary(silenceEnd);
+            continue;
+        }
+
+        // the next syllable starts where the spectrum jumps up right after the valley
+        int boundary = valleyFrame;
+        for (int j = valleyFrame + 1; j < std::min(valleyFrame + onsetFrames + 1, next); ++j) {
+            if (features[j].flux > features[boundary].flux) boundary = j;
+        }
+        addBoundary(boundary);
+    }
+
+    for (int j = nuclei.last() + 1; j < count; ++j) {
+        if (isSilent(j)) {
+            addBoundary(j);
+            break;
+        }
+    }
+
+    for (int frame : boundaries) {
+        boundaryProportions << frames.frameToProportion(firstFrame + frame);
+    }
+    return boundaryProportions;
+}
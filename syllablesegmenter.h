@@ -0,0 +1,47 @@
+#ifndef SYLLABLESEGMENTER_H
+#define SYLLABLESEGMENTER_H
+
+#include <QList>
+#include <QVector>
+#include "spectralframes.h"
+
+/*
+ * File: syllablesegmenter.h
+ * Description:
+ *  This header file defines the 'SyllableSegmenter' class, an automatic segmentation based on the STFT frames of the
+ *  'Spectrograph'. Instead of cutting at raw amplitude peaks it looks for syllable nuclei (loud, voiced frames) and
+ *  silences, and places a boundary in the valley between two nuclei or at the edges of a silence.
+ *
+ * Purpose:
+ *  - Gives learners segments that roughly match syllables instead of hundreds of peak fragments
+ *  - Reuses the frames the spectrogram already computed so no extra FFTs are needed
+ *
+ * Key Members:
+ *  - 'FrameFeatures': Short-time energy (dB), spectral flux and voicing (share of energy in the voiced band) of a frame
+ *
+ * Public Methods:
+ *  - 'static QList<double> findBoundaries(const SpectralFrames &frames, double startProportion, double endProportion)':
+ *    Returns the boundaries strictly inside the selection as proportions of the track, in increasing order
+ *  - 'static QVector<FrameFeatures> frameFeatures(const SpectralFrames &frames, int firstFrame, int lastFrame)':
+ *    Computes the features of frames [firstFrame, lastFrame) in parallel, one frame per task
+ *
+ * Notes:
+ *  - Only the feature pass touches every bin, so it is the part that runs frame-parallel; peak picking is linear in the
+ *    number of frames and stays on the calling thread.
+ */
+
+class SyllableSegmenter
+{
+public:
+    struct FrameFeatures
+    {
+        double energyDb = 0.0;
+        double flux = 0.0;
+        double voicing = 0.0;
+    };
+
+    static QList<double> findBoundaries(const SpectralFrames &frames, double startProportion, double endProportion);
+    static QVector<FrameFeatures> frameFeatures(const SpectralFrames &frames, int firstFrame, int lastFrame);
+};
+
+#endif // SYLLABLESEGMENTER_H
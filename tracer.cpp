@@ -0,0 +1,192 @@
+#include "tracer.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QDebug>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+/*
+ * File: tracer.cpp
+ * Description:
+ *  This source file implements the 'Tracer'. A slot's sequence number is odd while its thread writes it and
+ *  2 * (event index + 1) once written, a reader copies the slot and keeps it only if the number was even and did not
+ *  change meanwhile. The fields are relaxed atomics so the copy is never a data race.
+ *
+ * References:
+ *  - Trace Event Format: https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+ *  - Boehm, "Can seqlocks get along with programming language memory models?" (2012)
+ */
+
+#define TRACE_EVENTS_PER_THREAD 65536 // power of two, 2 MB per live thread that records
+#define DEFAULT_TRACE_FILE "phonetics-trace.json"
+
+namespace {
+
+struct TraceSlot
+{
+    std::atomic<quint64> sequence{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<qint64> start{0};
+    std::atomic<qint64> end{0};
+};
+
+struct ThreadBuffer
+{
+    int threadId = 0;
+    QString threadName;
+    bool inUse = false; // false once its thread exited, the next new thread takes it over
+    quint64 written = 0; // only touched by the owning thread
+    std::unique_ptr<TraceSlot[]> slots{new TraceSlot[TRACE_EVENTS_PER_THREAD]};
+};
+
+struct Registry
+{
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers; // as many as threads ever recorded at the same time
+    int lastThreadId = 0;
+};
+
+// never destroyed, pool threads may exit after the static destructors ran
+Registry &registry() {
+    static Registry *instance = new Registry;
+    return *instance;
+}
+
+// returns the buffer to the registry when its thread exits, the spans stay exportable until it is taken over
+struct BufferOwner
+{
+    ThreadBuffer *buffer = nullptr;
+
+    ~BufferOwner() {
+        if (!buffer) return;
+        QMutexLocker locker(&registry().mutex);
+        buffer->inUse = false;
+    }
+};
+
+std::atomic<qint64> recordingStart{0};
+QString environmentTracePath;
+
+ThreadBuffer *threadBuffer() {
+    thread_local BufferOwner owner;
+    if (owner.buffer) return owner.buffer;
+
+    Registry &threads = registry();
+    QMutexLocker locker(&threads.mutex);
+    ThreadBuffer *buffer = nullptr;
+    for (const std::unique_ptr<ThreadBuffer> &candidate : threads.buffers) {
+        if (candidate->inUse) continue;
+        buffer = candidate.get();
+        for (int i = 0; i < TRACE_EVENTS_PER_THREAD; ++i) buffer->slots[i].sequence.store(0, std::memory_order_relaxed); // readers hold the mutex
+        buffer->written = 0;
+        break;
+    }
+    if (!buffer) {
+        threads.buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = threads.buffers.back().get();
+    }
+    buffer->inUse = true;
+    buffer->threadId = ++threads.lastThreadId;
+    QThread *thread = QThread::currentThread();
+    bool guiThread = QCoreApplication::instance() && thread == QCoreApplication::instance()->thread();
+    buffer->threadName = guiThread ? QString("GUI") : QString("%1 %2").arg(thread->objectName().isEmpty() ? "Thread" : thread->objectName()).arg(buffer->threadId);
+    owner.buffer = buffer;
+    return buffer;
+}
+
+}
+
+void Tracer::setEnabled(bool _enabled) {
+    if (_enabled && !isEnabled()) recordingStart.store(now(), std::memory_order_relaxed);
+    enabled.store(_enabled, std::memory_order_relaxed);
+}
+
+qint64 Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char *name, qint64 start, qint64 end) {
+    ThreadBuffer *buffer = threadBuffer();
+    TraceSlot &slot = buffer->slots[buffer->written & (TRACE_EVENTS_PER_THREAD - 1)];
+    quint64 sequence = 2 * (buffer->written + 1);
+
+    slot.sequence.store(sequence - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    slot.sequence.store(sequence, std::memory_order_release);
+    ++buffer->written;
+}
+
+QByteArray Tracer::chromeTraceJson() {
+    qint64 origin = recordingStart.load(std::memory_order_relaxed);
+    QJsonArray events;
+
+    Registry &threads = registry();
+    QMutexLocker locker(&threads.mutex);
+    for (const std::unique_ptr<ThreadBuffer> &buffer : threads.buffers) {
+        QJsonObject threadName;
+        threadName["name"] = "thread_name";
+        threadName["ph"] = "M";
+        threadName["pid"] = 1;
+        threadName["tid"] = buffer->threadId;
+        threadName["args"] = QJsonObject{{"name", buffer->threadName}};
+        events.append(threadName);
+
+        for (int i = 0; i < TRACE_EVENTS_PER_THREAD; ++i) {
+            const TraceSlot &slot = buffer->slots[i];
+            quint64 before = slot.sequence.load(std::memory_order_acquire);
+            if (before == 0 || before % 2) continue; // never written or being written
+            const char *name = slot.name.load(std::memory_order_relaxed);
+            qint64 start = slot.start.load(std::memory_order_relaxed);
+            qint64 end = slot.end.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != before) continue; // overwritten while copying
+            if (start < origin) continue; // from an earlier recording
+
+            QJsonObject event;
+            event["name"] = QString::fromUtf8(name);
+            event["cat"] = "phonetics";
+            event["ph"] = "X";
+            event["pid"] = 1;
+            event["tid"] = buffer->threadId;
+            event["ts"] = (start - origin) / 1000.0; // microseconds
+            event["dur"] = (end - start) / 1000.0;
+            events.append(event);
+        }
+    }
+
+    QJsonObject trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+    return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+bool Tracer::writeChromeTrace(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Trace Error: could not write" << path;
+        return false;
+    }
+    QByteArray json = chromeTraceJson();
+    return file.write(json) == json.size();
+}
+
+void Tracer::startFromEnvironment() {
+    QString value = qEnvironmentVariable("PHONETICS_TRACE");
+    if (value.isEmpty() || value == "0") return;
+    environmentTracePath = value == "1" ? QString(DEFAULT_TRACE_FILE) : value;
+    setEnabled(true);
+}
+
+void Tracer::finishFromEnvironment() {
+    if (environmentTracePath.isEmpty()) return;
+    if (writeChromeTrace(environmentTracePath)) qInfo() << "Trace written to" << environmentTracePath;
+}
@@ -0,0 +1,78 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+
+/*
+ * File: tracer.h
+ * Description:
+ *  This header file defines the 'Tracer', which records how long the hot paths take (decoding, waveform reduction,
+ *  the STFT, rasterization, scene rebuilds, ...) and exports them as Chrome trace_event JSON, and 'TraceSpan', the
+ *  RAII guard that times one scope.
+ *
+ * Purpose:
+ *  - Shows which step caused a freeze: open the saved file in chrome://tracing or https://ui.perfetto.dev
+ *
+ * Usage:
+ *  - 'TRACE_SCOPE("WavForm::setChart");' at the top of a function times the rest of the scope
+ *  - PHONETICS_TRACE=<file> starts recording at launch and writes the trace there on exit (PHONETICS_TRACE=1 writes
+ *    phonetics-trace.json in the working directory), the Debug menu of the main window starts, stops and saves it
+ *
+ * Public Methods:
+ *  - 'static bool isEnabled()': One relaxed atomic load, all a disabled span costs
+ *  - 'static void setEnabled(bool enabled)': Enabling starts a new recording, older events are not exported
+ *  - 'static qint64 now()': Nanoseconds on the monotonic clock
+ *  - 'static void record(const char *name, qint64 start, qint64 end)': Adds a finished span of the calling thread
+ *  - 'static QByteArray chromeTraceJson()': Spans of every thread since the recording started
+ *  - 'static bool writeChromeTrace(const QString &path)': Writes chromeTraceJson() to a file
+ *  - 'static void startFromEnvironment()' / 'static void finishFromEnvironment()': PHONETICS_TRACE handling for main()
+ *
+ * Notes:
+ *  - Every thread writes to its own ring buffer, no locks on the recording path. The buffer is registered under a
+ *    mutex once, the first time a thread records, and handed back when the thread exits: a new thread takes over a
+ *    free buffer before another is allocated, so pool threads coming and going do not add up. Readers use a sequence
+ *    number per slot (seqlock) and skip slots that are being overwritten, so saving while threads keep recording is
+ *    safe. The spans of an exited thread are exported until a new thread takes its buffer over.
+ *  - A ring keeps the last TRACE_EVENTS_PER_THREAD spans of its thread, older ones are overwritten.
+ *  - Names must be string literals (or live as long as the program), only the pointer is stored.
+ *  - Defining PHONETICS_NO_TRACE compiles the spans out completely.
+ */
+
+class Tracer
+{
+    static inline std::atomic<bool> enabled{false};
+
+public:
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    static qint64 now();
+    static void record(const char *name, qint64 start, qint64 end);
+    static QByteArray chromeTraceJson();
+    static bool writeChromeTrace(const QString &path);
+    static void startFromEnvironment();
+    static void finishFromEnvironment();
+};
+
+class TraceSpan
+{
+    const char *name;
+    qint64 start;
+
+public:
+    explicit TraceSpan(const char *_name) : name(_name), start(Tracer::isEnabled() ? Tracer::now() : -1) {}
+    ~TraceSpan() { if (start >= 0) Tracer::record(name, start, Tracer::now()); }
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#ifdef PHONETICS_NO_TRACE
+#define TRACE_SCOPE(name)
+#else
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#endif
+
+#endif // TRACER_H
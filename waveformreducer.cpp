@@ -0,0 +1,44 @@
+#include "waveformreducer.h"
+#include "tracer.h"
+#include <cmath>
+
+/*
+ * File: waveformreducer.cpp
+ * Description:
+ *  This source file implements the 'WaveformReducer', a single pass over the samples of every column.
+ */
+
+WaveformColumns WaveformReducer::reduce(const QList<float> &data, int width) {
+    TRACE_SCOPE("WaveformReducer::reduce");
+    WaveformColumns columns;
+    width = std::max(width, 0);
+    columns.mins = QList<float>(width);
+    columns.maxs = QList<float>(width);
+    columns.avgs = QList<float>(width);
+    columns.rms = QList<float>(width);
+
+    // splits data into samples for each pixel of width
+    int sampleLength = width > 0 ? data.length() / width : 0;
+    const float *samples = data.constData();
+
+    // finds max value, min value, average value, and root mean square of each sample
+    for (int i = 0; i < width; ++i) {
+        float sum = 0;
+        float squareSum = 0;
+        float min = 1.0;
+        float max = -1.0;
+        const float *column = samples + (qsizetype) i * sampleLength;
+        for (int j = 0; j < sampleLength; ++j) {
+            float adjusted = column[j];
+            if (adjusted < min) min = adjusted;
+            if (adjusted > max) max = adjusted;
+            sum += std::abs(adjusted);
+            squareSum += adjusted * adjusted;
+        }
+        columns.mins[i] = min;
+        columns.maxs[i] = max;
+        columns.avgs[i] = sum / sampleLength;
+        columns.rms[i] = std::sqrt(squareSum / sampleLength);
+    }
+    return columns;
+}
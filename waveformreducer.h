@@ -0,0 +1,33 @@
+#ifndef WAVEFORMREDUCER_H
+#define WAVEFORMREDUCER_H
+
+#include <QList>
+
+/*
+ * File: waveformreducer.h
+ * Description:
+ *  This header file defines the 'WaveformReducer' class, which reduces audio samples to one column of statistics per
+ *  pixel of a waveform, and the 'WaveformColumns' struct holding them. 'WavForm' draws the columns, the batch tool
+ *  writes them to peak files.
+ *
+ * Public Methods:
+ *  - 'static WaveformColumns reduce(const QList<float> &data, int width)': Splits the samples into width equal parts
+ *    (the remainder at the end is left out) and computes the min, max, average absolute value and root mean square
+ *    of each
+ */
+
+struct WaveformColumns
+{
+    QList<float> mins;
+    QList<float> maxs;
+    QList<float> avgs;
+    QList<float> rms;
+};
+
+class WaveformReducer
+{
+public:
+    static WaveformColumns reduce(const QList<float> &data, int width);
+};
+
+#endif // WAVEFORMREDUCER_H
@@ -1,5 +1,15 @@
 #include "waveformsegments.h"
 #include <QtCore/qdebug.h>
+#include "syllablesegmenter.h"
+#include "workerpool.h"
+#include "tracer.h"
+#include "memorybudget.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 /*
  * File: waveformsegments.cpp
@@ -17,20 +27,45 @@
  *  audio graph information and creates segments from them to be graphed.
  *  - 'void clearAllWavSegments()': clears the wav segments out if user resets the lines
  *  - 'void uploadAudio(QList<float> audio)': uploads new audio to be sliced upon recieving segmentPlaces from collectWavSegment
- *  - 'void autoSegment(QList<float> dataSample)': creates automated segments based of local maximums and segment length and sends the indeces to the Waveform
+ *  - 'void autoSegment(int startIndex, int endIndex)': runs autoSegmentPeaks on a worker thread, once it finishes the segments
+ *  are collected and the indeces are sent to the Waveform
+ *  - 'QList<int> autoSegmentPeaks(const QList<float> &audio, int startIndex, int endIndex)': creates automated segments based
+ *  of local maximums and segment length. Zero crossings are found 64 samples at a time with SIMD, crossings closer than
+ *  1/100 of the selection to the last kept one are skipped, and the maximum of the current span is tracked while scanning
+ *  so the selection is only read once.
+ *  - in SyllableSegments mode 'autoSegment' runs 'SyllableSegmenter::findBoundaries' on the spectrogram frames instead, the
+ *  selection start and end are kept as the outer boundaries so the segments cover the whole selection
+ *  - 'void computeStatistics()': once segments are collected, runs the 'Ltas' of every segment (and of the file, the
+ *  first time) on a worker thread, each of them a parallel reduction over the spectrogram frames of its range
  *
  * Notes:
  *  - this does not delete individual segments, it only takes in all that need to be made, makes them, then sends them off
+ *  - the old version removed crossings from the middle of a QList inside a loop (quadratic) which hung the GUI on
+ *  multi-second selections, the peaks found are the same as before
  *
  */
 WaveFormSegments::WaveFormSegments(QList<float> _audioSamples , QObject *parent)
-    : QObject{parent}, originalAudio(_audioSamples)
-{}
+    : QObject{parent}, originalAudio(_audioSamples), autoSegmentRequest(0), runningAutoSegmentRequest(-1), autoSegmentStart(0),
+      autoSegmentMode(PeakSegments), runningAutoSegmentMode(PeakSegments), statisticsRequest(0), runningStatisticsRequest(-1),
+      statisticsPending(false)
+{
+    connect(&autoSegmentWatcher, &QFutureWatcher<QList<int>>::finished, this, &WaveFormSegments::autoSegmentFinished);
+    connect(&statisticsWatcher, &QFutureWatcher<QPair<LtasStatistics, QList<LtasStatistics>>>::finished,
+            this, &WaveFormSegments::statisticsFinished);
+    budgetEntry = MemoryBudget::add("segments"); // the user's own work, counted but never evicted
+}
+
+WaveFormSegments::~WaveFormSegments() {
+    MemoryBudget::remove(budgetEntry);
+}
 
 void WaveFormSegments::collectWavSegment(QList<int> segmentPlaces, bool isAuto){
+    TRACE_SCOPE("WaveFormSegments::collectWavSegment");
     clearAllWavSegments();
     if (isAuto) {
-        autoSegment(originalAudio.mid(segmentPlaces[0], segmentPlaces[1] - segmentPlaces[0]), segmentPlaces[0]);
+        // segments are collected once the worker thread has found the peaks
+        autoSegment(segmentPlaces[0], segmentPlaces[1]);
+        return;
     }
 
     audioSampleLength = originalAudio.length();
@@ -42,15 +77,55 @@ void WaveFormSegments::collectWavSegment(QList<int> segmentPlaces, bool isAuto){
         wavSegments << wavSegment;
         wavSegmentStartEndPositions << QPair<double, double> (startOfSegment, endOfSegment);
     }
-    if (isAuto) wavSegments.remove(wavSegments.length() - 1);
-    if (isAuto) wavSegmentStartEndPositions.remove(wavSegments.length() - 1);
+    MemoryBudget::setBytes(budgetEntry, segmentBytes());
     emit storeStartEndValuesOfSegments(wavSegmentStartEndPositions);
     emit createWavSegmentGraphs(wavSegments);
+    computeStatistics();
+}
+
+void WaveFormSegments::computeStatistics() {
+    if (wavSegmentStartEndPositions.isEmpty()) return;
+    if (spectralFrames.isEmpty()) {
+        // setSpectralFrames() computes them once the frames are in
+        statisticsPending = true;
+        emit spectralFramesNeeded();
+        return;
+    }
+    statisticsPending = false;
+    runningStatisticsRequest = ++statisticsRequest;
+
+    SpectralFrames frames = spectralFrames;
+    QList<QPair<double, double>> segments = wavSegmentStartEndPositions;
+    bool fileDone = !fileStatistics.isEmpty();
+    statisticsWatcher.setFuture(WorkerPool::run(WorkerPool::Visible, [frames, segments, fileDone]() {
+        QPair<LtasStatistics, QList<LtasStatistics>> statistics;
+        if (!fileDone) statistics.first = Ltas::compute(frames);
+        statistics.second = Ltas::computeSegments(frames, segments);
+        return statistics;
+    }));
+}
+
+void WaveFormSegments::statisticsFinished() {
+    // segments were cleared, collected again or new audio was uploaded while this was running
+    if (runningStatisticsRequest != statisticsRequest) return;
+    QPair<LtasStatistics, QList<LtasStatistics>> statistics = statisticsWatcher.result();
+    if (!statistics.first.isEmpty()) fileStatistics = statistics.first;
+    emit statisticsReady(fileStatistics, statistics.second);
 }
 
 void WaveFormSegments::clearAllWavSegments(){
+    ++autoSegmentRequest; // an auto segment that is still running is outdated now
+    ++statisticsRequest;
+    statisticsPending = false;
     if (!wavSegments.isEmpty()) wavSegments.clear();
     if (!wavSegmentStartEndPositions.isEmpty()) wavSegmentStartEndPositions.clear();
+    MemoryBudget::setBytes(budgetEntry, 0);
+}
+
+qint64 WaveFormSegments::segmentBytes() const {
+    qint64 bytes = 0;
+    for (const QList<float> &segment : wavSegments) bytes += segment.size() * (qint64) sizeof(float);
+    return bytes;
 }
 
 void WaveFormSegments::uploadAudio(QList<float> audio){
@@ -58,47 +133,139 @@ void WaveFormSegments::uploadAudio(QList<float> audio){
         originalAudio.clear();
     }
     originalAudio = audio;
+    spectralFrames = SpectralFrames(); // the spectrograph sends the frames of the new audio once they are computed
+    fileStatistics = LtasStatistics();
     clearAllWavSegments();
 }
 
-void WaveFormSegments::autoSegment(QList<float> dataSample, int startIndex) {
-    QList<int> zeroCrossings;
-    zeroCrossings << 0;
-    for (int i = 0; i < dataSample.length() - 1; ++i) {
-        if ((dataSample[i] > 0.0 && dataSample[i + 1] < 0.0) || (dataSample[i] < 0.0 && dataSample[i + 1] > 0.0)) {
-            zeroCrossings << i;
-        }
-    }
-    zeroCrossings << dataSample.length() - 1;
+void WaveFormSegments::setAutoSegmentMode(WaveFormSegments::AutoSegmentMode mode) {
+    autoSegmentMode = mode;
+}
 
-    QList<QList<float>> localData;
+void WaveFormSegments::setSpectralFrames(SpectralFrames frames) {
+    spectralFrames = frames; // empty when the spectrograph evicted them, the file statistics stay
+    if (statisticsPending && !spectralFrames.isEmpty()) computeStatistics();
+}
 
-    for (int i = 0; i < zeroCrossings.length() - 1; ++i) { //shrinking down zeroCrossings to a manageable amount (100 maximum per segment)
-        while(zeroCrossings[i + 1] - zeroCrossings[i] < (dataSample.length() / 100) && zeroCrossings.length() - 1 > i + 1) {
-            zeroCrossings.remove(i + 1);
+// bit k is set when audio[k] and audio[k + 1] have opposite signs (zeros are not crossings), count <= 64
+static quint64 zeroCrossingMask(const float *audio, int count) {
+    quint64 mask = 0;
+    int k = 0;
+#if defined(__SSE2__)
+    const __m128 zero = _mm_setzero_ps();
+    for (; k + 4 <= count; k += 4) {
+        __m128 a = _mm_loadu_ps(audio + k);
+        __m128 b = _mm_loadu_ps(audio + k + 1);
+        __m128 upward = _mm_and_ps(_mm_cmplt_ps(a, zero), _mm_cmpgt_ps(b, zero));
+        __m128 downward = _mm_and_ps(_mm_cmpgt_ps(a, zero), _mm_cmplt_ps(b, zero));
+        mask |= quint64(_mm_movemask_ps(_mm_or_ps(upward, downward))) << k;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const uint32x4_t laneBits = {1, 2, 4, 8};
+    for (; k + 4 <= count; k += 4) {
+        float32x4_t a = vld1q_f32(audio + k);
+        float32x4_t b = vld1q_f32(audio + k + 1);
+        uint32x4_t upward = vandq_u32(vcltq_f32(a, zero), vcgtq_f32(b, zero));
+        uint32x4_t downward = vandq_u32(vcgtq_f32(a, zero), vcltq_f32(b, zero));
+        mask |= quint64(vaddvq_u32(vandq_u32(vorrq_u32(upward, downward), laneBits))) << k;
+    }
+#endif
+    for (; k < count; ++k) {
+        if ((audio[k] > 0.0f && audio[k + 1] < 0.0f) || (audio[k] < 0.0f && audio[k + 1] > 0.0f)) {
+            mask |= quint64(1) << k;
         }
-        localData << dataSample.mid(zeroCrossings[i], zeroCrossings[i + 1] - zeroCrossings[i]);
     }
+    return mask;
+}
 
+QList<int> WaveFormSegments::autoSegmentPeaks(const QList<float> &audio, int startIndex, int endIndex) {
+    TRACE_SCOPE("WaveFormSegments::autoSegmentPeaks");
     QList<int> localMaxs;
-    int sumLength = 0;
-    for (int i = 0; i < localData.length(); ++i) {
-        int maxIndex = 0;
-        for (int j = 1; j < localData[i].length(); ++j) {
-            if (localData[i][j] > localData[i][maxIndex]) maxIndex = j;
+    startIndex = std::clamp(startIndex, 0, int(audio.length()));
+    endIndex = std::clamp(endIndex, startIndex, int(audio.length()));
+    const float *dataSample = audio.constData() + startIndex;
+    const int length = endIndex - startIndex;
+    const int minSpan = length / 100; //shrinking down zeroCrossings to a manageable amount (100 maximum per segment)
+
+    int spanStart = 0; // the selection start always starts a span
+    int maxIndex = 0;
+    int scanned = 0;
+    auto scanTo = [&](int end) {
+        for (; scanned < end; ++scanned) {
+            if (dataSample[scanned] > dataSample[maxIndex]) maxIndex = scanned;
+        }
+    };
+
+    // a crossing at i is between samples i and i + 1, so the last possible crossing is length - 2
+    for (int block = 0; block < length - 1; block += 64) {
+        quint64 crossings = zeroCrossingMask(dataSample + block, std::min(64, length - 1 - block));
+        while (crossings) {
+            int crossing = block + qCountTrailingZeroBits(crossings);
+            crossings &= crossings - 1;
+            if (crossing - spanStart < minSpan) continue;
+
+            scanTo(crossing);
+            localMaxs << maxIndex;
+            spanStart = crossing;
+            maxIndex = crossing;
+            scanned = crossing;
         }
-        localMaxs << sumLength + maxIndex;
-        sumLength += localData[i].length();
     }
 
+    // the last span runs to the final sample, which is a boundary of its own
+    scanTo(std::max(length - 1, 0));
+    localMaxs << maxIndex;
+    return localMaxs;
+}
+
+void WaveFormSegments::autoSegment(int startIndex, int endIndex) {
+    TRACE_SCOPE("WaveFormSegments::autoSegment");
+    runningAutoSegmentRequest = ++autoSegmentRequest;
+    autoSegmentStart = startIndex;
+    runningAutoSegmentMode = autoSegmentMode;
+
+    if (runningAutoSegmentMode == SyllableSegments && spectralFrames.isEmpty()) {
+        qWarning() << "Spectrogram not ready yet, auto segmenting by peaks instead of syllables";
+        runningAutoSegmentMode = PeakSegments;
+    }
+
+    if (runningAutoSegmentMode == SyllableSegments) {
+        SpectralFrames frames = spectralFrames;
+        double audioLength = std::max<qsizetype>(originalAudio.length(), 1);
+        autoSegmentWatcher.setFuture(WorkerPool::run(WorkerPool::Visible, [frames, audioLength, startIndex, endIndex]() {
+            QList<int> boundaries;
+            boundaries << 0;
+            for (double proportion : SyllableSegmenter::findBoundaries(frames, startIndex / audioLength, endIndex / audioLength)) {
+                int boundary = qRound(proportion * audioLength) - startIndex;
+                if (boundary > boundaries.last() && boundary < endIndex - startIndex) boundaries << boundary;
+            }
+            boundaries << endIndex - startIndex;
+            return boundaries;
+        }));
+        return;
+    }
+
+    QList<float> audio = originalAudio; // shared, not copied
+    autoSegmentWatcher.setFuture(WorkerPool::run(WorkerPool::Visible, [audio, startIndex, endIndex]() {
+        return autoSegmentPeaks(audio, startIndex, endIndex);
+    }));
+}
+
+void WaveFormSegments::autoSegmentFinished() {
+    TRACE_SCOPE("WaveFormSegments::autoSegmentFinished");
+    // segments were cleared or new audio was uploaded while this was running
+    if (runningAutoSegmentRequest != autoSegmentRequest) return;
+    QList<int> localMaxs = autoSegmentWatcher.result();
+
     QList<int> trueLocalMaxs; // in reference to the entire WAV file's data
     for (int i = 0; i < localMaxs.length(); ++i) {
-        trueLocalMaxs << startIndex + localMaxs[i];
+        trueLocalMaxs << autoSegmentStart + localMaxs[i];
     }
 
     collectWavSegment(trueLocalMaxs, false); //now it is defined segments so we send false for auto
 
+    // syllable boundaries include the selection start and end, which already have their own lines
+    if (runningAutoSegmentMode == SyllableSegments) localMaxs = localMaxs.mid(1, localMaxs.length() - 2);
     emit drawAutoSegments(localMaxs);
 }
-
-
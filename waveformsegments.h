@@ -2,6 +2,9 @@
 #define WAVEFORMSEGMENTS_H
 
 #include <QObject>
+#include <QFutureWatcher>
+#include "spectralframes.h"
+#include "ltas.h"
 
 /*
  * File: waveformsegments.h
@@ -16,17 +19,39 @@
  * Key Members:
  *  -  'QList<QList<float>> wavSegments': holds the wavSegments to be emitted
     -  'QList<float> originalAudio': the original sample audio data to chop up
+ *  -  'QFutureWatcher<QList<int>> autoSegmentWatcher': watches the auto segmentation running on a worker thread
+ *  -  'int autoSegmentRequest': counts auto segment requests and clears so results of an outdated request are dropped
+ *  -  'AutoSegmentMode autoSegmentMode': PeakSegments (local maxima between zero crossings) or SyllableSegments (energy,
+ *      spectral flux and voicing of the spectrogram frames, see 'SyllableSegmenter')
+ *  -  'SpectralFrames spectralFrames': the spectrogram frames of the loaded audio, used by SyllableSegments
+ *  -  'QFutureWatcher<QPair<LtasStatistics, QList<LtasStatistics>>> statisticsWatcher': watches the 'Ltas' of the file
+ *      and of the segments running on a worker thread, 'int statisticsRequest' drops the results of outdated segments
+ *  -  'LtasStatistics fileStatistics': the statistics of the whole file, computed once per file
+ *  -  'bool statisticsPending': segments are waiting for the spectrogram frames (not computed or evicted yet)
  *
  * Public Methods:
  *  - 'uploadAudio(QList<float> audio)': gives the object the audio data to slice
+ *  - 'qint64 segmentBytes() const': bytes held by the sliced segments (the original audio is shared with the 'WavFile'),
+ *    also reported to the 'MemoryBudget'
+ *  - 'static QList<int> autoSegmentPeaks(const QList<float> &audio, int startIndex, int endIndex)': single pass detector
+ *      returning the local maximum of every zero crossing span, relative to startIndex
  *
  * Slots:
  *  - 'void collectWavSegment(QList<int> segmentPlaces)': collects wav segments and divides audio graph based on segment location
  *  - 'void clearAllWavSegments()': clears segment information (to be used when user clears segments from graph)
- *  - 'void autoSegment(QList<float> dataSample)': creates automated points in the audio wave for segementation
+ *  - 'void autoSegment(int startIndex, int endIndex)': creates automated points in the audio wave for segementation off the GUI thread
+ *  - 'void setAutoSegmentMode(WaveFormSegments::AutoSegmentMode mode)': chooses how the next auto segmentation is made
+ *  - 'void setSpectralFrames(SpectralFrames frames)': stores the spectrogram frames of the loaded audio, and computes the
+ *      statistics of segments that were waiting for them
+ *
+ * Private Methods:
+ *  - 'void computeStatistics()': computes the 'Ltas' statistics of the file and the segments off the GUI thread
  *
  *Signals:
  *  - 'createWavSegmentGraphs(QList<QList<float>>)' : tells the detailed graphs to make them from the wavSegments
+ *  - 'statisticsReady(LtasStatistics fileStatistics, QList<LtasStatistics> segmentStatistics)': the spectra and
+ *      statistics of the file and of every segment, in the order of the segments
+ *  - 'spectralFramesNeeded()': the statistics need the spectrogram frames, which were evicted or are not computed yet
  * Notes:
  *  - This works in tandum with SegmentGraph and user input on the graph closely, all changes to those should involve
  *      double checking the functionality here is not compromised
@@ -35,24 +60,54 @@
 class WaveFormSegments : public QObject
 {
     Q_OBJECT
+public:
+    enum AutoSegmentMode { PeakSegments, SyllableSegments };
+
+private:
     QList<QList<float>> wavSegments;
     QList<QPair<double, double>> wavSegmentStartEndPositions;
     QList<float> originalAudio;
     double audioSampleLength;
+    QFutureWatcher<QList<int>> autoSegmentWatcher;
+    int autoSegmentRequest;
+    int runningAutoSegmentRequest;
+    int autoSegmentStart;
+    AutoSegmentMode autoSegmentMode;
+    AutoSegmentMode runningAutoSegmentMode;
+    SpectralFrames spectralFrames;
+    QFutureWatcher<QPair<LtasStatistics, QList<LtasStatistics>>> statisticsWatcher;
+    int statisticsRequest;
+    int runningStatisticsRequest;
+    LtasStatistics fileStatistics;
+    bool statisticsPending;
+    int budgetEntry;
+
+    void computeStatistics();
 
 public:
     explicit WaveFormSegments(QList<float> _audioSamples = QList<float>(), QObject *parent = nullptr);
+    ~WaveFormSegments();
     void uploadAudio(QList<float> audio);
+    qint64 segmentBytes() const;
+    static QList<int> autoSegmentPeaks(const QList<float> &audio, int startIndex, int endIndex);
 
 public slots:
     void collectWavSegment(QList<int> segmentPlaces,  bool isAuto);
     void clearAllWavSegments();
-    void autoSegment(QList<float> dataSample, int startIndex);
+    void autoSegment(int startIndex, int endIndex);
+    void setAutoSegmentMode(WaveFormSegments::AutoSegmentMode mode);
+    void setSpectralFrames(SpectralFrames frames);
+
+private slots:
+    void autoSegmentFinished();
+    void statisticsFinished();
 
 signals:
     void createWavSegmentGraphs(QList<QList<float>>);
     void drawAutoSegments(QList<int>);
     void storeStartEndValuesOfSegments(QList<QPair<double, double>>);
+    void statisticsReady(LtasStatistics fileStatistics, QList<LtasStatistics> segmentStatistics);
+    void spectralFramesNeeded();
 };
 
 #endif // WAVEFORMSEGMENTS_H
@@ -1,5 +1,8 @@
 #include "wavfile.h"
-#include <QtWidgets>
+#include <QtCore>
+#include "tracer.h"
+#include "pcmcache.h"
+#include <cstring>
 
 /*
  * File: wavfile.cpp
@@ -8,7 +11,7 @@
  *   The class validates the WAV file header, extracts audio properties, and parses audio samples.
  *
  * Implementation Details:
- *   - `loadFile()`: Opens the file, validates its header, and extracts audio data.
+ *   - `loadFile()`: Opens the file, reads and validates its header, then reads only the data chunk.
  *   - `readHeader()`: Reads and validates the WAV file's 44-byte header, extracting metadata.
  *   - `collectAudioSamples()`: Parses 16-bit PCM audio data into a list of signed integers.
  *
@@ -19,6 +22,8 @@
  *   - `loadFile()`: Main entry point for loading and parsing a WAV file. Emits a signal upon success or failure.
  *   - `readHeader(const QByteArray& headerData)`: Extracts sample rate, number of channels, bit depth, and data size from the header.
  *   - `collectAudioSamples()`: Converts raw audio data into a list of float samples between -1.0 and 1.0 for further processing.
+ *   - `loadCachedFile()`: Copies the samples of a compressed file out of its mapped 'PcmCache' copy.
+ *   - `writeFile()`: Writes the canonical 44 byte header with a 16 byte fmt chunk, format 3 (IEEE float), and the samples.
  *
  * Notes:
  *   - `loadFile()` ensures the WAV file has a valid header and sufficient data before extracting samples.
@@ -42,6 +47,7 @@ WavFile::WavFile(const QString& filePath, QObject* parent)
 }
 
 bool WavFile::loadFile() {
+    TRACE_SCOPE("WavFile::loadFile");
     QFile file(filePath);
 
     if (!file.open(QIODevice::ReadOnly)) {
@@ -50,30 +56,35 @@ bool WavFile::loadFile() {
         return false;
     }
 
-    QByteArray fileContent = file.readAll(); //read file into QByteArray
-    file.close();
+    // only the header until the format is known, compressed formats have no RIFF header and are read from their
+    // decoded copy if there is one
+    QByteArray headerData = file.read(46);
+    if (!headerData.startsWith("RIFF")) {
+        file.close();
+        QString cacheFile = PcmCache::cachedFileFor(filePath);
+        if (!cacheFile.isEmpty()) return loadCachedFile(cacheFile);
+    }
 
-    if (fileContent.size() < 44) {
+    if (headerData.size() < 44) {
         qWarning() << "File Error: File header too small to be valid WAV file";
         emit fileLoaded(false);
         return false;
     }
 
-    //set header and audiodata byte chunks for parsing
-    QByteArray headerData = fileContent.left(46);
-
-
     if (!readHeader(headerData)) {
         qWarning() << "File Error: Invalid WAV header";
         emit fileLoaded(false);
         return false;
     }
 
+    //read the data chunk straight into audioData for parsing
     if (qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(headerData.mid(16, 4).constData())) == 16) {
-        audioData = fileContent.mid(44, dataSize);
+        file.seek(44);
     } else {
-        audioData = fileContent.mid(46, dataSize);
+        file.seek(46);
     }
+    audioData = file.read(dataSize);
+    file.close();
 
     //collect samples of data
     collectAudioSamples();
@@ -82,6 +93,58 @@ bool WavFile::loadFile() {
     return true;
 }
 
+bool WavFile::loadCachedFile(const QString &cacheFile) {
+    PcmCacheFile cached;
+    if (!cached.open(cacheFile)) {
+        qWarning() << "Load Error: Could not read decoded copy" << cacheFile;
+        emit fileLoaded(false);
+        return false;
+    }
+    sampleRate = cached.sampleRate();
+    numChannels = cached.channels();
+    bitDepth = 32;
+    dataSize = 0;
+    audioData.clear();
+    // the one copy out of the map, the list outlives the mapping
+    samples = QList<float>(cached.samples(), cached.samples() + cached.frames() * cached.channels());
+    emit fileLoaded(true);
+    return true;
+}
+
+bool WavFile::writeFile(const QString &path, const QList<float> &samples, int sampleRate, int channels) {
+    TRACE_SCOPE("WavFile::writeFile");
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Save Error: Could not write file" << path;
+        return false;
+    }
+
+    quint32 dataSize = quint32(samples.size() * sizeof(float));
+    QByteArray header(44, '\0');
+    uchar *h = reinterpret_cast<uchar*>(header.data());
+    memcpy(h, "RIFF", 4);
+    qToLittleEndian<quint32>(36 + dataSize, h + 4);
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);
+    qToLittleEndian<quint32>(16, h + 16);
+    qToLittleEndian<quint16>(3, h + 20);
+    qToLittleEndian<quint16>(channels, h + 22);
+    qToLittleEndian<quint32>(sampleRate, h + 24);
+    qToLittleEndian<quint32>(sampleRate * channels * sizeof(float), h + 28);
+    qToLittleEndian<quint16>(channels * sizeof(float), h + 32);
+    qToLittleEndian<quint16>(32, h + 34);
+    memcpy(h + 36, "data", 4);
+    qToLittleEndian<quint32>(dataSize, h + 40);
+
+    QByteArray data(dataSize, Qt::Uninitialized);
+    qToLittleEndian<float>(samples.constData(), samples.size(), data.data());
+    if (file.write(header) != header.size() || file.write(data) != data.size()) {
+        qWarning() << "Save Error: Could not write file" << path;
+        return false;
+    }
+    return true;
+}
+
 bool WavFile::readHeader(const QByteArray& headerData) {
     if (headerData.mid(0, 4) != "RIFF") {
         qWarning() << "File Error: Invalid RIFF header";
@@ -124,15 +187,19 @@ void WavFile::collectAudioSamples(){
         qWarning() << "File Error: Invalid Bit Depth";
         return;
     }
+    // read in place, a QByteArray::mid per sample allocated for every one of them
+    const uchar *data = reinterpret_cast<const uchar*>(audioData.constData());
+    samples.reserve(audioData.size() / (bitDepth / 8));
     for (int i = 0; i < audioData.size(); i += (bitDepth / 8)) {
         if (i + 1 < audioData.size()) {
             float sample;
             // Custom fitting based on unique bitDepths
             if (bitDepth == 16) {
-                sample = static_cast<float>(qFromLittleEndian<qint16>(audioData.mid(i, 2).constData())) / 32768.0f;
+                sample = static_cast<float>(qFromLittleEndian<qint16>(data + i)) / 32768.0f;
             } else if (bitDepth == 24) {
+                if (i + 2 >= audioData.size()) break;
                 // Creating an unsigned int here (prepends 0x00)
-                quint32 uInt = qFromLittleEndian<quint32>(audioData.mid(i, 3).constData());
+                quint32 uInt = quint32(data[i]) | (quint32(data[i + 1]) << 8) | (quint32(data[i + 2]) << 16);
 
                 // Sign extending my unsigned int
                 if (uInt & 0x800000) {
@@ -141,7 +208,8 @@ void WavFile::collectAudioSamples(){
 
                 sample = static_cast<float>(static_cast<qint32>(uInt)) / 8388608.0f;
             } else if (bitDepth == 32) {
-                sample = qFromLittleEndian<float>(audioData.mid(i, 4).constData());
+                if (i + 3 >= audioData.size()) break;
+                sample = qFromLittleEndian<float>(data + i);
             } else {
                 qWarning() << "File Error: Invalid Bit Depth";
                 return;
@@ -168,6 +236,10 @@ QByteArray WavFile::getAudioData() const {
     return audioData;
 }
 
+void WavFile::releaseAudioData() {
+    audioData = QByteArray();
+}
+
 QList<float> WavFile::getAudioSamples() const {
     return samples;
 }
@@ -1,6 +1,6 @@
 #ifndef WAVFILE_H
 #define WAVFILE_H
-#include <QtWidgets>
+#include <QtCore>
 
 /*
  * File: wavfile.h
@@ -30,7 +30,11 @@
  *  - 'int getBitDepth() const': Returns the bit depth of the audio file
  *  - 'QByteArray getAudioData() const': Returns the raw audio data as a byte array
  *  - 'QList<float> getAudioSamples() const': Returns the parsed audio samples
- *  - 'bool loadFile()': Loads and processes the WAV file
+ *  - 'void releaseAudioData()': Frees the raw data once the samples are parsed, getAudioData() is empty afterwards
+ *  - 'bool loadFile()': Loads and processes the WAV file, a compressed file is read from its decoded copy in the
+ *    'PcmCache' if it was prepared
+ *  - 'static bool writeFile(const QString &path, const QList<float> &samples, int sampleRate, int channels = 1)': Writes
+ *    interleaved samples as a 32 bit float WAV file that 'loadFile()' reads back unchanged
  *
  * Signals:
  *  - 'void fileLoaded(bool success)': Emits signal after file loaded: indicates success or failure
@@ -39,6 +43,7 @@
  *  - 'bool readHeader(const QByteArray& headerData)': Parses and validates the WAV file header
  *  - 'bool readData()': Validates the size of the audio data chunk
  *  - 'void collectAudioSamples()': Extracts individual audio samples from the raw audio data
+ *  - 'bool loadCachedFile(const QString &cacheFile)': Takes the samples and format from a 'PcmCache' file
  *
  * References:
  */
@@ -57,9 +62,11 @@ public:
     int getBitDepth() const;
     QByteArray getAudioData() const;
     QList<float> getAudioSamples() const;
+    void releaseAudioData();
 
     //loading function to process file
     bool loadFile();
+    static bool writeFile(const QString &path, const QList<float> &samples, int sampleRate, int channels = 1);
 
 signals:
     void fileLoaded(bool success);
@@ -69,6 +76,7 @@ private:
     bool readHeader(const QByteArray& headerData);
     bool readData();
     void collectAudioSamples();
+    bool loadCachedFile(const QString &cacheFile);
 
     //member variables
     QString filePath;
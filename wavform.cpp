@@ -1,9 +1,15 @@
 #include "wavform.h"
 #include "wavfile.h"
+#include "waveformreducer.h"
+#include "tracer.h"
+#include "memorybudget.h"
+#include "workerpool.h"
 #include <QLineSeries>
 #include <QtCharts>
 #include <QtWidgets>
 
+#define MAX_SAMPLES (400 * 51) // if we reach this we stop drawing new samples
+
 /*
  * File: wavform.cpp
  * Description:
@@ -16,16 +22,21 @@
  * Key Methods:
  *  - 'WavForm(int _width, int _height): Constructor initializes the view and scene dimensions and sets up
  *    default properties for the waveform visualization.
- *  - 'uploadAudio()': Creates a 'WavFile' object and sets up its waveform visualizatio with 'audioToChart()'
- *  - 'audioToChart()': Processes audio data and sets up the waveform chart
+ *  - 'uploadAudio()': Creates a 'WavFile' object and reads it on the 'WorkerPool', the parse of a long file no longer
+ *    blocks the GUI. The same task reduces the samples to the columns of the view, 'audioFileRead()' sets up its
+ *    waveform visualizatio with 'audioToChart()' once it is read, the GUI thread only adds the items
+ *  - 'audioToChart()': Sets up the waveform chart from the columns reduced on the 'WorkerPool'
  *  - 'setChart()': Splits audio data into pixel-width length and calculates average, min, max and
- *    RMS values for each sample segment. When the width goes past the samples available in the wav file about (400 * 51),
- *    it switches to max and min and draws a line graph of (400*51*2 (2 for max and min)) points across the given width.
+ *    RMS values for each sample segment with 'WaveformReducer', then draws them with 'drawColumns()'
+ *  - 'drawColumns()': Adds the items of reduced columns to the scene. When the width goes past the samples available
+ *    in the wav file about (400 * 51), it switches to max and min and draws a line graph of (400*51*2 (2 for max and
+ *    min)) points across the given width.
  *  - 'updateChart(int width, int height)': Redraws the chart with updated dimensions, preserving current segments
  *    and interval lines
  *  - 'mousePressEvent()': Maps mouse clicks  for user interactions such as adding scrubber line and setting segment
  *    start and end points
  *  - 'updateScrubberPosition()': Moves the scrubber based on given audio playback position
+ *  - 'moveScrubberLine()': Moves the one scrubber line item, it is only added again after the scene was cleared
  *  - 'getSamples()': Returns list of audio samples currently loaded into the waveform
  *  - 'switchMouseEventControls(bool segmentControlsOn)': Enables segment selection mode when segmentControlsOn is true
  *    allowing the user to add start and end segment lines, and disables segment selection mode if false
@@ -53,70 +64,83 @@ WavForm::WavForm(int _width, int _height): centerOnScrubber(true), viewW(_width)
     setSceneRect(0, 0, viewW, viewH); // Explicitly set scene rect to match view
     //scene.addRect(sceneRect());
     audioFileLoaded = false;
+    budgetEntry = MemoryBudget::add("waveform samples", [this]() {
+        if (!audioFileLoaded) return;
+        audio->releaseAudioData();
+        MemoryBudget::setBytes(budgetEntry, sampleBytes());
+    });
+    connect(&loadWatcher, &QFutureWatcher<WaveformColumns>::finished, this, &WavForm::audioFileRead);
+}
+
+WavForm::~WavForm() {
+    MemoryBudget::remove(budgetEntry);
 }
+
 void WavForm::uploadAudio(QString fName){
 
-    audio = new WavFile(fName);
+    audio.reset(); // the file loaded before, a load of it that is still running keeps its own reference
+    audioFileLoaded = false;
+    MemoryBudget::setBytes(budgetEntry, 0);
     scene.clear();
     scene.update();
     if(startSegment) startSegment = nullptr;
     if(endSegment) endSegment = nullptr;
     scrubberHasBeenDrawn = false;
-    audioToChart();
+
+    // the file is only touched by the worker until it is read, then it becomes 'audio'. The worker reduces it to the
+    // columns of the chart too, a file that could not be read has no samples and gives empty columns
+    runningLoadRequest = ++loadRequest;
+    loadingAudio = std::make_shared<WavFile>(fName);
+    std::shared_ptr<WavFile> file = loadingAudio;
+    int columns = std::min(viewW, MAX_SAMPLES);
+    loadWatcher.setFuture(WorkerPool::run(WorkerPool::Visible, [file, columns]() {
+        file->loadFile();
+        return WaveformReducer::reduce(file->getAudioSamples(), columns);
+    }));
+}
+
+void WavForm::audioFileRead() {
+    if (runningLoadRequest != loadRequest) return; // another file was uploaded meanwhile
+    audio = loadingAudio;
+    loadingAudio.reset();
+    audioToChart(loadWatcher.result());
     audioFileLoaded = true;
+    MemoryBudget::setBytes(budgetEntry, sampleBytes());
     emit audioFileLoadedTrue();
     clearIntervals();
 }
 
-void WavForm::audioToChart(){
-    QList<float> samples;
-
-    //verify we can load in file then get audio samples
-    if(audio->loadFile()) {
-        samples = audio->getAudioSamples();
-    }
-
+void WavForm::audioToChart(const WaveformColumns &columns){
+    //the file was read and reduced by uploadAudio at the width of the view
     chartW = viewW;
     chartH = viewH * 0.95;
-    setChart(samples, chartW, chartH);
+    drawColumns(columns, chartW, chartH);
 
 }
 
 void WavForm::setChart(QList<float> data, int width, int height) {
+    TRACE_SCOPE("WavForm::setChart");
 
     //draw the new chart with given samples in the given window width and height
 
+    // min, max, average and root mean square of the samples under each pixel of width
+    drawColumns(WaveformReducer::reduce(data, std::min(width, MAX_SAMPLES)), width, height);
+}
+
+void WavForm::drawColumns(const WaveformColumns &columns, int width, int height) {
+    TRACE_SCOPE("WavForm::drawColumns");
+
+    //the columns were reduced to min(width, MAX_SAMPLES)
+
     scene.clear();
-    const int MAX_SAMPLES = (400 * 51); //if we reach this we stop drawing new samples
+    scrubberHasBeenDrawn = false; // the scrubber line went with the rest of the scene
     int ogWidth = width; //need to store original width;
     width = std::min(width, MAX_SAMPLES); // whichever is smaller is what we draw to stop at max
 
-    // splits data into samples for each pixel of width
-    int sampleLength = data.length() / width;
-
-    QList<float> avgs = QList<float>(width);
-    QList<float> mins = QList<float>(width);
-    QList<float> maxs = QList<float>(width);
-    QList<float> rms = QList<float>(width);
-
-    // finds max value, min value, average value, and root mean square of each sample
-    for (int i = 0; i < width; ++i) {
-        float sum = 0;
-        float squareSum = 0;
-        float min = 1.0;
-        float max = -1.0;
-        for (int j = 0; j < sampleLength; ++j) {
-            float adjusted = data[j + i * sampleLength];
-            if (adjusted < min) min = adjusted;
-            if (adjusted > max) max = adjusted;
-            sum += abs(adjusted);
-            squareSum += pow(adjusted, 2);
-        }
-        mins[i] = min;
-        maxs[i] = max;
-        avgs[i] = sum / sampleLength;
-        rms[i] = sqrt(squareSum / sampleLength);
-    }
+    const QList<float> &avgs = columns.avgs;
+    const QList<float> &mins = columns.mins;
+    const QList<float> &maxs = columns.maxs;
+    const QList<float> &rms = columns.rms;
 
     if (MAX_SAMPLES != width){
     // visualization: min/max is darkest, then rms, then average. May need to change some placing if the zoom is enough that a sample covers only positive/negative values
@@ -166,13 +190,14 @@ void WavForm::setChart(QList<float> data, int width, int height) {
 }
 
 void WavForm::updateChart(int width, int height){
+    TRACE_SCOPE("WavForm::updateChart");
     //clear old chart and update with the same samples but different width/height
 
     //save the old center point in scene
     QRectF oldViewRect = scene.views()[0]->mapToScene(scene.views()[0]->viewport()->geometry()).boundingRect();
     viewCenterPoint = QPointF((oldViewRect.center().x() / chartW) * width, height/2);
 
-    QList<float> samples = audio->getAudioSamples();
+    QList<float> samples = getSamples();
     scene.clear();
     scene.update();
     scrubberHasBeenDrawn = false;
@@ -256,6 +281,7 @@ void WavForm::mousePressEvent(QMouseEvent *evt) {
 
         }
         emit segmentReady(startSegment && endSegment ? true: false);
+        emit selectionChanged(startSegment ? startSegmentP.x() / chartW : -1.0, endSegment ? endSegmentP.x() / chartW : -1.0);
         if (startSegment && endSegment) {
             float segmentProp = (endSegmentP.x() / chartW) - (startSegmentP.x() / chartW);
             int numSamples = int(audio->getAudioSamples().length() * segmentProp);
@@ -266,12 +292,7 @@ void WavForm::mousePressEvent(QMouseEvent *evt) {
         return;
     }
 
-    if (scrubberHasBeenDrawn) scene.removeItem((QGraphicsItem *) lastLine);
-
-    QPointF *first = new QPointF(x, 0);
-    QPointF *second = new QPointF(x, chartH-1);
-    lastLine = scene.addLine(QLineF(*first, *second), QPen(Qt::black, 3, Qt::SolidLine, Qt::FlatCap));
-    scrubberHasBeenDrawn = true;
+    moveScrubberLine(x, chartH - 1);
 
     double position = x / chartW;
     scrubberRedraw = true;
@@ -285,13 +306,7 @@ void WavForm::updateScrubberPosition(double position) {
 
     double scenePosition = (double) (position * chartW);
 
-    if (scrubberHasBeenDrawn) scene.removeItem((QGraphicsItem *) lastLine);
-
-    QPointF *first = new QPointF(scenePosition, 0);
-    QPointF *second = new QPointF(scenePosition, chartH);
-
-    lastLine = scene.addLine(QLineF(*first, *second), QPen(Qt::black, 3, Qt::SolidLine, Qt::FlatCap));
-    scrubberHasBeenDrawn = true;
+    moveScrubberLine(scenePosition, chartH);
     scene.update();
     if (scrubberRedraw) return;
     else if (centerOnScrubber) centerOn(lastLine);
@@ -301,13 +316,39 @@ void WavForm::updateScrubberPosition(double position) {
 
 }
 
+void WavForm::moveScrubberLine(double x, double bottom) {
+    // the scrubber is one line item that is moved, the old code removed the line and added a new one every timer
+    // tick without deleting the old one, which grew the memory for as long as the audio played
+    QLineF line(QPointF(x, 0), QPointF(x, bottom));
+    if (scrubberHasBeenDrawn) {
+        lastLine->setLine(line);
+    } else {
+        lastLine = scene.addLine(line, QPen(Qt::black, 3, Qt::SolidLine, Qt::FlatCap));
+        lastLine->setZValue(1); // above segment and interval lines added later
+        scrubberHasBeenDrawn = true;
+    }
+}
+
+void WavForm::paintEvent(QPaintEvent *event) {
+    QElapsedTimer timer;
+    timer.start();
+    QGraphicsView::paintEvent(event);
+    lastPaintMilliseconds = timer.nsecsElapsed() / 1.0e6;
+    ++paintCount;
+}
+
+qint64 WavForm::sampleBytes() const {
+    if (!audioFileLoaded) return 0;
+    return audio->getAudioSamples().size() * (qint64) sizeof(float) + audio->getAudioData().size();
+}
+
 void WavForm::changeCenterOnScrubber(Qt::CheckState checkedState){
     if (checkedState == Qt::CheckState::Checked) centerOnScrubber = true;
     else centerOnScrubber = false;
 }
 
  QList<float> WavForm::getSamples(){
-     return audio->getAudioSamples();
+     return audio ? audio->getAudioSamples() : QList<float>();
 }
 
 void WavForm::switchMouseEventControls(bool segmentControlsOn){
@@ -419,6 +460,7 @@ void WavForm::clearIntervals(){
     emit segmentReady(false);
     emit chartInfoReady(false);
     emit clearAllSegmentInfo();
+    emit selectionChanged(-1.0, -1.0);
 
 
 }
@@ -3,7 +3,10 @@
 
 #include <QWidget>
 #include "wavfile.h"
+#include "waveformreducer.h"
 #include <QtCharts>
+#include <QFutureWatcher>
+#include <memory>
 
 /*
  * File: wavform.h
@@ -24,7 +27,9 @@
  *  - 'bool centerOnScrubber': Tracks whether view is centered on the scrubber.
  *  - 'bool audioFileLoaded': Tracks if an audio file was successfully loaded.
  *  - `QGraphicsLineItem *lastLine`: Pointer to the last scrubber line drawn.
- *  - `WavFile *audio`: Pointer to the associated `WavFile` object containing audio data.
+ *  - `std::shared_ptr<WavFile> audio`: The associated `WavFile` object containing audio data, null while a file loads.
+ *  - 'QFutureWatcher<WaveformColumns> loadWatcher', 'int loadRequest': The load of the file on the 'WorkerPool' and
+ *    its columns at the width of the view, a newer upload bumps the request so the load of the file before it is dropped
  *  - `int viewW, viewH`: Dimensions of the `QGraphicsView` widget.
  *  - `int chartW, chartH`: Dimensions of the rendered waveform chart.
  *  - 'bool segmentControls': Tracks whether the user is in segment control mode to initiate start/end line selection.
@@ -36,13 +41,20 @@
  *
  * Public Methods:
  *  - `explicit WavForm(int _width, int _height)`: Constructor initializing the view dimensions.
- *  - `void audioToChart()`: Loads audio data from the `WavFile` and creates a waveform visualization.
+ *  - `void audioToChart(const WaveformColumns &columns)`: Creates the waveform visualization of the loaded `WavFile`
+ *    from its columns, reduced with it on the `WorkerPool`.
  *  - `void setChart(QList<float> data, int width, int height)`: Draws the waveform using audio sample data.
+ *  - `void drawColumns(const WaveformColumns &columns, int width, int height)`: Draws the waveform from columns
+ *    already reduced to the width (at most 400 * 51 of them).
  *  - 'QList<float> getSamples()': Gets audio samples currently displayed in waveform.
  *  - 'void updateDelta(double delta)': Updates delta which calculates spacing between interval lines in segment selections.
+ *  - 'qint64 sampleBytes() const': Bytes held by the raw data and the samples of the loaded 'WavFile', also reported to
+ *    the 'MemoryBudget', which may evict the raw data (nothing reads it after the samples are parsed)
+ *  - 'int sceneItemCount() const', 'double getLastPaintMilliseconds() const', 'int getPaintCount() const': For the
+ *    performance HUD
  *
  * Slots:
- *  - `void uploadAudio(QString fName)`: Loads a WAV file and generates its waveform visualization.
+ *  - `void uploadAudio(QString fName)`: Starts loading a WAV file off the GUI thread, the waveform is drawn once it is read.
  *  - `void updateScrubberPosition(double position)`: Updates the scrubber position based on a relative position.
  *  - `void updateChart(int width, int height)`: Redraws the chart to fit new dimensions.
  *  - 'void switchMouseEventControls(bool segmentControlsOn)': Enables or disables segment control mode.
@@ -52,13 +64,16 @@
  * Signals:
  *  - `void sendAudioPosition(double position)`: Emitted when the scrubber position changes.
  *  - `void sceneSizeChange()`: Emmited when scene size has been changed.
- *  - 'void audioFileLoadedTrue()': Emitted when an audio file is loaded.
+ *  - 'void audioFileLoadedTrue()': Emitted when an audio file is loaded and drawn.
  *  - 'void segmentReady(bool ready)': Emitted when start and end segment lines are declared.
  *  - 'void intervalsForSegments(QList<int> intervalLocations)': Emits a list of audio sample indices for interval lines.
  *  - 'void chartInfoReady(bool ready)': Emitted when segment selections and intervals lines are defined or cleared.
+ *  - 'void selectionChanged(double startProportion, double endProportion)': Emitted when a segment line is placed or
+ *    cleared, with the lines as proportions of the chart width, -1 for a line that is not placed
  *
  * Protected Methods:
  *  - `void mousePressEvent(QMouseEvent *evt) override`: Handles user interaction for updating the scrubber and segment lines.
+ *  - 'void paintEvent(QPaintEvent *event) override': Paints the view and keeps how long it took
  *
  * Notes:
  *  - The waveform is visualized using properties of audio samples from 'WavFile'
@@ -75,7 +90,12 @@ class WavForm : public QGraphicsView
     bool centerOnScrubber;
     bool audioFileLoaded;
     QGraphicsLineItem *lastLine;
-    WavFile *audio;
+    std::shared_ptr<WavFile> audio;
+    QFutureWatcher<WaveformColumns> loadWatcher;
+    int loadRequest = 0;
+    int runningLoadRequest = -1;
+    std::shared_ptr<WavFile> loadingAudio;
+    int budgetEntry;
     int viewW;
     int viewH;
     int chartW;
@@ -93,13 +113,23 @@ class WavForm : public QGraphicsView
     void updateIntervals(int oldChartWidth);
     QPointF viewCenterPoint;
     bool scrubberRedraw;
+    double lastPaintMilliseconds = 0.0;
+    int paintCount = 0;
+    void moveScrubberLine(double x, double bottom);
+    void audioFileRead();
 
 public:
     explicit WavForm(int _width, int _height);
-    void audioToChart();
+    ~WavForm();
+    void audioToChart(const WaveformColumns &columns);
     void setChart(QList<float> data, int width, int height);
+    void drawColumns(const WaveformColumns &columns, int width, int height);
     QList<float> getSamples();
     void updateDelta(double delta);
+    qint64 sampleBytes() const;
+    int sceneItemCount() const { return scene.items().size(); }
+    double getLastPaintMilliseconds() const { return lastPaintMilliseconds; }
+    int getPaintCount() const { return paintCount; }
 public slots:
     void uploadAudio(QString fName);
     void updateScrubberPosition(double position);
@@ -115,6 +145,7 @@ public slots:
 
 protected:
     void mousePressEvent(QMouseEvent *evt) override;
+    void paintEvent(QPaintEvent *event) override;
 
 signals:
     void sendAudioPosition(double position);
@@ -126,6 +157,7 @@ signals:
     void chartInfoReady(bool ready);
     void clearAllSegmentInfo();
     void clearEnable(bool enable);
+    void selectionChanged(double startProportion, double endProportion);
 };
 
 #endif // WAVFORM_H
@@ -0,0 +1,12 @@
+#include "workerpool.h"
+
+/*
+ * File: workerpool.cpp
+ * Description:
+ *  This source file implements the 'WorkerPool'. The pool is Qt's global one: it is already bounded to
+ *  QThread::idealThreadCount() threads, and the batch tool can still size it with --threads.
+ */
+
+QThreadPool *WorkerPool::instance() {
+    return QThreadPool::globalInstance();
+}
@@ -0,0 +1,50 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <utility>
+
+/*
+ * File: workerpool.h
+ * Description:
+ *  This header file defines the 'WorkerPool' class, the one bounded thread pool every track's analyses run on. Tasks
+ *  carry the priority of the track they belong to, so with many tracks loaded the visible ones and the learner's are
+ *  taken off the queue before the tracks that are scrolled away.
+ *
+ * Public Methods:
+ *  - 'static QThreadPool *instance()': The shared pool, QThreadPool::globalInstance(), which holds at most
+ *    QThread::idealThreadCount() threads. The blockingMap calls inside the trackers use the same pool, so the batches
+ *    of a track never compete with a separate pool for the cores
+ *  - 'static QFuture<T> run(int priority, Function function)': Queues the function on the shared pool with the priority
+ *    and returns its future, like QtConcurrent::run
+ *
+ * Notes:
+ *  - Priorities only order the queue, a running task is never preempted. Higher runs first.
+ *  - Decoding compressed files still waits on the 'PcmCache' decode pool (its threads sit in event loops), it takes the
+ *    same priorities.
+ *
+ * References:
+ *  - https://doc.qt.io/qt-6/qtconcurrenttask.html
+ */
+
+class WorkerPool
+{
+public:
+    enum Priority
+    {
+        Background = 0, // prefetching for tracks that were never shown
+        Hidden = 1, // built tracks that are scrolled away
+        Visible = 2,
+        Learner = 3 // the user's own attempt
+    };
+
+    static QThreadPool *instance();
+
+    template <typename Function>
+    static auto run(int priority, Function &&function) {
+        return QtConcurrent::task(std::forward<Function>(function)).onThreadPool(*instance()).withPriority(priority).spawn();
+    }
+};
+
+#endif // WORKERPOOL_H
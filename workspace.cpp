@@ -0,0 +1,117 @@
+#include "workspace.h"
+#include <QScrollBar>
+#include <QTimer>
+#include "pcmcache.h"
+#include "workerpool.h"
+#include "tracer.h"
+
+/*
+ * File: workspace.cpp
+ * Description:
+ *  This source file implements the 'Workspace'. 'updateTracks()' runs whenever the scroll position or the size of the
+ *  viewport changes and after tracks are added or built (the layout has moved by then, so it is queued). A placeholder
+ *  counts as in view if it is within one viewport height of the visible area, so a track is usually built just before
+ *  it is scrolled to.
+ *
+ * Key Methods:
+ *  - 'addTrack()': Inserts the placeholder above the stretch at the end of the list, starts the background decode of a
+ *    compressed file that was never decoded
+ *  - 'build()': Replaces the placeholder with the 'Audio' and 'Spectrograph' of the track, wires them like the two tracks
+ *    of the main window always were, and loads the pending file. When the 'MemoryBudget' evicts the spectrogram frames
+ *    the copy of the segmenter is dropped with them, and sent again when syllable segmenting asks for it
+ *  - 'updateTracks()': Priorities are Learner for the user's track, Visible for the tracks in view, Hidden for the rest
+ */
+
+#define TRACK_PLACEHOLDER_HEIGHT 520
+
+Workspace::Workspace(QWidget *parent)
+    : QScrollArea(parent)
+{
+    QWidget *center = new QWidget();
+    tracksLayout = new QVBoxLayout(center);
+    tracksLayout->addStretch();
+    setWidget(center);
+    setWidgetResizable(true);
+
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &Workspace::updateTracks);
+}
+
+int Workspace::addTrack(const QString &name, int deviceNumber, const QUrl &file) {
+    Track track;
+    track.name = name;
+    track.deviceNumber = deviceNumber;
+    track.pendingFile = file;
+    track.slot = new QWidget();
+    track.slotLayout = new QVBoxLayout(track.slot);
+    track.slotLayout->setContentsMargins(0, 0, 0, 0);
+    track.placeholder = new QLabel(name + " (scroll to load)");
+    track.placeholder->setAlignment(Qt::AlignCenter);
+    track.placeholder->setFixedHeight(TRACK_PLACEHOLDER_HEIGHT);
+    track.slotLayout->addWidget(track.placeholder);
+    tracksLayout->insertWidget(tracks.size(), track.slot);
+    tracks.append(track);
+
+    // the slow part of a compressed file can start before the track is built, finding an earlier decode hashes the
+    // whole file so that is left to the worker too
+    QString fileName = file.toLocalFile();
+    if (!fileName.isEmpty() && PcmCache::isCompressed(fileName)) {
+        PcmCache::prepare(fileName, WorkerPool::Background);
+    }
+
+    QTimer::singleShot(0, this, &Workspace::updateTracks);
+    return tracks.size() - 1;
+}
+
+void Workspace::ensureBuilt(int index) {
+    if (!tracks[index].audio) build(index);
+}
+
+void Workspace::build(int index) {
+    TRACE_SCOPE("Workspace::build");
+    Track &track = tracks[index];
+    delete track.placeholder;
+    track.placeholder = nullptr;
+
+    track.audio = new Audio(nullptr, track.name, track.deviceNumber);
+    track.slotLayout->addWidget(track.audio);
+    track.spectrograph = new Spectrograph();
+    track.slotLayout->addWidget(track.spectrograph, 0, Qt::AlignRight);
+    connect(track.audio, &Audio::audioFileSelected, track.spectrograph, &Spectrograph::loadAudioFile);
+    connect(track.spectrograph, &Spectrograph::spectralFramesReady, track.audio, &Audio::setSpectralFrames);
+    Audio *audio = track.audio;
+    connect(track.spectrograph, &Spectrograph::spectralFramesEvicted, audio, [audio]() { audio->setSpectralFrames(SpectralFrames()); });
+    connect(track.audio, &Audio::spectralFramesNeeded, track.spectrograph, &Spectrograph::provideSpectralFrames);
+    connect(track.audio, &Audio::audioPositionChanged, track.spectrograph, &Spectrograph::setCursorPosition);
+    connect(track.audio, &Audio::selectionChanged, track.spectrograph, &Spectrograph::setSelection);
+    if (track.deviceNumber == 1) track.spectrograph->setPriority(WorkerPool::Learner);
+
+    emit trackBuilt(index);
+
+    QUrl file = track.pendingFile;
+    track.pendingFile.clear();
+    if (!file.isEmpty()) track.audio->loadAudio(file);
+    QTimer::singleShot(0, this, &Workspace::updateTracks); // the tracks below moved
+}
+
+bool Workspace::isNearView(int index) const {
+    int top = verticalScrollBar()->value();
+    int height = viewport()->height();
+    QRect nearView(0, top - height, viewport()->width(), 3 * height);
+    return tracks[index].slot->geometry().intersects(nearView);
+}
+
+void Workspace::updateTracks() {
+    if (!isVisible()) return; // placeholders have no geometry yet, the resize on show comes back here
+    for (int i = 0; i < tracks.size(); ++i) {
+        bool near = isNearView(i);
+        if (near && !tracks[i].audio) build(i);
+        if (tracks[i].spectrograph && tracks[i].deviceNumber != 1) {
+            tracks[i].spectrograph->setPriority(near ? WorkerPool::Visible : WorkerPool::Hidden);
+        }
+    }
+}
+
+void Workspace::resizeEvent(QResizeEvent *event) {
+    QScrollArea::resizeEvent(event);
+    updateTracks();
+}
@@ -0,0 +1,87 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <QScrollArea>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QUrl>
+#include "audio.h"
+#include "spectrograph.h"
+
+/*
+ * File: workspace.h
+ * Description:
+ *  This header file defines the 'Workspace' class, the scrollable list of tracks in the main window: the reference
+ *  speaker, the user's attempt and any number of further speakers. A track is a fixed height placeholder until it
+ *  scrolls into view, only then are its 'Audio' and 'Spectrograph' built and its file loaded, so opening ten recordings
+ *  does not build and decode ten tracks at once.
+ *
+ * Key Members:
+ *  - 'QVector<Track> tracks': Name, device number, slot widget and, once built, the widgets of every track
+ *
+ * Public Methods:
+ *  - 'int addTrack(const QString &name, int deviceNumber, const QUrl &file = QUrl())': Appends a placeholder and
+ *    returns the index of the track. The file is loaded once the track is built, a compressed one is already decoded
+ *    into the 'PcmCache' in the background
+ *  - 'void ensureBuilt(int index)': Builds the track now, wherever it is
+ *  - 'int trackCount() const', 'QString trackName(int index) const'
+ *  - 'Audio *audio(int index) const', 'Spectrograph *spectrograph(int index) const': The widgets of a track, null until it
+ *    is built
+ *
+ * Slots:
+ *  - 'void updateTracks()': Builds the tracks within a viewport of the visible area and gives every built track the
+ *    'WorkerPool' priority for where it is
+ *
+ * Signals:
+ *  - 'void trackBuilt(int index)': The widgets of a track were just built, emitted before its file starts loading
+ *
+ * Notes:
+ *  - The device number is passed on to 'Audio': 0 is the reference speaker, 1 the user (record button, learner
+ *    priority), further speakers use 2.
+ *
+ * References:
+ *  - https://doc.qt.io/qt-6/qscrollarea.html
+ */
+
+class Workspace : public QScrollArea
+{
+    Q_OBJECT
+
+    struct Track
+    {
+        QString name;
+        int deviceNumber = 0;
+        QUrl pendingFile;
+        QWidget *slot = nullptr;
+        QVBoxLayout *slotLayout = nullptr;
+        QLabel *placeholder = nullptr;
+        Audio *audio = nullptr;
+        Spectrograph *spectrograph = nullptr;
+    };
+
+    QVector<Track> tracks;
+    QVBoxLayout *tracksLayout;
+
+    void build(int index);
+    bool isNearView(int index) const;
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+
+public:
+    explicit Workspace(QWidget *parent = nullptr);
+    int addTrack(const QString &name, int deviceNumber, const QUrl &file = QUrl());
+    void ensureBuilt(int index);
+    int trackCount() const { return tracks.size(); }
+    QString trackName(int index) const { return tracks[index].name; }
+    Audio *audio(int index) const { return tracks[index].audio; }
+    Spectrograph *spectrograph(int index) const { return tracks[index].spectrograph; }
+
+public slots:
+    void updateTracks();
+
+signals:
+    void trackBuilt(int index);
+};
+
+#endif // WORKSPACE_H